@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include "SharedMemory.hpp"
+#include "../utils/execTrace.h"
+
+// Decorador de SharedMemory para --capture: reenvía cada acceso del PE a la memoria real
+// (normalmente su MemoryFacade) y lo registra en la traza de ejecución. El registro se
+// escribe cuando el acceso ya se completó (el dato de un load y su latencia se conocen
+// recién entonces): al emitirse el siguiente acceso del PE o con flush() al terminar.
+// Como el PE no emite otro acceso hasta completar el anterior, guarda uno solo.
+class CaptureMemory : public SharedMemory {
+public:
+    CaptureMemory(SharedMemory* inner, ExecTraceWriter* writer, unsigned peId)
+        : m_inner(inner), m_writer(writer), m_peId(peId) {}
+    ~CaptureMemory() override { flush(); }
+
+    CaptureMemory(const CaptureMemory&) = delete;
+    CaptureMemory& operator=(const CaptureMemory&) = delete;
+
+    MemRequestHandle issueLoad(uint64_t address, uint32_t pc) override {
+        flush();
+        const uint64_t sequence = m_writer->next_sequence();
+        MemRequestHandle req = m_inner->issueLoad(address, pc);
+        track(req, pc, sequence);
+        return req;
+    }
+    MemRequestHandle issueStore(uint64_t address, uint64_t value, uint32_t pc) override {
+        flush();
+        const uint64_t sequence = m_writer->next_sequence();
+        MemRequestHandle req = m_inner->issueStore(address, value, pc);
+        track(req, pc, sequence);
+        return req;
+    }
+
+    MemRequestHandle issueVectorLoad(uint64_t address, uint32_t pc) override {
+        flush();
+        const uint64_t sequence = m_writer->next_sequence();
+        MemRequestHandle req = m_inner->issueVectorLoad(address, pc);
+        track(req, pc, sequence);
+        return req;
+    }
+    MemRequestHandle issueVectorStore(uint64_t address, const uint64_t* lanes, uint32_t pc) override {
+        flush();
+        const uint64_t sequence = m_writer->next_sequence();
+        MemRequestHandle req = m_inner->issueVectorStore(address, lanes, pc);
+        track(req, pc, sequence);
+        return req;
+    }
+
+    // Registra el último acceso; llamar al terminar la simulación, antes de cerrar el writer
+    void flush() {
+        if (!m_last) return;
+        ExecRecord record{};
+        record.sequence = m_lastSequence;
+        record.cycle = m_last->issueCycle;
+        record.address = m_last->address;
+        // Un VLOAD/VSTORE queda como un acceso a su línea con el primer carril como dato
+        record.value = m_last->vector ? m_last->lanes[0] : m_last->value;
+        record.pc = m_lastPc;
+        record.latency = m_last->done ? static_cast<uint32_t>(m_last->latency()) : 0;
+        record.pe = static_cast<uint8_t>(m_peId);
+        record.write = m_last->kind == MemRequest::Kind::STORE;
+        m_writer->append(record);
+        m_last.reset();
+    }
+
+private:
+    SharedMemory* m_inner;
+    ExecTraceWriter* m_writer;
+    unsigned m_peId;
+    MemRequestHandle m_last; // último acceso emitido, aún sin registrar
+    uint32_t m_lastPc{0};
+    uint64_t m_lastSequence{0};
+
+    void track(const MemRequestHandle& req, uint32_t pc, uint64_t sequence) {
+        m_last = req;
+        m_lastPc = pc;
+        m_lastSequence = sequence;
+    }
+};
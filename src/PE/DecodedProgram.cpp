@@ -0,0 +1,135 @@
+#include "DecodedProgram.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+uint8_t checkReg(int reg, size_t regCount, size_t index) {
+    if (reg < 0 || static_cast<size_t>(reg) >= regCount) {
+        throw std::invalid_argument("decodeProgram: instruccion " + std::to_string(index) +
+                                    ": registro fuera de rango (" + std::to_string(reg) + ")");
+    }
+    return static_cast<uint8_t>(reg);
+}
+
+// Cantidad de registros válida para cada operando: los vectoriales usan V0..VREG_COUNT-1
+struct OperandLimits {
+    size_t rd, ra, rb;
+};
+
+OperandLimits operandLimits(uint8_t op, size_t regCount) {
+    switch (static_cast<OpCode>(op)) {
+        case OpCode::VLOAD:
+        case OpCode::VSTORE:
+        case OpCode::VBCAST:
+            return {VREG_COUNT, regCount, regCount};
+        case OpCode::VADD:
+        case OpCode::VMUL:
+        case OpCode::VFMA:
+            return {VREG_COUNT, VREG_COUNT, VREG_COUNT};
+        case OpCode::VREDUCE:
+            return {regCount, VREG_COUNT, regCount};
+        default:
+            return {regCount, regCount, regCount};
+    }
+}
+
+} // namespace
+
+std::vector<DecodedInstruction> decodeProgram(const std::vector<Instruction>& program, size_t regCount) {
+    std::vector<DecodedInstruction> code;
+    code.reserve(program.size());
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Instruction& inst = program[i];
+        DecodedInstruction d;
+        d.op = static_cast<uint8_t>(inst.op);
+        switch (inst.op) {
+            case OpCode::LOAD:
+            case OpCode::STORE:
+                d.rd = checkReg(inst.rd, regCount, i);
+                d.imm = inst.addr;
+                break;
+            case OpCode::FMUL:
+            case OpCode::FADD:
+            case OpCode::ADD:
+                d.rd = checkReg(inst.rd, regCount, i);
+                d.ra = checkReg(inst.ra, regCount, i);
+                d.rb = checkReg(inst.rb, regCount, i);
+                break;
+            case OpCode::INC:
+            case OpCode::DEC:
+                d.rd = checkReg(inst.rd, regCount, i);
+                break;
+            case OpCode::MOVI:
+            case OpCode::ADDI:
+                d.rd = checkReg(inst.rd, regCount, i);
+                d.imm = inst.addr;
+                break;
+            case OpCode::LOADR:
+            case OpCode::STORER:
+                d.rd = checkReg(inst.rd, regCount, i);
+                d.ra = checkReg(inst.ra, regCount, i);
+                break;
+            case OpCode::VLOAD:
+            case OpCode::VSTORE:
+            case OpCode::VBCAST:
+                d.rd = checkReg(inst.rd, VREG_COUNT, i);
+                d.ra = checkReg(inst.ra, regCount, i);
+                break;
+            case OpCode::VADD:
+            case OpCode::VMUL:
+            case OpCode::VFMA:
+                d.rd = checkReg(inst.rd, VREG_COUNT, i);
+                d.ra = checkReg(inst.ra, VREG_COUNT, i);
+                d.rb = checkReg(inst.rb, VREG_COUNT, i);
+                break;
+            case OpCode::VREDUCE:
+                d.rd = checkReg(inst.rd, regCount, i);
+                d.ra = checkReg(inst.ra, VREG_COUNT, i);
+                break;
+            case OpCode::JNZ:
+                if (inst.target >= program.size()) {
+                    throw std::invalid_argument("decodeProgram: instruccion " + std::to_string(i) +
+                                                ": destino de salto fuera del programa");
+                }
+                d.target = static_cast<uint32_t>(inst.target);
+                break;
+            case OpCode::HALT:
+                break;
+            default:
+                throw std::invalid_argument("decodeProgram: instruccion " + std::to_string(i) + ": opcode desconocido");
+        }
+        code.push_back(d);
+    }
+    return code;
+}
+
+void validateDecoded(const DecodedInstruction* code, size_t count, size_t regCount) {
+    for (size_t i = 0; i < count; ++i) {
+        const DecodedInstruction& d = code[i];
+        if (d.op >= OPCODE_COUNT) {
+            throw std::invalid_argument("validateDecoded: instruccion " + std::to_string(i) + ": opcode desconocido");
+        }
+        const OperandLimits limits = operandLimits(d.op, regCount);
+        checkReg(d.rd, limits.rd, i);
+        checkReg(d.ra, limits.ra, i);
+        checkReg(d.rb, limits.rb, i);
+        if (d.op == static_cast<uint8_t>(OpCode::JNZ) && d.target >= count) {
+            throw std::invalid_argument("validateDecoded: instruccion " + std::to_string(i) +
+                                        ": destino de salto fuera del programa");
+        }
+    }
+}
+
+uint64_t programFingerprint(const DecodedInstruction* code, size_t count) {
+    // FNV-1a por palabras de 64 bits: la instrucción no tiene relleno (16 bytes exactos)
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t words[2];
+        std::memcpy(words, &code[i], sizeof(words));
+        hash = (hash ^ words[0]) * 1099511628211ULL;
+        hash = (hash ^ words[1]) * 1099511628211ULL;
+    }
+    return hash;
+}
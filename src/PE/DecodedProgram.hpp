@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Instruction.hpp"
+
+// Instrucción pre-decodificada: operandos resueltos y validados una sola vez al
+// cargar el programa, para que el intérprete no vuelva a comprobarlos.
+struct DecodedInstruction {
+    uint8_t op;       // static_cast<uint8_t>(OpCode): índice en la tabla de despacho
+    uint8_t rd{0};
+    uint8_t ra{0};
+    uint8_t rb{0};
+    uint32_t target{0}; // JNZ: índice de instrucción destino (ya verificado)
+    uint64_t imm{0};    // dirección absoluta (LOAD/STORE) o inmediato (MOVI/ADDI)
+};
+// Es también el formato de las imágenes .pecb (ProgramImage): no cambiar sin subir su versión
+static_assert(sizeof(DecodedInstruction) == 16, "DecodedInstruction debe medir 16 bytes");
+
+constexpr size_t OPCODE_COUNT = static_cast<size_t>(OpCode::VBCAST) + 1;
+
+inline bool isMemoryOp(uint8_t op) {
+    return op == static_cast<uint8_t>(OpCode::LOAD) || op == static_cast<uint8_t>(OpCode::STORE) ||
+           op == static_cast<uint8_t>(OpCode::LOADR) || op == static_cast<uint8_t>(OpCode::STORER) ||
+           op == static_cast<uint8_t>(OpCode::VLOAD) || op == static_cast<uint8_t>(OpCode::VSTORE);
+}
+
+// Valida registros (0..regCount-1; V0..VREG_COUNT-1 en los operandos vectoriales) y
+// destinos de salto de cada instrucción.
+// Lanza std::invalid_argument indicando la instrucción inválida.
+std::vector<DecodedInstruction> decodeProgram(const std::vector<Instruction>& program, size_t regCount);
+
+// Verifica un programa ya decodificado (p. ej. leído de una imagen) sin copiarlo: opcode
+// conocido, registros (escalares y vectoriales) en rango y destinos de salto dentro del programa.
+// Lanza std::invalid_argument indicando la instrucción inválida.
+void validateDecoded(const DecodedInstruction* code, size_t count, size_t regCount);
+
+// Huella FNV-1a de un programa decodificado (checkpoints y checksum de las imágenes .pecb)
+uint64_t programFingerprint(const DecodedInstruction* code, size_t count);
@@ -3,11 +3,24 @@
 #include <cstdint>
 
 enum class OpCode { LOAD, STORE, FMUL, FADD, INC, DEC, JNZ, HALT,
-    MOVI, ADDI, ADD, LOADR, STORER };
+    MOVI, ADDI, ADD, LOADR, STORER,
+    // Vectoriales: V0-V7 de VECTOR_LANES doubles (una línea de 32 B)
+    VLOAD,   // VLOAD Vd, Ra       Vd <- Mem[Ra .. Ra+31] (Ra alineada a 32)
+    VSTORE,  // VSTORE Vs, Ra      Mem[Ra .. Ra+31] <- Vs
+    VADD,    // VADD Vd, Va, Vb
+    VMUL,    // VMUL Vd, Va, Vb
+    VFMA,    // VFMA Vd, Va, Vb    Vd <- Va * Vb + Vd (un solo redondeo)
+    VREDUCE, // VREDUCE Rd, Va     Rd <- (Va0 + Va1) + (Va2 + Va3)
+    VBCAST   // VBCAST Vd, Ra      cada carril de Vd <- Ra (double)
+};
+
+constexpr unsigned VECTOR_LANES = 4;                    // doubles por registro vectorial
+constexpr unsigned VECTOR_BYTES = VECTOR_LANES * 8;     // lo que mueve VLOAD/VSTORE
+constexpr size_t VREG_COUNT = 8;                        // V0 - V7
 
 struct Instruction {
     OpCode op;
-    int rd{-1};   // destination or source (STORE/STORER use rd as store source)
+    int rd{-1};   // destination or source (STORE/STORER use rd as store source); vector ops index V registers
     int ra{-1};   // source A / address register (LOADR uses ra, STORER uses ra for address)
     int rb{-1};   // source B
     uint64_t addr{0}; // memory address OR immediate (for MOVI/ADDI) OR jump target resolution value
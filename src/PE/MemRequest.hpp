@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "Instruction.hpp"
+
+// Petición de acceso a memoria emitida por un PE (handle de completitud).
+// El PE queda detenido hasta que la petición se completa; en ese momento se
+// invoca onComplete con el dato leído y el ciclo de finalización ya registrados.
+struct MemRequest {
+    enum class Kind { LOAD, STORE };
+
+    Kind kind;
+    uint64_t address;
+    uint64_t value{0};         // dato leído (LOAD) o dato a escribir (STORE)
+    bool vector{false};        // VLOAD/VSTORE: el dato son las VECTOR_LANES palabras de lanes
+    uint64_t lanes[VECTOR_LANES]{};
+    uint64_t issueCycle{0};
+    uint64_t completeCycle{0};
+    bool done{false};
+    std::function<void(MemRequest&)> onComplete;
+
+    MemRequest(Kind k, uint64_t addr, uint64_t val = 0) : kind(k), address(addr), value(val) {}
+
+    void complete(uint64_t cycle) {
+        done = true;
+        completeCycle = cycle;
+        if (onComplete) onComplete(*this);
+    }
+
+    uint64_t latency() const { return completeCycle - issueCycle; }
+};
+
+using MemRequestHandle = std::shared_ptr<MemRequest>;
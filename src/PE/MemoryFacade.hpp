@@ -1,40 +1,159 @@
 #ifndef MEMORY_FACADE_HPP
 #define MEMORY_FACADE_HPP
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include "../components/cacheL1.h"
 #include "../interconnect/BusInterconnect.h"
 #include "SharedMemory.hpp"
+#include "../utils/trace.h"
 
+// Conecta un PE con su CacheL1. Primero consulta el estado local de la línea:
+// - load con la línea válida (M/O/E/S/F) o store con la línea en M/E: acierto local,
+//   el handle vuelve completo sin transacción de Bus (E->M es silencioso);
+// - store a una línea compartida (S/F/O): ya tiene el dato, emite un BusUpgr (INVALIDATE);
+// - en otro caso emite BusRd/BusRdX y se completa cuando el Bus ya hizo snooping y
+//   entregó la línea con load_block_from_bus.
+// VLOAD/VSTORE siguen las mismas reglas con la línea entera como un solo acceso.
+// Cada acceso se informa al prefetcher de la caché (si tiene); las líneas que propone
+// y que no están presentes ni en vuelo se emiten como BusRd de prefetch (baja prioridad).
 class MemoryFacade : public SharedMemory {
 public:
     MemoryFacade(CacheL1* cache, BusInterconnect* bus, int pe_id)
         : cache_(cache), bus_(bus), pe_id_(pe_id) {}
     ~MemoryFacade() = default;
 
-    uint64_t load(uint64_t addr) override{
-        bus_->add_request(BusTransaction(pe_id_, BusCommand::BUS_READ, addr));
-        uint64_t val = cache_->read(addr);
-        std::cout << "[MemoryFacade PE " << pe_id_ << "] Load 64b @ 0x" << std::hex << addr << std::dec << " = " << val << std::endl;
-        load_counter_++;
-        return val;
+    MemRequestHandle issueLoad(uint64_t addr, uint32_t pc) override {
+        return load(std::make_shared<MemRequest>(MemRequest::Kind::LOAD, addr), pc);
     }
-    void store(uint64_t addr, uint64_t val) override {
-        std::cout << "[MemoryFacade PE " << pe_id_ << "] Store 64b @ 0x" << std::hex << addr << std::dec << " = " << val << std::endl;
-        bus_->add_request(BusTransaction(pe_id_, BusCommand::BUS_READ_X, addr));
-        cache_->write(addr, val); // nuevo método
-        store_counter_++;
+    MemRequestHandle issueStore(uint64_t addr, uint64_t val, uint32_t pc) override {
+        return store(std::make_shared<MemRequest>(MemRequest::Kind::STORE, addr, val), pc);
+    }
+    // Una línea entera es un solo acceso: una sola transacción de Bus si falla
+    MemRequestHandle issueVectorLoad(uint64_t addr, uint32_t pc) override {
+        check_vector_access(addr);
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::LOAD, addr);
+        req->vector = true;
+        return load(req, pc);
+    }
+    MemRequestHandle issueVectorStore(uint64_t addr, const uint64_t* lanes, uint32_t pc) override {
+        check_vector_access(addr);
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::STORE, addr, lanes[0]);
+        req->vector = true;
+        std::copy(lanes, lanes + VECTOR_LANES, req->lanes);
+        return store(req, pc);
     }
 
     int getLoadCount() const { return load_counter_; }
     int getStoreCount() const { return store_counter_; }
+    int getLocalHitCount() const { return local_hit_counter_; } // accesos resueltos sin el Bus
     int getPEId() const { return pe_id_; }
 
 private:
+    MemRequestHandle load(MemRequestHandle req, uint32_t pc) {
+        const uint64_t addr = req->address;
+        req->issueCycle = bus_->now();
+        const bool hit = cache_->get_line_state(addr) != MESI_State::INVALID;
+        const std::vector<uint64_t>& prefetches = cache_->on_demand_access(addr, pc, hit);
+        if (hit) {
+            read_line(*req, false); // acierto: contabiliza el hit y actualiza el reemplazo
+            MESI_TRACE(TraceEvent::FACADE_LOAD, pe_id_, addr, traced_value(*req));
+            load_counter_++;
+            local_hit_counter_++;
+            req->complete(bus_->now());
+            issue_prefetches(prefetches);
+            return req;
+        }
+        BusTransaction transaction(pe_id_, BusCommand::BUS_READ, addr);
+        transaction.on_complete = [this, req]() {
+            read_line(*req, true);
+            MESI_TRACE(TraceEvent::FACADE_LOAD, pe_id_, req->address, traced_value(*req));
+            load_counter_++;
+            req->complete(bus_->now());
+        };
+        bus_->add_request(transaction);
+        issue_prefetches(prefetches);
+        return req;
+    }
+
+    MemRequestHandle store(MemRequestHandle req, uint32_t pc) {
+        const uint64_t addr = req->address;
+        req->issueCycle = bus_->now();
+        const MESI_State state = cache_->get_line_state(addr);
+        const std::vector<uint64_t>& prefetches =
+            cache_->on_demand_access(addr, pc, state != MESI_State::INVALID);
+        if (state == MESI_State::MODIFIED || state == MESI_State::EXCLUSIVE) {
+            // Único dueño: escribe sin avisar al Bus (E->M silencioso)
+            MESI_TRACE(TraceEvent::FACADE_STORE, pe_id_, addr, traced_value(*req));
+            write_line(*req, false);
+            store_counter_++;
+            local_hit_counter_++;
+            req->complete(bus_->now());
+            issue_prefetches(prefetches);
+            return req;
+        }
+        const bool upgrade = state == MESI_State::SHARED || state == MESI_State::FORWARD ||
+                             state == MESI_State::OWNED;
+        BusTransaction transaction(pe_id_, upgrade ? BusCommand::INVALIDATE : BusCommand::BUS_READ_X, addr);
+        transaction.on_complete = [this, req]() {
+            MESI_TRACE(TraceEvent::FACADE_STORE, pe_id_, req->address, traced_value(*req));
+            write_line(*req, true);
+            store_counter_++;
+            req->complete(bus_->now());
+        };
+        bus_->add_request(transaction);
+        issue_prefetches(prefetches);
+        return req;
+    }
+
+    // filled: la línea la acaba de entregar el Bus (el hit/miss ya se contabilizó)
+    void read_line(MemRequest& req, bool filled) {
+        if (req.vector) {
+            if (filled) cache_->read_filled_words(req.address, req.lanes, VECTOR_LANES);
+            else cache_->read_words(req.address, req.lanes, VECTOR_LANES);
+        } else {
+            req.value = filled ? cache_->read_filled(req.address) : cache_->read(req.address);
+        }
+    }
+    void write_line(const MemRequest& req, bool filled) {
+        if (req.vector) {
+            if (filled) cache_->write_filled_words(req.address, req.lanes, VECTOR_LANES);
+            else cache_->write_words(req.address, req.lanes, VECTOR_LANES);
+        } else if (filled) {
+            cache_->write_filled(req.address, req.value);
+        } else {
+            cache_->write(req.address, req.value);
+        }
+    }
+    // Las trazas guardan una palabra: el primer carril de un acceso vectorial
+    static uint64_t traced_value(const MemRequest& req) { return req.vector ? req.lanes[0] : req.value; }
+
+    void check_vector_access(uint64_t addr) const {
+        if (addr % VECTOR_BYTES != 0 || addr % cache_->line_bytes() + VECTOR_BYTES > cache_->line_bytes()) {
+            throw std::invalid_argument("MemoryFacade: acceso vectorial en " + std::to_string(addr) +
+                                        " no alineado a " + std::to_string(VECTOR_BYTES) +
+                                        " B o mayor que la línea");
+        }
+    }
+
+    void issue_prefetches(const std::vector<uint64_t>& lines) {
+        for (uint64_t line : lines) {
+            if (line >= Memory::ADDRESS_LIMIT) continue; // el stride salió del espacio de direcciones
+            if (cache_->get_line_state(line) != MESI_State::INVALID || cache_->prefetch_in_flight(line)) continue;
+            cache_->note_prefetch_issued(line);
+            BusTransaction transaction(pe_id_, BusCommand::BUS_READ, line);
+            transaction.prefetch = true;
+            bus_->add_request(transaction);
+        }
+    }
+
     CacheL1* cache_;
     BusInterconnect* bus_;
     int pe_id_; // Identificador del PE asociado
     int load_counter_ = 0;
     int store_counter_ = 0;
+    int local_hit_counter_ = 0;
 };
 
-#endif // MEMORY_FACADE_HPP
\ No newline at end of file
+#endif // MEMORY_FACADE_HPP
@@ -2,6 +2,8 @@
 #include <stdexcept>
 #include "Instruction.hpp"
 #include "SharedMemory.hpp"
+#include "ProgramImage.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
@@ -16,32 +18,21 @@ ProcessingElement::~ProcessingElement() {
     }
 }
 
-ProcessingElement::ProcessingElement(ProcessingElement&& other) noexcept : m_id(other.m_id) {
-    std::scoped_lock lock(other.m_regMutex);
-    m_registers = other.m_registers;
-    m_running = other.m_running.load();
-    if (other.m_thread.joinable()) {
-        m_thread = std::move(other.m_thread);
-    }
-}
-
-ProcessingElement& ProcessingElement::operator=(ProcessingElement&& other) noexcept {
-    if (this != &other) {
-        if (m_thread.joinable()) m_thread.join();
-        std::scoped_lock lock(other.m_regMutex, m_regMutex);
-        m_id = other.m_id;
-        m_registers = other.m_registers;
-        m_running = other.m_running.load();
-        if (other.m_thread.joinable()) {
-            m_thread = std::move(other.m_thread);
-        }
-    }
-    return *this;
+void ProcessingElement::loadProgram(const std::vector<Instruction>& prog) {
+    m_ownedCode = decodeProgram(prog, REG_COUNT);
+    m_image.reset();
+    m_code = m_ownedCode.data();
+    m_codeSize = m_ownedCode.size();
+    m_pc = 0;
 }
 
-void ProcessingElement::loadProgram(const std::vector<Instruction>& prog) {
-    std::scoped_lock lock(m_regMutex);
-    m_program = prog;
+void ProcessingElement::loadProgram(std::shared_ptr<const ProgramImage> image) {
+    if (!image) throw std::invalid_argument("ProcessingElement::loadProgram: imagen nula");
+    m_image = std::move(image);
+    m_ownedCode.clear();
+    m_ownedCode.shrink_to_fit();
+    m_code = m_image->code();
+    m_codeSize = m_image->size();
     m_pc = 0;
 }
 
@@ -50,116 +41,287 @@ void ProcessingElement::attachMemory(SharedMemory* mem) {
 }
 
 void ProcessingElement::start(ThreadFunc func) {
+    if (!func) {
+        throw std::invalid_argument("ProcessingElement::start: funcion nula (usar start(EventScheduler&) para ejecutar el programa)");
+    }
+    if (m_running.load()) {
+        throw std::runtime_error("ProcessingElement already running");
+    }
+    m_running = true;
+    m_thread = std::thread([this, func]() {
+        func(*this);
+        m_running = false;
+    });
+}
+
+void ProcessingElement::start(EventScheduler& scheduler) {
     if (m_running.load()) {
         throw std::runtime_error("ProcessingElement already running");
     }
     m_running = true;
-    if (func) {
-        // custom function overrides default execution
-        m_thread = std::thread([this, func]() {
-            func(*this);
+    m_sched = &scheduler;
+    m_instructions = 0;
+    m_startCycle = scheduler.now();
+    m_finishCycle = m_startCycle;
+    m_sched->schedule(0, [this]() { step(); });
+}
+
+void ProcessingElement::step() {
+    const DecodedInstruction* code = m_code;
+    const size_t size = m_codeSize;
+    size_t budget = m_debug ? 1 : BATCH_LIMIT;
+    Cycle elapsed = 0;
+
+    while (m_running.load(std::memory_order_relaxed) && m_pc < size && budget-- > 0) {
+        if (m_sched->now() + elapsed >= m_pauseAt) {
+            // Pausa para un checkpoint: no se agenda el siguiente paso hasta resume()
+            m_paused = true;
+            m_resumeCycle = m_sched->now() + elapsed;
+            m_finishCycle = m_resumeCycle;
+            publishRegisters();
+            return;
+        }
+        const DecodedInstruction& inst = code[m_pc];
+        // El acceso a memoria debe emitirse en su ciclo: se agenda para dentro de 'elapsed'
+        if (elapsed > 0 && isMemoryOp(inst.op)) break;
+        if (m_debug) std::cin.get();
+        Cycle latency = s_dispatch[inst.op](*this, inst);
+        m_instructions++;
+        if (latency == STALLED) { // retireMemory reanuda al completarse el acceso
+            publishRegisters();
+            return;
+        }
+        elapsed += latency;
+    }
+    publishRegisters();
+    m_finishCycle = m_sched->now() + elapsed;
+    if (m_running.load() && m_pc < size) {
+        m_sched->schedule(elapsed, [this]() { step(); });
+        return;
+    }
+    m_running = false;
+}
+
+void ProcessingElement::restoreState(const std::array<uint64_t, REG_COUNT>& registers,
+                                     const std::array<VectorRegister, VREG_COUNT>& vectorRegisters, size_t pc,
+                                     Cycle startCycle) {
+    if (pc > m_codeSize) throw std::out_of_range("ProcessingElement::restoreState: PC fuera del programa");
+    m_registers = registers;
+    m_vregs = vectorRegisters;
+    publishRegisters();
+    m_pc = pc;
+    m_startCycle = startCycle;
+    m_finishCycle = startCycle;
+}
+
+void ProcessingElement::resume(EventScheduler& scheduler, Cycle at) {
+    m_sched = &scheduler;
+    m_paused = false;
+    m_pauseAt = NEVER;
+    m_running = true;
+    m_sched->schedule_at(std::max(at, scheduler.now()), [this]() { step(); });
+}
+
+/* ---------------- Handlers (tabla de despacho) ---------------- */
+
+const ProcessingElement::OpHandler ProcessingElement::s_dispatch[OPCODE_COUNT] = {
+    &ProcessingElement::opLoad,  // LOAD
+    &ProcessingElement::opStore, // STORE
+    &ProcessingElement::opFmul,  // FMUL
+    &ProcessingElement::opFadd,  // FADD
+    &ProcessingElement::opInc,   // INC
+    &ProcessingElement::opDec,   // DEC
+    &ProcessingElement::opJnz,   // JNZ
+    &ProcessingElement::opHalt,  // HALT
+    &ProcessingElement::opMovi,  // MOVI
+    &ProcessingElement::opAddi,  // ADDI
+    &ProcessingElement::opAdd,   // ADD
+    &ProcessingElement::opLoadr, // LOADR
+    &ProcessingElement::opStorer, // STORER
+    &ProcessingElement::opVload,  // VLOAD
+    &ProcessingElement::opVstore, // VSTORE
+    &ProcessingElement::opVadd,   // VADD
+    &ProcessingElement::opVmul,   // VMUL
+    &ProcessingElement::opVfma,   // VFMA
+    &ProcessingElement::opVreduce, // VREDUCE
+    &ProcessingElement::opVbcast  // VBCAST
+};
+
+Cycle ProcessingElement::opLoad(ProcessingElement& pe, const DecodedInstruction& inst) {
+    if (!pe.m_mem) { pe.m_registers[inst.rd] = 0; pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueLoad(inst.imm, static_cast<uint32_t>(pe.m_pc)), inst.rd);
+}
+
+Cycle ProcessingElement::opStore(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t val = pe.m_registers[inst.rd];
+    if (!pe.m_mem) { pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueStore(inst.imm, val, static_cast<uint32_t>(pe.m_pc)), -1);
+}
+
+Cycle ProcessingElement::opFmul(ProcessingElement& pe, const DecodedInstruction& inst) {
+    double a, b;
+    std::memcpy(&a, &pe.m_registers[inst.ra], sizeof(uint64_t));
+    std::memcpy(&b, &pe.m_registers[inst.rb], sizeof(uint64_t));
+    double r = a * b;
+    std::memcpy(&pe.m_registers[inst.rd], &r, sizeof(uint64_t));
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] FMUL: " << int(inst.ra) << ", " << int(inst.rb) << " -> " << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opFadd(ProcessingElement& pe, const DecodedInstruction& inst) {
+    double a, b;
+    std::memcpy(&a, &pe.m_registers[inst.ra], sizeof(uint64_t));
+    std::memcpy(&b, &pe.m_registers[inst.rb], sizeof(uint64_t));
+    double r = a + b;
+    std::memcpy(&pe.m_registers[inst.rd], &r, sizeof(uint64_t));
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] FADD: " << int(inst.ra) << ", " << int(inst.rb) << " -> " << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opInc(ProcessingElement& pe, const DecodedInstruction& inst) {
+    pe.m_registers[inst.rd] += 1;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] INC: " << int(inst.rd) << " -> " << pe.m_registers[inst.rd] << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opDec(ProcessingElement& pe, const DecodedInstruction& inst) {
+    pe.m_registers[inst.rd] -= 1;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] DEC: " << int(inst.rd) << " -> " << pe.m_registers[inst.rd] << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opJnz(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t cond = pe.m_registers[7];
+    if (cond != 0) pe.m_pc = inst.target; else pe.m_pc++;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] JNZ: " << cond << " -> " << pe.m_pc << std::endl;
+    return 1;
+}
+
+Cycle ProcessingElement::opHalt(ProcessingElement& pe, const DecodedInstruction&) {
+    pe.m_running = false;
+    return 1;
+}
+
+Cycle ProcessingElement::opMovi(ProcessingElement& pe, const DecodedInstruction& inst) {
+    pe.m_registers[inst.rd] = inst.imm;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] MOVI: " << int(inst.rd) << " <- " << inst.imm << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opAddi(ProcessingElement& pe, const DecodedInstruction& inst) {
+    pe.m_registers[inst.rd] += inst.imm;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] ADDI: " << int(inst.rd) << " <- " << pe.m_registers[inst.rd] << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opAdd(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t sum = pe.m_registers[inst.ra] + pe.m_registers[inst.rb];
+    pe.m_registers[inst.rd] = sum;
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] ADD: " << int(inst.rd) << " <- " << sum << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opLoadr(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t effective = pe.m_registers[inst.ra];
+    if (!pe.m_mem) { pe.m_registers[inst.rd] = 0; pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueLoad(effective, static_cast<uint32_t>(pe.m_pc)), inst.rd);
+}
+
+Cycle ProcessingElement::opStorer(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t effective = pe.m_registers[inst.ra];
+    uint64_t val = pe.m_registers[inst.rd];
+    if (!pe.m_mem) { pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueStore(effective, val, static_cast<uint32_t>(pe.m_pc)), -1);
+}
+
+Cycle ProcessingElement::opVload(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t effective = pe.m_registers[inst.ra];
+    if (!pe.m_mem) { pe.m_vregs[inst.rd] = VectorRegister{}; pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueVectorLoad(effective, static_cast<uint32_t>(pe.m_pc)), inst.rd);
+}
+
+Cycle ProcessingElement::opVstore(ProcessingElement& pe, const DecodedInstruction& inst) {
+    uint64_t effective = pe.m_registers[inst.ra];
+    uint64_t lanes[VECTOR_LANES];
+    std::memcpy(lanes, pe.m_vregs[inst.rd].lanes, sizeof(lanes));
+    if (!pe.m_mem) { pe.m_pc++; return 1; }
+    return pe.awaitMemory(pe.m_mem->issueVectorStore(effective, lanes, static_cast<uint32_t>(pe.m_pc)), -1);
+}
+
+Cycle ProcessingElement::opVadd(ProcessingElement& pe, const DecodedInstruction& inst) {
+    vector_ops::add(pe.m_vregs[inst.rd], pe.m_vregs[inst.ra], pe.m_vregs[inst.rb]);
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] VADD: V" << int(inst.ra) << ", V" << int(inst.rb) << " -> V" << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opVmul(ProcessingElement& pe, const DecodedInstruction& inst) {
+    vector_ops::mul(pe.m_vregs[inst.rd], pe.m_vregs[inst.ra], pe.m_vregs[inst.rb]);
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] VMUL: V" << int(inst.ra) << ", V" << int(inst.rb) << " -> V" << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opVfma(ProcessingElement& pe, const DecodedInstruction& inst) {
+    vector_ops::fma(pe.m_vregs[inst.rd], pe.m_vregs[inst.ra], pe.m_vregs[inst.rb]);
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] VFMA: V" << int(inst.ra) << ", V" << int(inst.rb) << " -> V" << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opVreduce(ProcessingElement& pe, const DecodedInstruction& inst) {
+    const double r = vector_ops::reduce(pe.m_vregs[inst.ra]);
+    std::memcpy(&pe.m_registers[inst.rd], &r, sizeof(uint64_t));
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] VREDUCE: V" << int(inst.ra) << " -> " << int(inst.rd) << " = " << r << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::opVbcast(ProcessingElement& pe, const DecodedInstruction& inst) {
+    double value;
+    std::memcpy(&value, &pe.m_registers[inst.ra], sizeof(uint64_t));
+    vector_ops::broadcast(pe.m_vregs[inst.rd], value);
+    if (pe.m_debug) std::cout << "[PE " << pe.m_id << "] VBCAST: " << int(inst.ra) << " -> V" << int(inst.rd) << std::endl;
+    pe.m_pc++; return 1;
+}
+
+Cycle ProcessingElement::awaitMemory(MemRequestHandle req, int rd) {
+    m_memAccesses++;
+    m_pendingRd = rd;
+    if (req->done) { // memoria ideal o acierto inmediato
+        retireMemory(*req);
+        return 1;
+    }
+    // Detener el PE: al completarse la petición se entrega el dato y se reanuda
+    m_pending = std::move(req);
+    m_pending->onComplete = [this](MemRequest& done) {
+        m_memStallCycles += done.latency();
+        retireMemory(done);
+        publishRegisters();
+        m_pending.reset();
+        m_finishCycle = m_sched->now();
+        if (m_running.load() && m_pc < m_codeSize) {
+            m_sched->schedule(0, [this]() { step(); });
+        } else {
             m_running = false;
-        });
+        }
+    };
+    return STALLED;
+}
+
+void ProcessingElement::retireMemory(const MemRequest& req) {
+    (req.kind == MemRequest::Kind::LOAD ? m_loadLatency : m_storeLatency).record(req.latency());
+    const uint8_t op = m_code[m_pc].op;
+    const char* name = (op == static_cast<uint8_t>(OpCode::LOAD) || op == static_cast<uint8_t>(OpCode::STORE)) ? "" : "R";
+    if (req.vector) {
+        if (req.kind == MemRequest::Kind::LOAD) std::memcpy(m_vregs[m_pendingRd].lanes, req.lanes, sizeof(req.lanes));
+        if (m_debug) {
+            std::cout << "[PE " << m_id << "] " << (req.kind == MemRequest::Kind::LOAD ? "VLOAD: " : "VSTORE: ")
+                      << req.address << std::endl;
+        }
+    } else if (req.kind == MemRequest::Kind::LOAD) {
+        m_registers[m_pendingRd] = req.value;
+        if (m_debug) std::cout << "[PE " << m_id << "] LOAD" << name << ": " << req.address << " -> " << req.value << std::endl;
     } else {
-        // default: execute loaded program
-        m_thread = std::thread([this]() {
-            while (m_running.load()) {
-                if (m_debug) std::cin.get();
-                Instruction inst;
-                {
-                    std::scoped_lock lock(m_regMutex);
-                    if (m_pc >= m_program.size()) { m_running = false; break; }
-                    inst = m_program[m_pc];
-                }
-                switch (inst.op) {
-                    case OpCode::LOAD: {
-                        uint64_t val = m_mem ? m_mem->load(inst.addr) : 0;
-                        if (m_debug) std::cout << "[PE " << m_id << "] LOAD: " << inst.addr << " -> " << val << std::endl;
-                        writeReg(inst.rd, val);
-                        m_pc++; break;
-                    }
-                    case OpCode::STORE: {
-                        uint64_t val = readReg(inst.rd);
-                        if (m_mem) m_mem->store(inst.addr, val);
-                        if (m_debug) std::cout << "[PE " << m_id << "] STORE: " << inst.addr << " <- " << val << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::FMUL: {
-                        uint64_t aBits = readReg(inst.ra);
-                        uint64_t bBits = readReg(inst.rb);
-                        double a, b; std::memcpy(&a, &aBits, sizeof(uint64_t)); std::memcpy(&b, &bBits, sizeof(uint64_t));
-                        double r = a * b;
-                        uint64_t raw; std::memcpy(&raw, &r, sizeof(uint64_t));
-                        writeReg(inst.rd, raw);
-                        if (m_debug) std::cout << "[PE " << m_id << "] FMUL: " << inst.ra << ", " << inst.rb << " -> " << inst.rd << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::FADD: {
-                        uint64_t aBits = readReg(inst.ra);
-                        uint64_t bBits = readReg(inst.rb);
-                        double a, b; std::memcpy(&a, &aBits, sizeof(uint64_t)); std::memcpy(&b, &bBits, sizeof(uint64_t));
-                        double r = a + b;
-                        uint64_t raw; std::memcpy(&raw, &r, sizeof(uint64_t));
-                        writeReg(inst.rd, raw);
-                        if (m_debug) std::cout << "[PE " << m_id << "] FADD: " << inst.ra << ", " << inst.rb << " -> " << inst.rd << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::INC: {
-                        addImm(inst.rd, 1);
-                        if (m_debug) std::cout << "[PE " << m_id << "] INC: " << inst.rd << " -> " << (readReg(inst.rd) + 1) << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::DEC: {
-                        addImm(inst.rd, static_cast<uint64_t>(-1));
-                        if (m_debug) std::cout << "[PE " << m_id << "] DEC: " << inst.rd << " -> " << (readReg(inst.rd) - 1) << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::JNZ: {
-                        uint64_t cond = readReg(7);
-                        if (cond != 0) m_pc = inst.target; else m_pc++;
-                        if (m_debug) std::cout << "[PE " << m_id << "] JNZ: " << cond << " -> " << m_pc << std::endl;
-                        break;
-                    }
-                    case OpCode::HALT: {
-                        m_running = false; break;
-                    }
-                    case OpCode::MOVI: {
-                        writeReg(inst.rd, inst.addr); // immediate in addr field
-                        if (m_debug) std::cout << "[PE " << m_id << "] MOVI: " << inst.rd << " <- " << inst.addr << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::ADDI: {
-                        uint64_t cur = readReg(inst.rd);
-                        writeReg(inst.rd, cur + inst.addr);
-                        if (m_debug) std::cout << "[PE " << m_id << "] ADDI: " << inst.rd << " <- " << (cur + inst.addr) << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::ADD: {
-                        uint64_t a = readReg(inst.ra);
-                        uint64_t b = readReg(inst.rb);
-                        writeReg(inst.rd, a + b);
-                        if (m_debug) std::cout << "[PE " << m_id << "] ADD: " << inst.rd << " <- " << (a + b) << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::LOADR: {
-                        uint64_t effective = readReg(inst.ra);
-                        uint64_t val = m_mem ? m_mem->load(effective) : 0;
-                        writeReg(inst.rd, val);
-                        if (m_debug) std::cout << "[PE " << m_id << "] LOADR: " << effective << " -> " << val << std::endl;
-                        m_pc++; break;
-                    }
-                    case OpCode::STORER: {
-                        uint64_t effective = readReg(inst.ra);
-                        uint64_t val = readReg(inst.rd);
-                        if (m_mem) m_mem->store(effective, val);
-                        if (m_debug) std::cout << "[PE " << m_id << "] STORER: " << effective << " <- " << val << std::endl;
-                        m_pc++; break;
-                    }
-                }
-            }
-            m_running = false;
-        });
+        if (m_debug) std::cout << "[PE " << m_id << "] STORE" << name << ": " << req.address << " <- " << req.value << std::endl;
     }
+    m_pc++;
 }
 
 void ProcessingElement::join() {
@@ -170,18 +332,17 @@ void ProcessingElement::join() {
 
 uint64_t ProcessingElement::readReg(size_t idx) const {
     if (idx >= REG_COUNT) throw std::out_of_range("Invalid register index");
-    std::scoped_lock lock(m_regMutex);
-    return m_registers[idx];
+    return m_snapshot.read()[idx];
 }
 
 void ProcessingElement::writeReg(size_t idx, uint64_t value) {
     if (idx >= REG_COUNT) throw std::out_of_range("Invalid register index");
-    std::scoped_lock lock(m_regMutex);
     m_registers[idx] = value;
+    publishRegisters();
 }
 
 void ProcessingElement::addImm(size_t dstIdx, uint64_t imm) {
     if (dstIdx >= REG_COUNT) throw std::out_of_range("Invalid register index");
-    std::scoped_lock lock(m_regMutex);
     m_registers[dstIdx] += imm;
+    publishRegisters();
 }
@@ -4,12 +4,19 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
-#include <mutex>
 #include <vector>
 #include "Instruction.hpp"
+#include "DecodedProgram.hpp"
+#include "RegisterSnapshot.hpp"
+#include "VectorRegister.hpp"
+#include "MemRequest.hpp"
+#include "../sim/EventScheduler.h"
+#include "../utils/histogram.h"
 
 class SharedMemory;
+class ProgramImage;
 
 class ProcessingElement {
 public:
@@ -20,36 +27,138 @@ public:
     ProcessingElement(unsigned id, bool debug);
     ~ProcessingElement();
 
-    // Non copyable
+    // Non copyable, non movable: ProcessorSystem los guarda en unique_ptr y el
+    // scheduler y el hilo del host capturan su dirección (this)
     ProcessingElement(const ProcessingElement&) = delete;
     ProcessingElement& operator=(const ProcessingElement&) = delete;
+    ProcessingElement(ProcessingElement&&) = delete;
+    ProcessingElement& operator=(ProcessingElement&&) = delete;
 
-    // Movable
-    ProcessingElement(ProcessingElement&&) noexcept;
-    ProcessingElement& operator=(ProcessingElement&&) noexcept;
-
+    // Ejecuta una función arbitraria en un hilo del host
     void start(ThreadFunc func);
     void join();
 
+    // Ejecuta el programa cargado sobre el reloj del scheduler (tiempo simulado)
+    void start(EventScheduler& scheduler);
+    bool isRunning() const { return m_running.load(); }
+
+    // Lectura desde cualquier hilo: usa la copia publicada (no bloquea al PE)
     uint64_t readReg(size_t idx) const;
+    std::array<uint64_t, REG_COUNT> snapshotRegisters() const { return m_snapshot.read(); }
+    // Escritura del dueño del PE (hilo de start(ThreadFunc) o antes de ejecutar)
     void writeReg(size_t idx, uint64_t value);
+    // Registros vectoriales V0-V7 (solo desde el dueño del PE o con el PE detenido)
+    const std::array<VectorRegister, VREG_COUNT>& vectorRegisters() const { return m_vregs; }
 
     unsigned getId() const { return m_id; }
 
     // Simple helper: add immediate to a register
     void addImm(size_t dstIdx, uint64_t imm);
 
+    // Pre-decodifica y valida el programa; lanza std::invalid_argument si es inválido
     void loadProgram(const std::vector<Instruction>& prog);
+    // Ejecuta directo sobre una imagen .pecb ya validada (puede compartirse entre PEs)
+    void loadProgram(std::shared_ptr<const ProgramImage> image);
     void attachMemory(SharedMemory* mem);
 
+    // --- Checkpoint (sim/Checkpoint.h) ---
+    // Pausa el PE antes de la primera instrucción que le toque ejecutar en un ciclo >= cycle;
+    // un acceso en vuelo se completa antes. Sigue en pausa (isPaused) hasta resume().
+    void pauseAt(Cycle cycle) { m_pauseAt = cycle; }
+    bool isPaused() const { return m_paused; }
+    Cycle getResumeCycle() const { return m_resumeCycle; } // ciclo de su próxima instrucción
+    size_t getPC() const { return m_pc; }
+    size_t getProgramSize() const { return m_codeSize; }
+    uint64_t getProgramFingerprint() const { return programFingerprint(m_code, m_codeSize); }
+    // Instala registros y PC guardados (con el programa ya cargado); las estadísticas cuentan
+    // desde startCycle. Lanza std::out_of_range si pc no está en el programa.
+    void restoreState(const std::array<uint64_t, REG_COUNT>& registers,
+                      const std::array<VectorRegister, VREG_COUNT>& vectorRegisters, size_t pc, Cycle startCycle);
+    // Retoma un PE en pausa o restaurado en el ciclo 'at' (o en now() si ya pasó)
+    void resume(EventScheduler& scheduler, Cycle at);
+
+    // Estadísticas de tiempo simulado
+    uint64_t getInstructionCount() const { return m_instructions; }
+    Cycle getStartCycle() const { return m_startCycle; }
+    Cycle getFinishCycle() const { return m_finishCycle; }
+    uint64_t getMemAccessCount() const { return m_memAccesses; }
+    Cycle getMemStallCycles() const { return m_memStallCycles; }
+    // Latencia (emisión -> entrega) de cada load y store, en cubetas log2
+    const LatencyHistogram& getLoadLatency() const { return m_loadLatency; }
+    const LatencyHistogram& getStoreLatency() const { return m_storeLatency; }
+
 private:
     unsigned m_id;
-    std::array<uint64_t, REG_COUNT> m_registers{}; // initialize to 0
+    std::array<uint64_t, REG_COUNT> m_registers{}; // solo los accede el dueño del PE
+    RegisterSnapshot<REG_COUNT> m_snapshot;         // copia para observadores
+    std::array<VectorRegister, VREG_COUNT> m_vregs{};
     std::thread m_thread;
     std::atomic<bool> m_running{false};
-    mutable std::mutex m_regMutex; // protect register access
-    std::vector<Instruction> m_program;
+    // Código en ejecución: el decodificado de loadProgram(vector) o el de una imagen
+    std::vector<DecodedInstruction> m_ownedCode;
+    std::shared_ptr<const ProgramImage> m_image;
+    const DecodedInstruction* m_code{nullptr};
+    size_t m_codeSize{0};
     size_t m_pc{0};
     bool m_debug{false};
     SharedMemory* m_mem{nullptr};
+
+    EventScheduler* m_sched{nullptr};
+    uint64_t m_instructions{0};
+    Cycle m_startCycle{0};
+    Cycle m_finishCycle{0};
+
+    // Acceso a memoria pendiente: el PE está detenido hasta que se complete
+    static constexpr Cycle STALLED = ~Cycle{0};
+    static constexpr Cycle NEVER = ~Cycle{0};
+    Cycle m_pauseAt{NEVER};
+    bool m_paused{false};
+    Cycle m_resumeCycle{0};
+    MemRequestHandle m_pending;
+    int m_pendingRd{-1};
+    uint64_t m_memAccesses{0};
+    Cycle m_memStallCycles{0};
+    LatencyHistogram m_loadLatency;
+    LatencyHistogram m_storeLatency;
+
+    // Instrucciones de registro ejecutadas como máximo en un mismo evento
+    static constexpr size_t BATCH_LIMIT = 4096;
+
+    // Ejecuta desde m_pc las instrucciones de registro consecutivas en un solo
+    // evento (cada una avanza el reloj local su latencia) hasta un acceso a
+    // memoria, HALT o BATCH_LIMIT; el acceso se emite en su propio evento, en el
+    // ciclo que le corresponde. En modo debug se ejecuta una por evento.
+    void step();
+
+    // Tabla de despacho indexada por DecodedInstruction::op; cada handler
+    // retorna la latencia en ciclos (o STALLED)
+    using OpHandler = Cycle (*)(ProcessingElement&, const DecodedInstruction&);
+    static const OpHandler s_dispatch[OPCODE_COUNT];
+    static Cycle opLoad(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opStore(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opFmul(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opFadd(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opInc(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opDec(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opJnz(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opHalt(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opMovi(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opAddi(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opAdd(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opLoadr(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opStorer(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVload(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVstore(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVadd(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVmul(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVfma(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVreduce(ProcessingElement& pe, const DecodedInstruction& inst);
+    static Cycle opVbcast(ProcessingElement& pe, const DecodedInstruction& inst);
+
+    void publishRegisters() { m_snapshot.publish(m_registers); }
+
+    // Espera la petición emitida; retorna 1 si ya estaba completa o STALLED
+    Cycle awaitMemory(MemRequestHandle req, int rd);
+    // Entrega el resultado de la petición (rd para LOAD, Vd para VLOAD) y avanza el PC
+    void retireMemory(const MemRequest& req);
 };
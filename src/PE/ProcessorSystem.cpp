@@ -1,45 +1,94 @@
 #include "ProcessorSystem.hpp"
 #include "Instruction.hpp"
 #include <stdexcept>
+#include <iostream>
+#include <string>
 
-ProcessorSystem::ProcessorSystem(bool debug) : m_pes{ ProcessingElement(0, debug), ProcessingElement(1, debug), ProcessingElement(2, debug), ProcessingElement(3, debug) } {}
+ProcessorSystem::ProcessorSystem(bool debug, size_t peCount) {
+    if (peCount == 0 || peCount > MAX_PE_COUNT) {
+        throw std::invalid_argument("ProcessorSystem: cantidad de PEs fuera de rango (1.." + std::to_string(MAX_PE_COUNT) + ")");
+    }
+    m_pes.reserve(peCount);
+    for (size_t i = 0; i < peCount; ++i) {
+        m_pes.push_back(std::make_unique<ProcessingElement>(static_cast<unsigned>(i), debug));
+    }
+}
 
 ProcessingElement& ProcessorSystem::getPE(size_t idx) {
-    if (idx >= PE_COUNT) throw std::out_of_range("Invalid PE index");
-    return m_pes[idx];
+    if (idx >= m_pes.size()) throw std::out_of_range("Invalid PE index");
+    return *m_pes[idx];
 }
 
 const ProcessingElement& ProcessorSystem::getPE(size_t idx) const {
-    if (idx >= PE_COUNT) throw std::out_of_range("Invalid PE index");
-    return m_pes[idx];
+    if (idx >= m_pes.size()) throw std::out_of_range("Invalid PE index");
+    return *m_pes[idx];
 }
 
 void ProcessorSystem::startAll(const std::function<void(ProcessingElement&)>& func) {
     for (auto & pe : m_pes) {
-        pe.start(func);
+        pe->start(func);
     }
 }
 
 void ProcessorSystem::startAll(const std::vector<std::function<void(ProcessingElement&)>>& funcs) {
-    if (funcs.size() != PE_COUNT) throw std::invalid_argument("Function vector size mismatch");
-    for (size_t i = 0; i < PE_COUNT; ++i) {
-        m_pes[i].start(funcs[i]);
+    if (funcs.size() != m_pes.size()) throw std::invalid_argument("Function vector size mismatch");
+    for (size_t i = 0; i < m_pes.size(); ++i) {
+        m_pes[i]->start(funcs[i]);
+    }
+}
+
+void ProcessorSystem::startAll(EventScheduler& scheduler) {
+    for (auto & pe : m_pes) {
+        pe->start(scheduler);
     }
 }
 
 void ProcessorSystem::joinAll() {
     for (auto & pe : m_pes) {
-        pe.join();
+        pe->join();
     }
 }
 
 void ProcessorSystem::loadProgram(size_t peIdx, const std::vector<Instruction>& prog) {
-    if (peIdx >= PE_COUNT) throw std::out_of_range("Invalid PE index");
-    m_pes[peIdx].loadProgram(prog);
+    if (peIdx >= m_pes.size()) throw std::out_of_range("Invalid PE index");
+    m_pes[peIdx]->loadProgram(prog);
+}
+
+void ProcessorSystem::loadProgram(size_t peIdx, std::shared_ptr<const ProgramImage> image) {
+    if (peIdx >= m_pes.size()) throw std::out_of_range("Invalid PE index");
+    m_pes[peIdx]->loadProgram(std::move(image));
+}
+
+void ProcessorSystem::loadPrograms(const std::vector<std::vector<Instruction>>& programs) {
+    if (programs.size() != m_pes.size()) throw std::invalid_argument("Program vector size mismatch");
+    for (size_t i = 0; i < m_pes.size(); ++i) {
+        m_pes[i]->loadProgram(programs[i]);
+    }
+}
+
+void ProcessorSystem::printStats(std::ostream& out) const {
+    for (const auto & pePtr : m_pes) {
+        const ProcessingElement& pe = *pePtr;
+        Cycle cycles = pe.getFinishCycle() - pe.getStartCycle();
+        uint64_t instrs = pe.getInstructionCount();
+        out << "[PE " << pe.getId() << "] Instrucciones: " << instrs
+                  << " Ciclos: " << cycles
+                  << " CPI: " << (instrs ? static_cast<double>(cycles) / instrs : 0.0)
+                  << " Accesos a memoria: " << pe.getMemAccessCount()
+                  << " Latencia promedio: " << (pe.getMemAccessCount() ? static_cast<double>(pe.getMemStallCycles()) / pe.getMemAccessCount() : 0.0)
+                  << " ciclos\n";
+    }
 }
 
-void ProcessorSystem::loadPrograms(const std::array<std::vector<Instruction>, PE_COUNT>& programs) {
-    for (size_t i = 0; i < PE_COUNT; ++i) {
-        m_pes[i].loadProgram(programs[i]);
+void ProcessorSystem::exportMetrics(MetricsRegistry& registry) const {
+    for (const auto& pePtr : m_pes) {
+        const ProcessingElement& pe = *pePtr;
+        const std::string name = "pe" + std::to_string(pe.getId());
+        registry.counter(name, "instructions", pe.getInstructionCount());
+        registry.counter(name, "cycles", pe.getFinishCycle() - pe.getStartCycle());
+        registry.counter(name, "mem_accesses", pe.getMemAccessCount());
+        registry.counter(name, "mem_stall_cycles", pe.getMemStallCycles());
+        registry.histogram(name, "load_latency", pe.getLoadLatency());
+        registry.histogram(name, "store_latency", pe.getStoreLatency());
     }
 }
@@ -1,15 +1,20 @@
 #pragma once
 #include "ProcessingElement.hpp"
 #include "Instruction.hpp"
-#include <array>
+#include "../utils/metricsRegistry.h"
+#include <memory>
 #include <vector>
 #include <functional>
+#include <iostream>
 
 class ProcessorSystem {
 public:
-    static constexpr size_t PE_COUNT = 4;
+    static constexpr size_t DEFAULT_PE_COUNT = 4;
+    static constexpr size_t MAX_PE_COUNT = 64; // igual a BusInterconnect::MAX_PES
 
-    ProcessorSystem(bool debug = false);
+    ProcessorSystem(bool debug = false, size_t peCount = DEFAULT_PE_COUNT);
+
+    size_t size() const { return m_pes.size(); }
 
     ProcessingElement& getPE(size_t idx);
     const ProcessingElement& getPE(size_t idx) const;
@@ -17,17 +22,28 @@ public:
     // Launch all PEs with provided function (receives reference to its PE instance)
     void startAll(const std::function<void(ProcessingElement&)>& func);
 
-    // Provide a vector of functions (size must be PE_COUNT)
+    // Provide a vector of functions (size must be size())
     void startAll(const std::vector<std::function<void(ProcessingElement&)>>& funcs);
 
+    // Lanzar el programa cargado en todos los PEs sobre el reloj simulado
+    void startAll(EventScheduler& scheduler);
+
     void joinAll();
 
     // Cargar un programa en un PE específico
     void loadProgram(size_t peIdx, const std::vector<Instruction>& prog);
+    // Cargar una imagen .pecb (ver ProgramImage.hpp) en un PE específico
+    void loadProgram(size_t peIdx, std::shared_ptr<const ProgramImage> image);
+
+    // Cargar programas para todos los PEs (programs.size() == size())
+    void loadPrograms(const std::vector<std::vector<Instruction>>& programs);
 
-    // Cargar programas para todos los PEs (array size == PE_COUNT)
-    void loadPrograms(const std::array<std::vector<Instruction>, PE_COUNT>& programs);
+    // Imprime instrucciones y ciclos de cada PE tras una ejecución simulada
+    void printStats(std::ostream& out = std::cout) const;
+    // Contadores e histogramas de latencia de cada PE como "pe<id>"
+    void exportMetrics(MetricsRegistry& registry) const;
 
 private:
-    std::array<ProcessingElement, PE_COUNT> m_pes;
+    // Los PEs agendan eventos sobre sí mismos: su dirección no debe cambiar
+    std::vector<std::unique_ptr<ProcessingElement>> m_pes;
 };
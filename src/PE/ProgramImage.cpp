@@ -0,0 +1,100 @@
+#include "ProgramImage.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define PROGRAM_IMAGE_HAS_MMAP 1
+#endif
+
+using namespace program_image;
+
+void writeProgramImage(const std::vector<Instruction>& program, size_t regCount, const std::string& path) {
+    const std::vector<DecodedInstruction> code = decodeProgram(program, regCount);
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.instruction_bytes = sizeof(DecodedInstruction);
+    header.count = static_cast<uint32_t>(code.size());
+    header.registers = static_cast<uint32_t>(regCount);
+    header.checksum = programFingerprint(code.data(), code.size());
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) throw std::runtime_error("writeProgramImage: no se pudo crear " + path);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fwrite(code.data(), sizeof(DecodedInstruction), code.size(), file);
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!ok) throw std::runtime_error("writeProgramImage: error escribiendo " + path);
+}
+
+ProgramImage::ProgramImage(const std::string& path, size_t regCount) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("ProgramImage: no se pudo abrir " + path);
+    m_bytes = static_cast<size_t>(in.tellg());
+    FileHeader header{};
+    in.seekg(0);
+    if (m_bytes < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " no es una imagen de programa");
+    }
+    if (header.version != FILE_VERSION || header.instruction_bytes != sizeof(DecodedInstruction)) {
+        throw std::runtime_error("Version de imagen de programa no soportada (" + std::to_string(header.version) + ")");
+    }
+    if (m_bytes != sizeof(header) + static_cast<size_t>(header.count) * sizeof(DecodedInstruction)) {
+        throw std::runtime_error(path + ": imagen truncada o dañada");
+    }
+    if (header.registers > regCount) {
+        throw std::runtime_error(path + ": ensamblada para " + std::to_string(header.registers) + " registros");
+    }
+    m_count = header.count;
+    m_checksum = header.checksum;
+
+#ifdef PROGRAM_IMAGE_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    void* data = fd >= 0 ? ::mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (fd >= 0) ::close(fd);
+    if (data != MAP_FAILED) {
+        m_data = static_cast<const uint8_t*>(data);
+        m_mapped = true;
+        m_code = reinterpret_cast<const DecodedInstruction*>(m_data + sizeof(FileHeader));
+    }
+#endif
+    if (!m_mapped) {
+        m_buffer.resize(m_count);
+        if (m_count != 0 && !in.read(reinterpret_cast<char*>(m_buffer.data()),
+                                     static_cast<std::streamsize>(m_count * sizeof(DecodedInstruction)))) {
+            throw std::runtime_error("ProgramImage: no se pudo leer " + path);
+        }
+        m_code = m_buffer.data();
+    }
+
+    // Una sola pasada sobre el código: el intérprete confía en estos invariantes
+    try {
+        if (programFingerprint(m_code, m_count) != m_checksum) {
+            throw std::runtime_error(path + ": checksum de la imagen no coincide");
+        }
+        validateDecoded(m_code, m_count, regCount);
+    } catch (const std::invalid_argument& e) {
+        release();
+        throw std::runtime_error(path + ": " + e.what());
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+ProgramImage::~ProgramImage() {
+    release();
+}
+
+void ProgramImage::release() {
+#ifdef PROGRAM_IMAGE_HAS_MMAP
+    if (m_mapped) ::munmap(const_cast<uint8_t*>(m_data), m_bytes);
+#endif
+    m_mapped = false;
+    m_data = nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DecodedProgram.hpp"
+#include "Instruction.hpp"
+
+// Imagen binaria de un programa ensamblado (.pecb, la genera ./pec_asm).
+// Formato: una FileHeader y luego 'count' DecodedInstruction de 16 bytes, con los saltos ya
+// resueltos a índices y los registros ya validados; checksum es programFingerprint del código.
+// El orden de bytes es el del host (little-endian en x86).
+namespace program_image {
+
+constexpr char FILE_MAGIC[8] = {'M', 'E', 'S', 'I', 'P', 'E', 'C', 'B'};
+constexpr uint32_t FILE_VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t instruction_bytes; // sizeof(DecodedInstruction)
+    uint32_t count;
+    uint32_t registers;         // registros con que se validó
+    uint64_t checksum;
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader debe medir 32 bytes");
+
+} // namespace program_image
+
+// Decodifica y valida el programa y escribe su imagen en 'path'.
+// Lanza std::invalid_argument si el programa es inválido y std::runtime_error si no puede escribir.
+void writeProgramImage(const std::vector<Instruction>& program, size_t regCount, const std::string& path);
+
+// Imagen cargada: el archivo se proyecta con mmap de solo lectura y el PE ejecuta directo sobre
+// él, sin parsear ni reservar memoria por instrucción (sin mmap se lee en un solo bloque).
+// La carga verifica cabecera, checksum, registros y destinos de salto.
+class ProgramImage {
+public:
+    // Lanza std::runtime_error si el archivo no existe, no es una imagen, está dañado o se
+    // ensambló con más registros que regCount
+    ProgramImage(const std::string& path, size_t regCount);
+    ~ProgramImage();
+    ProgramImage(const ProgramImage&) = delete;
+    ProgramImage& operator=(const ProgramImage&) = delete;
+
+    const DecodedInstruction* code() const { return m_code; }
+    size_t size() const { return m_count; }
+    uint64_t checksum() const { return m_checksum; }
+    bool mapped() const { return m_mapped; }
+
+private:
+    const uint8_t* m_data{nullptr};
+    size_t m_bytes{0};
+    bool m_mapped{false};
+    std::vector<DecodedInstruction> m_buffer; // sin mmap
+    const DecodedInstruction* m_code{nullptr};
+    size_t m_count{0};
+    uint64_t m_checksum{0};
+
+    void release();
+};
@@ -12,6 +12,13 @@ static int regIndex(const std::string& tok) {
     return idx;
 }
 
+static int vregIndex(const std::string& tok) {
+    if (tok.size() < 2 || (tok[0] != 'V' && tok[0] != 'v')) throw std::runtime_error("Registro vectorial invalido: " + tok);
+    int idx = std::stoi(tok.substr(1));
+    if (idx < 0 || idx >= static_cast<int>(VREG_COUNT)) throw std::runtime_error("Indice de registro vectorial fuera de rango: " + tok);
+    return idx;
+}
+
 std::vector<Instruction> loadProgramFile(const std::string& path) {
     std::ifstream in(path);
     if (!in) throw std::runtime_error("No se pudo abrir archivo: " + path);
@@ -82,6 +89,17 @@ std::vector<Instruction> loadProgramFile(const std::string& path) {
         } else if (op == "STORER") {
             std::string rs, ra; iss >> rs; if (rs.back()==',') rs.pop_back(); iss >> ra; // ra is address register
             Instruction inst; inst.op = OpCode::STORER; inst.rd = regIndex(rs); inst.ra = regIndex(ra); program.push_back(inst);
+        } else if (op == "VLOAD" || op == "VSTORE" || op == "VBCAST") {
+            std::string vd, ra; iss >> vd; if (vd.back()==',') vd.pop_back(); iss >> ra; // ra: dirección (VLOAD/VSTORE) o escalar (VBCAST)
+            Instruction inst; inst.op = (op=="VLOAD"?OpCode::VLOAD:op=="VSTORE"?OpCode::VSTORE:OpCode::VBCAST);
+            inst.rd = vregIndex(vd); inst.ra = regIndex(ra); program.push_back(inst);
+        } else if (op == "VADD" || op == "VMUL" || op == "VFMA") {
+            std::string vd, va, vb; iss >> vd; if (vd.back()==',') vd.pop_back(); iss >> va; if (va.back()==',') va.pop_back(); iss >> vb;
+            Instruction inst; inst.op = (op=="VADD"?OpCode::VADD:op=="VMUL"?OpCode::VMUL:OpCode::VFMA);
+            inst.rd = vregIndex(vd); inst.ra = vregIndex(va); inst.rb = vregIndex(vb); program.push_back(inst);
+        } else if (op == "VREDUCE") {
+            std::string rd, va; iss >> rd; if (rd.back()==',') rd.pop_back(); iss >> va;
+            Instruction inst; inst.op = OpCode::VREDUCE; inst.rd = regIndex(rd); inst.ra = vregIndex(va); program.push_back(inst);
         } else {
             throw std::runtime_error("Operacion desconocida linea " + std::to_string(lineNum) + ": " + op);
         }
@@ -14,5 +14,8 @@
 //  FMUL Rd, Ra, Rb
 //  JNZ label   (usa R7 como condición)
 //  HALT
+//  MOVI Rn, imm / ADDI Rn, imm / ADD Rd, Ra, Rb / LOADR Rd, Ra / STORER Rs, Ra
+//  VLOAD Vd, Ra / VSTORE Vs, Ra        (línea de 32 B en la dirección Ra)
+//  VADD/VMUL/VFMA Vd, Va, Vb / VREDUCE Rd, Va / VBCAST Vd, Ra
 //  ; comentarios con ; o #
 std::vector<Instruction> loadProgramFile(const std::string& path);
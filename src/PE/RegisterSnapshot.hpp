@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Copia publicada del banco de registros de un PE (seqlock).
+// Un solo escritor (el dueño del PE) publica; cualquier hilo puede leer sin
+// bloquearlo: si la lectura se cruza con una publicación, se reintenta.
+template <size_t N>
+class RegisterSnapshot {
+public:
+    RegisterSnapshot() {
+        for (auto& v : m_values) v.store(0, std::memory_order_relaxed);
+    }
+
+    // Solo el dueño
+    void publish(const std::array<uint64_t, N>& regs) {
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed); // impar: escritura en curso
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < N; ++i) m_values[i].store(regs[i], std::memory_order_relaxed);
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    std::array<uint64_t, N> read() const {
+        std::array<uint64_t, N> out{};
+        for (;;) {
+            uint64_t before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            for (size_t i = 0; i < N; ++i) out[i] = m_values[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == before) return out;
+        }
+    }
+
+    // Cantidad de publicaciones (útil para saber si hubo cambios)
+    uint64_t version() const { return m_seq.load(std::memory_order_acquire) / 2; }
+
+private:
+    std::atomic<uint64_t> m_seq{0};
+    std::array<std::atomic<uint64_t>, N> m_values;
+};
@@ -1,11 +1,18 @@
 #pragma once
-#include <vector>
 #include <cstdint>
-#include <mutex>
+#include "MemRequest.hpp"
 
 class SharedMemory {
 public:
     virtual ~SharedMemory() = default; // Virtual destructor
-    virtual uint64_t load(uint64_t address) = 0;
-    virtual void store(uint64_t address, uint64_t value) = 0;
+
+    // Emiten un acceso y retornan su handle de completitud. Si el handle no
+    // viene completo (done == false) el PE se detiene hasta que lo esté.
+    // pc: instrucción que hace el acceso (la usa el prefetcher por stride)
+    virtual MemRequestHandle issueLoad(uint64_t address, uint32_t pc) = 0;
+    virtual MemRequestHandle issueStore(uint64_t address, uint64_t value, uint32_t pc) = 0;
+    // VLOAD/VSTORE: VECTOR_LANES palabras consecutivas desde address (alineada a VECTOR_BYTES)
+    // en un solo acceso; el dato viaja en MemRequest::lanes
+    virtual MemRequestHandle issueVectorLoad(uint64_t address, uint32_t pc) = 0;
+    virtual MemRequestHandle issueVectorStore(uint64_t address, const uint64_t* lanes, uint32_t pc) = 0;
 };
@@ -8,18 +8,49 @@ class SharedMemoryInstance : public SharedMemory {
 public:
     explicit SharedMemoryInstance(size_t sizeBytes) : m_data(sizeBytes/8, 0) {}
 
-    uint64_t load(uint64_t addr) override {
+    uint64_t load(uint64_t addr) {
         std::scoped_lock lock(m_mutex);
         size_t idx = addr/8;
         if (idx >= m_data.size()) return 0;
         return m_data[idx];
     }
-    void store(uint64_t addr, uint64_t val) override {
+    void store(uint64_t addr, uint64_t val) {
         std::scoped_lock lock(m_mutex);
         size_t idx = addr/8;
         if (idx >= m_data.size()) return;
         m_data[idx] = val;
     }
+
+    // Memoria ideal: toda petición se completa de inmediato
+    MemRequestHandle issueLoad(uint64_t addr, uint32_t) override {
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::LOAD, addr);
+        req->value = load(addr);
+        req->complete(0);
+        return req;
+    }
+    MemRequestHandle issueStore(uint64_t addr, uint64_t val, uint32_t) override {
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::STORE, addr, val);
+        store(addr, val);
+        req->complete(0);
+        return req;
+    }
+    MemRequestHandle issueVectorLoad(uint64_t addr, uint32_t) override {
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::LOAD, addr);
+        req->vector = true;
+        for (unsigned lane = 0; lane < VECTOR_LANES; ++lane) req->lanes[lane] = load(addr + lane * 8);
+        req->complete(0);
+        return req;
+    }
+    MemRequestHandle issueVectorStore(uint64_t addr, const uint64_t* lanes, uint32_t) override {
+        auto req = std::make_shared<MemRequest>(MemRequest::Kind::STORE, addr);
+        req->vector = true;
+        for (unsigned lane = 0; lane < VECTOR_LANES; ++lane) {
+            req->lanes[lane] = lanes[lane];
+            store(addr + lane * 8, lanes[lane]);
+        }
+        req->complete(0);
+        return req;
+    }
 private:
     std::vector<uint64_t> m_data; // simple word-addressable 64-bit
     std::mutex m_mutex;
@@ -0,0 +1,72 @@
+#pragma once
+#include <cmath>
+#include "Instruction.hpp"
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Registro vectorial del PE (V0-V7): VECTOR_LANES doubles, una línea de 32 B.
+// Las operaciones usan AVX si el host lo tiene (-mavx/-march=native), si no SSE2 (dos
+// mitades de 128 bits) y en otro caso un lazo escalar; todas dan el mismo resultado:
+// VFMA redondea una sola vez (fma del host o std::fma) y la reducción suma siempre
+// (l0 + l1) + (l2 + l3).
+struct alignas(32) VectorRegister {
+    double lanes[VECTOR_LANES]{};
+};
+static_assert(VECTOR_LANES == 4 && sizeof(VectorRegister) == VECTOR_BYTES, "las rutinas asumen 4 carriles");
+
+namespace vector_ops {
+
+inline void add(VectorRegister& d, const VectorRegister& a, const VectorRegister& b) {
+#if defined(__AVX__)
+    _mm256_store_pd(d.lanes, _mm256_add_pd(_mm256_load_pd(a.lanes), _mm256_load_pd(b.lanes)));
+#elif defined(__SSE2__)
+    _mm_store_pd(d.lanes, _mm_add_pd(_mm_load_pd(a.lanes), _mm_load_pd(b.lanes)));
+    _mm_store_pd(d.lanes + 2, _mm_add_pd(_mm_load_pd(a.lanes + 2), _mm_load_pd(b.lanes + 2)));
+#else
+    for (unsigned l = 0; l < VECTOR_LANES; ++l) d.lanes[l] = a.lanes[l] + b.lanes[l];
+#endif
+}
+
+inline void mul(VectorRegister& d, const VectorRegister& a, const VectorRegister& b) {
+#if defined(__AVX__)
+    _mm256_store_pd(d.lanes, _mm256_mul_pd(_mm256_load_pd(a.lanes), _mm256_load_pd(b.lanes)));
+#elif defined(__SSE2__)
+    _mm_store_pd(d.lanes, _mm_mul_pd(_mm_load_pd(a.lanes), _mm_load_pd(b.lanes)));
+    _mm_store_pd(d.lanes + 2, _mm_mul_pd(_mm_load_pd(a.lanes + 2), _mm_load_pd(b.lanes + 2)));
+#else
+    for (unsigned l = 0; l < VECTOR_LANES; ++l) d.lanes[l] = a.lanes[l] * b.lanes[l];
+#endif
+}
+
+// d = a * b + d
+inline void fma(VectorRegister& d, const VectorRegister& a, const VectorRegister& b) {
+#if defined(__AVX__) && defined(__FMA__)
+    _mm256_store_pd(d.lanes, _mm256_fmadd_pd(_mm256_load_pd(a.lanes), _mm256_load_pd(b.lanes),
+                                             _mm256_load_pd(d.lanes)));
+#else
+    // Sin FMA en el host, mul + add redondearía dos veces
+    for (unsigned l = 0; l < VECTOR_LANES; ++l) d.lanes[l] = std::fma(a.lanes[l], b.lanes[l], d.lanes[l]);
+#endif
+}
+
+inline double reduce(const VectorRegister& a) {
+#if defined(__SSE2__)
+    const __m128d lo = _mm_load_pd(a.lanes);     // l0 l1
+    const __m128d hi = _mm_load_pd(a.lanes + 2); // l2 l3
+    const __m128d pairs = _mm_add_pd(_mm_unpacklo_pd(lo, hi), _mm_unpackhi_pd(lo, hi)); // l0+l1 l2+l3
+    return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+#else
+    return (a.lanes[0] + a.lanes[1]) + (a.lanes[2] + a.lanes[3]);
+#endif
+}
+
+inline void broadcast(VectorRegister& d, double value) {
+#if defined(__AVX__)
+    _mm256_store_pd(d.lanes, _mm256_set1_pd(value));
+#else
+    for (unsigned l = 0; l < VECTOR_LANES; ++l) d.lanes[l] = value;
+#endif
+}
+
+} // namespace vector_ops
@@ -0,0 +1,91 @@
+#ifndef CACHE_GEOMETRY_H
+#define CACHE_GEOMETRY_H
+
+#include <cstdint>
+#include <stdexcept>
+
+/*
+ Geometría de la caché y decodificación de direcciones (único camino de decodificación).
+ Dirección = | tag | index | offset |, con
+   offset = address % line_bytes
+   index  = (address / line_bytes) % sets
+   tag    = (address / line_bytes) / sets
+ Toda geometría expone la misma interfaz: sets(), ways(), line_bytes(),
+ index(), tag(), offset() y block_address(tag, index).
+*/
+
+constexpr bool is_power_of_two(uint64_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+constexpr unsigned log2_exact(uint64_t v) {
+    unsigned bits = 0;
+    while (v > 1) { v >>= 1; ++bits; }
+    return bits;
+}
+
+// Geometría fija en compilación: potencias de dos -> máscaras y desplazamientos constantes
+template <unsigned Sets, unsigned Ways, unsigned LineBytes>
+struct StaticGeometry {
+    static_assert(is_power_of_two(Sets), "Sets debe ser potencia de dos");
+    static_assert(is_power_of_two(LineBytes) && LineBytes >= 8, "LineBytes debe ser potencia de dos >= 8");
+    static_assert(Ways >= 1, "Ways debe ser >= 1");
+
+    static constexpr unsigned OFFSET_BITS = log2_exact(LineBytes);
+    static constexpr unsigned INDEX_BITS = log2_exact(Sets);
+
+    static constexpr unsigned sets() { return Sets; }
+    static constexpr unsigned ways() { return Ways; }
+    static constexpr unsigned line_bytes() { return LineBytes; }
+    static constexpr bool is_static() { return true; }
+
+    static constexpr uint64_t offset(uint64_t address) { return address & (LineBytes - 1); }
+    static constexpr uint64_t index(uint64_t address) { return (address >> OFFSET_BITS) & (Sets - 1); }
+    static constexpr uint64_t tag(uint64_t address) { return address >> (OFFSET_BITS + INDEX_BITS); }
+    static constexpr uint64_t block_address(uint64_t tag, uint64_t index) {
+        return ((tag << INDEX_BITS) | index) << OFFSET_BITS;
+    }
+};
+
+// Geometría configurada en ejecución: cualquier número de sets y vías,
+// líneas múltiplo de 8 bytes (una palabra de 64 bits). Con sets y líneas
+// potencia de dos decodifica con desplazamientos, como StaticGeometry, en
+// vez de dividir (cada búsqueda y cada snoop pasa por aquí)
+class DynamicGeometry {
+public:
+    DynamicGeometry(unsigned sets, unsigned ways, unsigned line_bytes)
+        : sets_(sets), ways_(ways), line_bytes_(line_bytes),
+          shifts_(is_power_of_two(sets) && is_power_of_two(line_bytes)),
+          offset_bits_(log2_exact(line_bytes)), index_bits_(log2_exact(sets)) {
+        if (sets == 0 || ways == 0) throw std::invalid_argument("DynamicGeometry: sets y ways deben ser > 0");
+        if (line_bytes < 8 || line_bytes % 8 != 0) {
+            throw std::invalid_argument("DynamicGeometry: line_bytes debe ser multiplo de 8");
+        }
+    }
+
+    unsigned sets() const { return sets_; }
+    unsigned ways() const { return ways_; }
+    unsigned line_bytes() const { return line_bytes_; }
+    static constexpr bool is_static() { return false; }
+
+    uint64_t offset(uint64_t address) const {
+        return shifts_ ? address & (line_bytes_ - 1) : address % line_bytes_;
+    }
+    uint64_t index(uint64_t address) const {
+        return shifts_ ? (address >> offset_bits_) & (sets_ - 1) : (address / line_bytes_) % sets_;
+    }
+    uint64_t tag(uint64_t address) const {
+        return shifts_ ? address >> (offset_bits_ + index_bits_) : (address / line_bytes_) / sets_;
+    }
+    uint64_t block_address(uint64_t tag, uint64_t index) const {
+        return shifts_ ? ((tag << index_bits_) | index) << offset_bits_ : (tag * sets_ + index) * line_bytes_;
+    }
+
+private:
+    unsigned sets_;
+    unsigned ways_;
+    unsigned line_bytes_;
+    bool shifts_;          // sets y line_bytes potencia de dos
+    unsigned offset_bits_; // válidos solo con shifts_
+    unsigned index_bits_;
+};
+
+#endif // CACHE_GEOMETRY_H
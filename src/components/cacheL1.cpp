@@ -1,216 +1,384 @@
 #include "cacheL1.h"
 #include <cstring>
+#include <stdexcept>
+#include "../utils/trace.h"
 
-CacheL1::CacheL1(int id, Memory* mem)
-        : id_(id), memory_(mem) {
-    // sets_ inicializado por defecto con CacheLine::CacheLine()
+template <class Geometry>
+BasicCacheL1<Geometry>::BasicCacheL1(int id, Memory* mem, Geometry geometry,
+                                     std::unique_ptr<ReplacementPolicy> policy,
+                                     CoherenceProtocol protocol)
+        : CacheL1(id, mem, protocol),
+          geo_(geometry),
+          tags_(geo_.sets(), geo_.ways()),
+          data_(static_cast<size_t>(geo_.sets()) * geo_.ways() * geo_.line_bytes(), 0),
+          policy_(policy ? std::move(policy) : make_replacement_policy(ReplacementKind::LRU, geo_.ways(), 0)) {
+    repl_state_.assign(geo_.sets(), policy_->initial_state());
+    metrics_.policy = policy_->name();
 }
 
 /* ------------------ helpers básicos ------------------ */
 
-CacheLine* CacheL1::find_line(uint64_t index, uint64_t tag) {
-    for (int w = 0; w < WAYS; ++w) {
-        CacheLine& ln = sets_[index][w];
-        if (ln.valid && ln.tag == tag) return &ln;
-    }
-    return nullptr;
+template <class Geometry>
+unsigned BasicCacheL1<Geometry>::select_victim(uint64_t index) {
+    // 1) primera vía inválida
+    const int free = tags_.first_invalid(index);
+    if (free >= 0) return static_cast<unsigned>(free);
+    // 2) set lleno: decide la política de reemplazo
+    metrics_.evictions++;
+    const unsigned victim = policy_->victim(repl_state_[index]);
+    drop_prefetch_mark(index, victim);
+    return victim;
 }
 
-CacheLine* CacheL1::select_victim(uint64_t index) {
-    // 1) buscar línea inválida
-    for (int w = 0; w < WAYS; ++w) {
-        if (!sets_[index][w].valid) return &sets_[index][w];
+template <class Geometry>
+void BasicCacheL1<Geometry>::writeback_if_dirty(uint64_t index, unsigned way) {
+    if (tags_.valid(index, way) && tags_.dirty(index, way)) {
+        uint64_t block_addr = geo_.block_address(tags_.tag(index, way), index);
+        MESI_TRACE(TraceEvent::CACHE_WRITEBACK, id_, block_addr, geo_.line_bytes());
+        metrics_.writebacks++;
+
+        if (!next_level_ || !next_level_->write_back(block_addr, line_data(index, way))) {
+            memory_->write_block(block_addr, line_data(index, way), geo_.line_bytes());
+        }
+        tags_.set_dirty(index, way, false);
     }
-    // 2) simple victim: way 0 (puedes mejorar con LRU más tarde)
-    return &sets_[index][0];
 }
 
-void CacheL1::writeback_if_dirty(CacheLine* line, uint64_t index) {
-    if (!line) return;
-    if (line->valid && line->dirty) {
-        uint64_t block_number = line->tag * SETS + index;
-        uint64_t block_addr = block_number * BLOCK_BYTES;
-
-        std::cout << "[WRITEBACK] Cache" << id_
-                  << " writing back dirty block @ 0x"
-                  << std::hex << block_addr << std::dec << " (32B)\n";
-
-        memory_->write_block(block_addr, reinterpret_cast<const uint64_t *>(line->data.data()));
-        line->dirty = false;
+template <class Geometry>
+void BasicCacheL1<Geometry>::evict(uint64_t index, unsigned way) {
+    if (!tags_.valid(index, way)) return;
+    metrics_.record_transition(tags_.state(index, way), MESI_State::INVALID);
+    if (!next_level_) {
+        writeback_if_dirty(index, way);
+        return;
+    }
+    // Con LLC toda víctima válida se le informa (exclusiva: también las limpias)
+    const bool dirty = tags_.dirty(index, way);
+    uint64_t block_addr = geo_.block_address(tags_.tag(index, way), index);
+    if (dirty) {
+        MESI_TRACE(TraceEvent::CACHE_WRITEBACK, id_, block_addr, geo_.line_bytes());
+        metrics_.writebacks++;
     }
+    next_level_->evict_from_l1(block_addr, line_data(index, way), dirty);
+    tags_.set_dirty(index, way, false);
+}
+
+template <class Geometry>
+unsigned BasicCacheL1<Geometry>::fill_from_memory(uint64_t index, uint64_t tag) {
+    const unsigned victim = select_victim(index);
+    evict(index, victim);
+    if (next_level_) next_level_->read_block(geo_.block_address(tag, index), line_data(index, victim));
+    else memory_->read_block(geo_.block_address(tag, index), line_data(index, victim), geo_.line_bytes());
+    tags_.fill(index, victim, tag, MESI_State::EXCLUSIVE);
+    metrics_.record_transition(MESI_State::INVALID, MESI_State::EXCLUSIVE);
+    note_fill(index, victim);
+    return victim;
 }
 
 
 /* ------------------ Operaciones CPU-facing ------------------ */
 
-void CacheL1::write(uint64_t address, uint64_t data64) { // cambiado firma
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
-    uint64_t offset = get_offset(address);
-
-    CacheLine* line = find_line(index, tag);
-    if (!line) {
-        metrics_.misses++;
-        CacheLine* victim = select_victim(index);
-        writeback_if_dirty(victim, index);
-        uint64_t block_addr = ((tag * SETS) + index) * BLOCK_BYTES;
-        memory_->read_block(block_addr, reinterpret_cast<uint64_t *>(victim->data.data()));
-        victim->valid = true;
-        victim->dirty = false;
-        victim->tag = tag;
-        victim->state = MESI_State::EXCLUSIVE;
-        line = victim;
-    } else {
-        metrics_.hits++;
+template <class Geometry>
+unsigned BasicCacheL1<Geometry>::lookup_for_access(uint64_t index, uint64_t tag, bool write) {
+    const int way = tags_.find(index, tag);
+    if (way < 0) {
+        metrics_.record_miss(write);
+        return fill_from_memory(index, tag);
     }
-    // escribir 8 bytes
-    std::memcpy(line->data.data() + offset, &data64, sizeof(uint64_t));
-    line->dirty = true;
-    line->state = MESI_State::MODIFIED;
-}
-
-uint64_t CacheL1::read(uint64_t address) { // cambiado firma
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
-    uint64_t offset = get_offset(address);
-
-    CacheLine* line = find_line(index, tag);
-    if (!line) {
-        metrics_.misses++;
-        CacheLine* victim = select_victim(index);
-        writeback_if_dirty(victim, index);
-        uint64_t block_addr = ((tag * SETS) + index) * BLOCK_BYTES;
-        memory_->read_block(block_addr, reinterpret_cast<uint64_t *>(victim->data.data()));
-        victim->valid = true;
-        victim->dirty = false;
-        victim->tag = tag;
-        victim->state = MESI_State::EXCLUSIVE;
-        line = victim;
-    } else {
-        metrics_.hits++;
+    metrics_.record_hit(write);
+    touch(index, way);
+    return static_cast<unsigned>(way);
+}
+
+template <class Geometry>
+unsigned BasicCacheL1<Geometry>::words_offset(uint64_t address, unsigned count) const {
+    const unsigned offset = static_cast<unsigned>(geo_.offset(address));
+    if (offset + count * sizeof(uint64_t) > geo_.line_bytes()) {
+        throw std::invalid_argument("CacheL1: el acceso de " + std::to_string(count) + " palabras en " +
+                                    std::to_string(address) + " cruza el fin de la línea");
     }
+    return offset;
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::write(uint64_t address, uint64_t data64) { // cambiado firma
+    uint64_t index = geo_.index(address);
+    const unsigned way = lookup_for_access(index, geo_.tag(address), true);
+    // escribir 8 bytes
+    std::memcpy(line_data(index, way) + geo_.offset(address), &data64, sizeof(uint64_t));
+    tags_.set_dirty(index, way, true);
+    change_state(index, way, MESI_State::MODIFIED);
+}
+
+template <class Geometry>
+uint64_t BasicCacheL1<Geometry>::read(uint64_t address) { // cambiado firma
+    uint64_t index = geo_.index(address);
+    const unsigned way = lookup_for_access(index, geo_.tag(address), false);
     uint64_t out64 = 0;
-    std::memcpy(&out64, line->data.data() + offset, sizeof(uint64_t));
+    std::memcpy(&out64, line_data(index, way) + geo_.offset(address), sizeof(uint64_t));
     return out64;
 }
 
+template <class Geometry>
+uint64_t BasicCacheL1<Geometry>::read_filled(uint64_t address) {
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0) throw std::logic_error("CacheL1::read_filled: la línea no fue entregada por el Bus");
+    uint64_t out64 = 0;
+    std::memcpy(&out64, line_data(index, way) + geo_.offset(address), sizeof(uint64_t));
+    return out64;
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::write_filled(uint64_t address, uint64_t data64) {
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0) throw std::logic_error("CacheL1::write_filled: la línea no fue entregada por el Bus");
+    std::memcpy(line_data(index, way) + geo_.offset(address), &data64, sizeof(uint64_t));
+    tags_.set_dirty(index, way, true);
+    change_state(index, way, MESI_State::MODIFIED);
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::read_words(uint64_t address, uint64_t* out, unsigned count) {
+    const unsigned offset = words_offset(address, count);
+    const uint64_t index = geo_.index(address);
+    const unsigned way = lookup_for_access(index, geo_.tag(address), false);
+    std::memcpy(out, line_data(index, way) + offset, count * sizeof(uint64_t));
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::write_words(uint64_t address, const uint64_t* in, unsigned count) {
+    const unsigned offset = words_offset(address, count);
+    const uint64_t index = geo_.index(address);
+    const unsigned way = lookup_for_access(index, geo_.tag(address), true);
+    std::memcpy(line_data(index, way) + offset, in, count * sizeof(uint64_t));
+    tags_.set_dirty(index, way, true);
+    change_state(index, way, MESI_State::MODIFIED);
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::read_filled_words(uint64_t address, uint64_t* out, unsigned count) {
+    const unsigned offset = words_offset(address, count);
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0) throw std::logic_error("CacheL1::read_filled_words: la línea no fue entregada por el Bus");
+    std::memcpy(out, line_data(index, way) + offset, count * sizeof(uint64_t));
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::write_filled_words(uint64_t address, const uint64_t* in, unsigned count) {
+    const unsigned offset = words_offset(address, count);
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0) throw std::logic_error("CacheL1::write_filled_words: la línea no fue entregada por el Bus");
+    std::memcpy(line_data(index, way) + offset, in, count * sizeof(uint64_t));
+    tags_.set_dirty(index, way, true);
+    change_state(index, way, MESI_State::MODIFIED);
+}
+
 /* --------------- Métodos que usará el Bus (Snooping) ------------- */
 
 /*
  BusRd (read broadcast)
- - Si la cache tiene la línea en M -> debe indicar had_modified=true y pasar a S (y el Bus/Memory coordinará writeback).
- - Si la cache tiene E -> pasar a S, had_shared=true.
- - Si la cache tiene S -> had_shared=true.
+ - M -> entrega el bloque (had_modified). MESI/MESIF: pasa a S y el Bus hace el write-back.
+        MOESI: pasa a O y sigue sucia (dirty_retained, sin write-back).
+ - O -> (MOESI) entrega el bloque sucio y sigue en O.
+ - E -> pasa a S, had_shared=true. Con MESIF además entrega el bloque limpio.
+ - F -> (MESIF) entrega el bloque limpio y pasa a S; el solicitante queda en F.
+ - S -> had_shared=true.
  - Si I -> no participa.
 */
-CacheL1::BusSnoopResult CacheL1::snoop_bus_rd(uint64_t address) {
+template <class Geometry>
+CacheL1::BusSnoopResult BasicCacheL1<Geometry>::snoop_bus_rd(uint64_t address, uint8_t* block_out) {
     BusSnoopResult res;
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
-    CacheLine* line = find_line(index, tag);
-    
-    if (!line) return res;
-
-    if (line->state == MESI_State::MODIFIED) {
-        // debe suministrar datos (writeback o supply via bus)
-        res.had_modified = true;
-        std::memcpy(res.data.data(), line->data.data(), BLOCK_BYTES);
-        // según MESI, tras BusRd una cache con M pasa a S (y hace writeback)
-        line->state = MESI_State::SHARED;
-        // la línea sigue válida; dirty se limpia una vez que el bus/mem haga writeback
-        line->dirty = false;
-    } else if (line->state == MESI_State::EXCLUSIVE || line->state == MESI_State::SHARED) {
-        res.had_shared = true;
-        if (line->state == MESI_State::EXCLUSIVE) {
-            line->state = MESI_State::SHARED;
-        }
-    } 
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+
+    metrics_.snoops++;
+    if (way < 0) return res;
+    metrics_.snoop_hits++;
+
+    switch (tags_.state(index, way)) {
+        case MESI_State::MODIFIED:
+        case MESI_State::OWNED:
+            // debe suministrar datos (writeback o supply via bus)
+            res.had_modified = true;
+            res.supplied = true;
+            std::memcpy(block_out, line_data(index, way), geo_.line_bytes());
+            if (protocol_ == CoherenceProtocol::MOESI) {
+                // sigue siendo la dueña de la línea sucia: la escribirá al desalojarla
+                res.dirty_retained = true;
+                change_state(index, way, MESI_State::OWNED);
+            } else {
+                // según MESI, tras BusRd una cache con M pasa a S (y el Bus hace writeback)
+                change_state(index, way, MESI_State::SHARED);
+                tags_.set_dirty(index, way, false);
+            }
+            break;
+        case MESI_State::EXCLUSIVE:
+        case MESI_State::FORWARD:
+            res.had_shared = true;
+            if (protocol_ == CoherenceProtocol::MESIF) {
+                res.supplied = true;
+                std::memcpy(block_out, line_data(index, way), geo_.line_bytes());
+            }
+            change_state(index, way, MESI_State::SHARED);
+            break;
+        case MESI_State::SHARED:
+            res.had_shared = true;
+            break;
+        default:
+            break;
+    }
+    if (res.supplied) metrics_.snoop_supplied++;
     return res;
 }
 
 /*
  BusRdX (read for ownership / write intent)
- - Todas las caches que tengan la línea en S/E/M deben invalidarla (I).
- - Si alguna tenía M -> had_modified=true y debe hacer writeback.
+ - Todas las caches que tengan la línea en S/E/F/O/M deben invalidarla (I).
+ - Si alguna tenía M/O -> had_modified=true y entrega el bloque. Con MOESI el
+   solicitante queda en M con el dato sucio (dirty_retained); si no, el Bus hace writeback.
+ - Con MESIF la copia en E/F entrega el bloque limpio.
 */
-CacheL1::BusSnoopResult CacheL1::snoop_bus_rdx(uint64_t address) {
+template <class Geometry>
+CacheL1::BusSnoopResult BasicCacheL1<Geometry>::snoop_bus_rdx(uint64_t address, uint8_t* block_out) {
     BusSnoopResult res;
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
-    CacheLine* line = find_line(index, tag);
-    if (!line) return res;
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    metrics_.snoops++;
+    if (way < 0) return res;
 
-    if (line->state == MESI_State::MODIFIED) {
+    const MESI_State state = tags_.state(index, way);
+    if (state == MESI_State::MODIFIED || state == MESI_State::OWNED) {
         res.had_modified = true;
-        std::memcpy(res.data.data(), line->data.data(), BLOCK_BYTES);
-        // writeback required: we'll mark dirty->false and invalidate
-        line->dirty = false;
-        line->state = MESI_State::INVALID;
-        line->valid = false;
-        metrics_.invalidations++;
-    } else if (line->state == MESI_State::EXCLUSIVE || line->state == MESI_State::SHARED) {
+        res.supplied = true;
+        res.dirty_retained = protocol_ == CoherenceProtocol::MOESI;
+        std::memcpy(block_out, line_data(index, way), geo_.line_bytes());
+    } else if (state != MESI_State::INVALID) {
         res.had_shared = true;
-        // invalidate
-        line->state = MESI_State::INVALID;
-        line->valid = false;
-        metrics_.invalidations++;
+        if (protocol_ == CoherenceProtocol::MESIF &&
+            (state == MESI_State::EXCLUSIVE || state == MESI_State::FORWARD)) {
+            res.supplied = true;
+            std::memcpy(block_out, line_data(index, way), geo_.line_bytes());
+        }
+    } else {
+        return res;
     }
+    metrics_.snoop_hits++;
+    if (res.supplied) metrics_.snoop_supplied++;
+    // invalidate
+    drop_prefetch_mark(index, way);
+    metrics_.record_transition(state, MESI_State::INVALID);
+    tags_.invalidate(index, way);
+    metrics_.invalidations++;
     return res;
 }
 
 /*
- El Bus entrega el bloque resultante a la cache solicitante.
- Si others_have==false => nadie más lo tenía (EXCLUSIVE)
- Si others_have==true  => alguien más lo tenía (SHARED)
+ El Bus entrega el bloque resultante a la cache solicitante en fill_state
+ (EXCLUSIVE si nadie más lo tenía; SHARED o FORWARD si alguien más lo tiene).
 */
-void CacheL1::load_block_from_bus(uint64_t address, const uint8_t* block32, bool others_have) {
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
+template <class Geometry>
+void BasicCacheL1<Geometry>::load_block_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state,
+                                                 bool write) {
+    uint64_t index = geo_.index(address);
+    uint64_t tag = geo_.tag(address);
 
-    CacheLine* victim = select_victim(index);
-    writeback_if_dirty(victim, index);
+    const int present = tags_.find(index, tag);
+    if (present >= 0) {
+        // Una copia válida local siempre está al día: no se sobrescribe.
+        // M y O conservan su estado (son las dueñas del dato sucio).
+        // Si la trajo un prefetch tardío, el acceso ya se contó como tardío y no como útil.
+        metrics_.record_hit(write);
+        touch(index, present);
+        tags_.set_prefetched(index, present, false);
+        const MESI_State state = tags_.state(index, present);
+        if (state != MESI_State::MODIFIED && state != MESI_State::OWNED) {
+            change_state(index, present, fill_state);
+        }
+        return;
+    }
+    if (!block) throw std::logic_error("CacheL1::load_block_from_bus: upgrade sin la línea presente");
+    metrics_.record_miss(write);
+    fill_line(index, select_victim(index), tag, block, fill_state);
+}
+
+/*
+ Bloque pedido por el prefetcher. Si la línea llegó antes a demanda se descarta.
+ Si desaloja una línea válida, esta se recuerda para medir contaminación.
+*/
+template <class Geometry>
+void BasicCacheL1<Geometry>::load_prefetch_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state) {
+    const uint64_t line = line_address(address);
+    prefetch_in_flight_.erase(line);
+    evicted_by_prefetch_.erase(line);
+
+    uint64_t index = geo_.index(address);
+    uint64_t tag = geo_.tag(address);
+    if (tags_.find(index, tag) >= 0) return;
+
+    const unsigned victim = select_victim(index);
+    if (tags_.valid(index, victim)) {
+        if (evicted_by_prefetch_.size() >= POLLUTION_TRACKING_LIMIT) evicted_by_prefetch_.clear();
+        evicted_by_prefetch_.insert(geo_.block_address(tags_.tag(index, victim), index));
+    }
+    fill_line(index, victim, tag, block, fill_state);
+    tags_.set_prefetched(index, victim, true);
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::fill_line(uint64_t index, unsigned way, uint64_t tag, const uint8_t* block,
+                                       MESI_State fill_state) {
+    evict(index, way);
 
     // cargar bloque
-    std::memcpy(victim->data.data(), block32, BLOCK_BYTES);
-    victim->valid = true;
-    victim->dirty = false;
-    victim->tag = tag;
-    victim->state = others_have ? MESI_State::SHARED : MESI_State::EXCLUSIVE;
+    std::memcpy(line_data(index, way), block, geo_.line_bytes());
+    tags_.fill(index, way, tag, fill_state);
+    metrics_.record_transition(MESI_State::INVALID, fill_state);
+    note_fill(index, way);
 }
 
 /*
  Invalidar localmente (invocado por el bus para mantener coherencia)
 */
-void CacheL1::invalidate_line(uint64_t address) {
-    uint64_t index = get_index(address);
-    uint64_t tag = get_tag(address);
-    CacheLine* line = find_line(index, tag);
-    if (!line) return;
-    line->valid = false;
-    line->dirty = false;
-    line->state = MESI_State::INVALID;
+template <class Geometry>
+bool BasicCacheL1<Geometry>::invalidate_line(uint64_t address) {
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0) return false;
+    drop_prefetch_mark(index, way);
+    metrics_.record_transition(tags_.state(index, way), MESI_State::INVALID);
+    tags_.invalidate(index, way);
     metrics_.invalidations++;
+    return true;
+}
+
+template <class Geometry>
+bool BasicCacheL1<Geometry>::take_prefetched_mark(uint64_t address) {
+    const uint64_t index = geo_.index(address);
+    const int way = tags_.find(index, geo_.tag(address));
+    if (way < 0 || !tags_.prefetched(index, way)) return false;
+    tags_.set_prefetched(index, way, false);
+    return true;
 }
 
 /* ---------------- Debug / inspección ---------------- */
 
-MESI_State CacheL1::get_line_state(uint64_t address) const {
-    uint64_t index = (address >> 5) & 0x7;
-    uint64_t tag = (address >> 8);
-    for (int w=0;w<WAYS; ++w) {
-        const CacheLine& ln = sets_[index][w];
-        if (ln.valid && ln.tag == tag) return ln.state;
-    }
-    return MESI_State::INVALID;
+template <class Geometry>
+MESI_State BasicCacheL1<Geometry>::get_line_state(uint64_t address) const {
+    return tags_.lookup_state(geo_.index(address), geo_.tag(address));
 }
 
-void CacheL1::print_cache_lines() const {
-    std::cout << "Cache" << id_ << " contents:\n";
-    for (int i=0;i<SETS;i++) {
-        std::cout << " Set " << i << ":\n";
-        for (int w=0; w<WAYS; ++w) {
-            const CacheLine& ln = sets_[i][w];
-            std::cout << "  Way" << w << ": valid=" << ln.valid
+template <class Geometry>
+void BasicCacheL1<Geometry>::print_cache_lines(std::ostream& out) const {
+    out << "Cache" << id_ << " contents:\n";
+    for (unsigned i = 0; i < geo_.sets(); i++) {
+        out << " Set " << i << ":\n";
+        for (unsigned w = 0; w < geo_.ways(); ++w) {
+            const CacheLine ln = tags_.line(i, w);
+            out << "  Way" << w << ": valid=" << ln.valid
                       << " dirty=" << ln.dirty
                       << " tag=" << ln.tag
                       << " state=" << static_cast<int>(ln.state) << "\n";
@@ -218,17 +386,161 @@ void CacheL1::print_cache_lines() const {
     }
 }
 
-void CacheL1::print_metrics() const {
-    metrics_.print(id_);
+template <class Geometry>
+void BasicCacheL1<Geometry>::flush() {
+    for (unsigned idx = 0; idx < geo_.sets(); ++idx) {
+        for (unsigned w = 0; w < geo_.ways(); ++w) {
+            writeback_if_dirty(idx, w);
+        }
+    }
 }
 
-void CacheL1::flush() {
-    for (int idx=0; idx<SETS; ++idx) {
-        for (int w=0; w<WAYS; ++w) {
-            CacheLine* line = &sets_[idx][w];
-            if (line->valid && line->dirty) {
-                writeback_if_dirty(line, idx);
+/* ---------------- Checkpoint ---------------- */
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::save_lines(LineSnapshot* lines, uint64_t* replacement, uint8_t* data) const {
+    for (unsigned idx = 0; idx < geo_.sets(); ++idx) {
+        replacement[idx] = repl_state_[idx];
+        for (unsigned w = 0; w < geo_.ways(); ++w) {
+            const CacheLine ln = tags_.line(idx, w);
+            LineSnapshot& out = lines[static_cast<size_t>(idx) * geo_.ways() + w];
+            out = LineSnapshot{};
+            out.tag = ln.tag;
+            out.state = static_cast<uint8_t>(ln.state);
+            out.valid = ln.valid;
+            out.dirty = ln.dirty;
+            out.prefetched = ln.prefetched;
+        }
+    }
+    std::memcpy(data, data_.data(), data_.size());
+}
+
+template <class Geometry>
+void BasicCacheL1<Geometry>::restore_lines(const LineSnapshot* lines, const uint64_t* replacement,
+                                           const uint8_t* data) {
+    for (unsigned idx = 0; idx < geo_.sets(); ++idx) {
+        repl_state_[idx] = replacement ? replacement[idx] : policy_->initial_state();
+        for (unsigned w = 0; w < geo_.ways(); ++w) {
+            const LineSnapshot& in = lines[static_cast<size_t>(idx) * geo_.ways() + w];
+            if (!in.valid) {
+                tags_.invalidate(idx, w);
+                continue;
+            }
+            const MESI_State state = static_cast<MESI_State>(in.state);
+            if (in.state > static_cast<uint8_t>(MESI_State::FORWARD) || state == MESI_State::INVALID) {
+                throw std::runtime_error("CacheL1::restore_lines: estado invalido en el set " + std::to_string(idx));
             }
+            tags_.fill(idx, w, in.tag, state);
+            tags_.set_dirty(idx, w, in.dirty);
+            tags_.set_prefetched(idx, w, in.prefetched);
         }
     }
-}
\ No newline at end of file
+    std::memcpy(data_.data(), data, data_.size());
+}
+
+template <class Geometry>
+std::vector<uint64_t> BasicCacheL1<Geometry>::resident_lines() const {
+    std::vector<uint64_t> lines;
+    for (unsigned idx = 0; idx < geo_.sets(); ++idx) {
+        for (unsigned w = 0; w < geo_.ways(); ++w) {
+            if (tags_.valid(idx, w)) lines.push_back(geo_.block_address(tags_.tag(idx, w), idx));
+        }
+    }
+    return lines;
+}
+
+/* ---------------- Métricas (base) ---------------- */
+
+void CacheL1::export_metrics(MetricsRegistry& registry) const {
+    const std::string name = "cache" + std::to_string(id_);
+    const Metrics& m = metrics_;
+    registry.counter(name, "hits", m.hits);
+    registry.counter(name, "misses", m.misses);
+    registry.counter(name, "read_hits", m.read_hits);
+    registry.counter(name, "read_misses", m.read_misses);
+    registry.counter(name, "write_hits", m.write_hits);
+    registry.counter(name, "write_misses", m.write_misses);
+    registry.counter(name, "invalidations", m.invalidations);
+    registry.counter(name, "evictions", m.evictions);
+    registry.counter(name, "writebacks", m.writebacks);
+    registry.counter(name, "snoops", m.snoops);
+    registry.counter(name, "snoop_hits", m.snoop_hits);
+    registry.counter(name, "snoop_supplied", m.snoop_supplied);
+    if (prefetcher_) {
+        registry.counter(name, "prefetch_issued", m.prefetch_issued);
+        registry.counter(name, "prefetch_dropped", m.prefetch_dropped);
+        registry.counter(name, "prefetch_useful", m.prefetch_useful);
+        registry.counter(name, "prefetch_late", m.prefetch_late);
+        registry.counter(name, "prefetch_useless", m.prefetch_useless);
+        registry.counter(name, "prefetch_pollution", m.prefetch_pollution);
+    }
+    registry.gauge(name, "miss_rate", m.miss_rate());
+
+    std::vector<std::string> states;
+    std::vector<uint64_t> cells;
+    for (unsigned from = 0; from < Metrics::STATES; ++from) {
+        states.push_back(mesi_state_letter(static_cast<MESI_State>(from)));
+        for (unsigned to = 0; to < Metrics::STATES; ++to) cells.push_back(m.transitions[from][to]);
+    }
+    registry.matrix(name, "transitions", states, cells);
+}
+
+/* ---------------- Prefetch (base) ---------------- */
+
+const std::vector<uint64_t>& CacheL1::on_demand_access(uint64_t address, uint32_t pc, bool hit) {
+    const uint64_t line = line_address(address);
+    prefetch_candidates_.clear();
+    bool prefetched_hit = false;
+    if (hit) {
+        prefetched_hit = take_prefetched_mark(address);
+        if (prefetched_hit) metrics_.prefetch_useful++;
+    } else {
+        // La demanda ya pide la línea: el prefetch aún en cola se cancela
+        if (prefetch_in_flight_.erase(line)) metrics_.prefetch_late++;
+        if (evicted_by_prefetch_.erase(line)) metrics_.prefetch_pollution++;
+    }
+    if (prefetcher_) prefetcher_->on_access(line, pc, !hit, prefetched_hit, prefetch_candidates_);
+    return prefetch_candidates_;
+}
+
+void CacheL1::note_prefetch_issued(uint64_t address) {
+    prefetch_in_flight_.insert(line_address(address));
+    metrics_.prefetch_issued++;
+}
+
+void CacheL1::note_prefetch_dropped(uint64_t address) {
+    prefetch_in_flight_.erase(line_address(address));
+    metrics_.prefetch_dropped++;
+}
+
+/* ---------------- Instanciaciones y fábrica ---------------- */
+
+#define CACHE_L1_INSTANTIATE_SHAPE(S, W, L) template class BasicCacheL1<StaticGeometry<S, W, L>>;
+CACHE_L1_STATIC_SHAPES(CACHE_L1_INSTANTIATE_SHAPE)
+#undef CACHE_L1_INSTANTIATE_SHAPE
+template class BasicCacheL1<DynamicGeometry>;
+
+CoherenceProtocol parse_coherence_protocol(const std::string& name) {
+    if (name == "mesi") return CoherenceProtocol::MESI;
+    if (name == "moesi") return CoherenceProtocol::MOESI;
+    if (name == "mesif") return CoherenceProtocol::MESIF;
+    throw std::invalid_argument("Protocolo de coherencia desconocido: " + name);
+}
+
+std::unique_ptr<CacheL1> make_cache_l1(int id, Memory* mem, const CacheConfig& config) {
+    std::unique_ptr<ReplacementPolicy> policy =
+        make_replacement_policy(config.replacement, config.ways, config.seed + static_cast<uint64_t>(id));
+#define CACHE_L1_MATCH_SHAPE(S, W, L) \
+    if (config.sets == S && config.ways == W && config.line_bytes == L) { \
+        cache = std::make_unique<BasicCacheL1<StaticGeometry<S, W, L>>>(id, mem, StaticGeometry<S, W, L>{}, std::move(policy), config.protocol); \
+    }
+    std::unique_ptr<CacheL1> cache;
+    CACHE_L1_STATIC_SHAPES(CACHE_L1_MATCH_SHAPE)
+#undef CACHE_L1_MATCH_SHAPE
+    if (!cache) {
+        cache = std::make_unique<BasicCacheL1<DynamicGeometry>>(
+            id, mem, DynamicGeometry(config.sets, config.ways, config.line_bytes), std::move(policy), config.protocol);
+    }
+    cache->set_prefetcher(make_prefetcher(config.prefetch, config.line_bytes));
+    return cache;
+}
@@ -3,72 +3,270 @@
 
 #include <cstdint>
 #include <array>
+#include <vector>
+#include <memory>
 #include <iostream>
+#include <string>
+#include <unordered_set>
 #include "memory.h"
 #include "../interconnect/BusEnums.h"
 #include "../utils/metrics.h"
+#include "../utils/metricsRegistry.h"
 #include "cacheLine.h"
+#include "tagStore.h"
+#include "cacheGeometry.h"
+#include "replacementPolicy.h"
+#include "prefetcher.h"
+#include "llc.h"
 
+// Forma de la caché (para construirla con make_cache_l1)
+struct CacheConfig {
+    unsigned sets = 8;        // 8 sets
+    unsigned ways = 2;        // 2-way
+    unsigned line_bytes = 32; // línea completa de 32 bytes
+    ReplacementKind replacement = ReplacementKind::LRU;
+    uint64_t seed = 1;        // semilla de políticas aleatorias (se combina con el id de la caché)
+    CoherenceProtocol protocol = CoherenceProtocol::MESI;
+    PrefetchConfig prefetch;  // sin prefetcher por defecto
+};
+
+// "mesi", "moesi", "mesif"
+CoherenceProtocol parse_coherence_protocol(const std::string& name);
+
+// Interfaz de la caché L1 privada de cada PE (la usan el Bus y la MemoryFacade).
+// La implementación es BasicCacheL1<Geometry>; ver make_cache_l1.
 class CacheL1 {
 public:
-    CacheL1(int id, Memory* mem);
+    virtual ~CacheL1() = default;
 
     // API simple: leer/escribir 8 bytes (palabra de 64-bit)
-    void write(uint64_t address, uint64_t data64); // cambiado
-    uint64_t read(uint64_t address);               // cambiado
+    virtual void write(uint64_t address, uint64_t data64) = 0; // cambiado
+    virtual uint64_t read(uint64_t address) = 0;               // cambiado
+
+    // Acceso a una línea que el Bus acaba de entregar (load_block_from_bus ya
+    // contabilizó el hit/miss). Lanza std::logic_error si la línea no está presente.
+    virtual uint64_t read_filled(uint64_t address) = 0;
+    virtual void write_filled(uint64_t address, uint64_t data64) = 0;
+
+    // 'count' palabras consecutivas de una misma línea en un solo acceso (VLOAD/VSTORE), con
+    // las reglas de read/write y read_filled/write_filled. Lanza std::invalid_argument si
+    // el rango cruza el fin de la línea.
+    virtual void read_words(uint64_t address, uint64_t* out, unsigned count) = 0;
+    virtual void write_words(uint64_t address, const uint64_t* in, unsigned count) = 0;
+    virtual void read_filled_words(uint64_t address, uint64_t* out, unsigned count) = 0;
+    virtual void write_filled_words(uint64_t address, const uint64_t* in, unsigned count) = 0;
 
     // --- MESI / Bus-facing iface (para que el Bus llame) ---
     // Resultado de snooping
     struct BusSnoopResult {
-        bool had_modified = false;   // había M -> requiere writeback
-        bool had_shared = false;     // había S/E
-        std::array<uint8_t,32> data; // si had_modified==true, incluye el bloque que tenía la cache
+        bool had_modified = false;   // había M/O -> entrega el bloque sucio (requiere writeback salvo dirty_retained)
+        bool had_shared = false;     // había S/E/F
+        bool supplied = false;       // block_out tiene el bloque (transferencia caché a caché)
+        bool dirty_retained = false; // MOESI: el dato sucio sigue en caché (O aquí o M en el solicitante)
     };
 
     // Snooping: cuando el bus difunde un BusRd (Read)
-    BusSnoopResult snoop_bus_rd(uint64_t address);
+    // Si supplied==true, block_out recibe el bloque (line_bytes() bytes) que tenía la cache
+    virtual BusSnoopResult snoop_bus_rd(uint64_t address, uint8_t* block_out) = 0;
 
     // Snooping: cuando el bus difunde un BusRdX (Read for Ownership / Write)
-    BusSnoopResult snoop_bus_rdx(uint64_t address);
+    virtual BusSnoopResult snoop_bus_rdx(uint64_t address, uint8_t* block_out) = 0;
 
-    // El bus entrega un bloque (ya sea traído de memoria o de otra cache)
-    // others_have=true si alguna otra cache tenía la línea (entonces es SHARED), false si nadie la tenía (entonces EXCLUSIVE)
-    void load_block_from_bus(uint64_t address, const uint8_t* block32, bool others_have);
+    // El bus entrega un bloque (ya sea traído de memoria o de otra cache) en fill_state:
+    // EXCLUSIVE si nadie más la tenía, SHARED (o FORWARD con MESIF) si otra caché la tiene.
+    // Si la línea ya estaba presente se conserva su dato (es la copia vigente) y solo se ajusta el estado.
+    // En un upgrade (BusUpgr) no viaja el bloque: block es nullptr y la línea debe estar presente
+    // (lanza std::logic_error si no lo está). write indica si el acceso que la pidió es un store
+    // (BusRdX/BusUpgr), para separar los hits/misses de lectura y escritura.
+    virtual void load_block_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state,
+                                     bool write) = 0;
 
-    // Invalidar línea local (invocado por bus en BusRdX o Invalidate)
-    void invalidate_line(uint64_t address);
+    // El bus entrega un bloque precargado: solo se instala (marcado) si la línea no está presente
+    virtual void load_prefetch_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state) = 0;
+
+    // Invalidar línea local (invocado por bus en BusRdX o Invalidate); true si la tenía
+    virtual bool invalidate_line(uint64_t address) = 0;
 
     // Debug / inspección
-    MESI_State get_line_state(uint64_t address) const;
-    void print_cache_lines() const;
+    virtual MESI_State get_line_state(uint64_t address) const = 0;
+    virtual void print_cache_lines(std::ostream& out = std::cout) const = 0;
+
+    void print_metrics(std::ostream& out = std::cout) const { metrics_.print(id_, out); }
+    const Metrics& metrics() const { return metrics_; }
+    // Copia los contadores, el split lectura/escritura y la matriz de transiciones como "cache<id>"
+    void export_metrics(MetricsRegistry& registry) const;
+    int id() const { return id_; }
+
+    // Geometría
+    virtual unsigned sets() const = 0;
+    virtual unsigned ways() const = 0;
+    virtual unsigned line_bytes() const = 0;
+    virtual bool has_static_geometry() const = 0; // decodificación especializada en compilación
+
+    CoherenceProtocol protocol() const { return protocol_; }
 
-    void print_metrics() const;
+    // --- Prefetch (lo usan la MemoryFacade y el Bus) ---
+    void set_prefetcher(std::unique_ptr<Prefetcher> prefetcher) { prefetcher_ = std::move(prefetcher); }
+    const Prefetcher* prefetcher() const { return prefetcher_.get(); }
+    // Acceso a demanda (hit = la línea estaba válida): cuenta prefetches útiles/tardíos y la
+    // contaminación, y retorna las líneas que propone el prefetcher (válido hasta la próxima llamada)
+    const std::vector<uint64_t>& on_demand_access(uint64_t address, uint32_t pc, bool hit);
+    bool prefetch_in_flight(uint64_t address) const { return prefetch_in_flight_.count(line_address(address)) != 0; }
+    void note_prefetch_issued(uint64_t address);
+    void note_prefetch_dropped(uint64_t address); // el Bus no la emitió (ya presente o en vuelo)
 
-    static constexpr int BLOCK_BYTES = 32; // línea completa de 32 bytes
+    // Caché compartida detrás del Bus (nullptr = los write-backs van directo a Memoria)
+    void set_next_level(SharedLLC* llc) { next_level_ = llc; }
+
+    static constexpr int BLOCK_BYTES = 32; // tamaño de línea por defecto (CacheConfig)
 
     // Forzar write-back de todas las líneas sucias (flush al finalizar)
-    void flush();
+    virtual void flush() = 0;
+
+    // --- Checkpoint (sim/Checkpoint.h) ---
+    // Copia los metadatos (sets*ways, set por set), el estado de reemplazo (uno por set) y los
+    // datos (sets*ways*line_bytes) de todas las vías
+    virtual void save_lines(LineSnapshot* lines, uint64_t* replacement, uint8_t* data) const = 0;
+    // Instala un estado guardado con la misma geometría; con replacement == nullptr los sets
+    // vuelven al estado inicial de la política. Lanza std::runtime_error si una vía es inválida.
+    // Los prefetches en vuelo y las métricas no se tocan.
+    virtual void restore_lines(const LineSnapshot* lines, const uint64_t* replacement, const uint8_t* data) = 0;
+    // Direcciones de las líneas válidas
+    virtual std::vector<uint64_t> resident_lines() const = 0;
+
+protected:
+    CacheL1(int id, Memory* mem, CoherenceProtocol protocol)
+        : id_(id), memory_(mem), protocol_(protocol) {}
 
-private:
     int id_;
     Memory* memory_;
+    CoherenceProtocol protocol_;
     Metrics metrics_;
+    SharedLLC* next_level_ = nullptr;
 
-    static constexpr int SETS = 8;      // 8 sets
-    static constexpr int WAYS = 2;      // 2-way
+    // Líneas desalojadas por un prefetch que se siguen para medir contaminación (acotado)
+    static constexpr size_t POLLUTION_TRACKING_LIMIT = 4096;
 
-    std::array<std::array<CacheLine, WAYS>, SETS> sets_;
+    std::unique_ptr<Prefetcher> prefetcher_;
+    std::unordered_set<uint64_t> prefetch_in_flight_;  // direcciones de línea
+    std::unordered_set<uint64_t> evicted_by_prefetch_; // direcciones de línea
+    std::vector<uint64_t> prefetch_candidates_;
+
+    uint64_t line_address(uint64_t address) const { return address - address % line_bytes(); }
+    // true si la línea estaba marcada como precargada (y borra la marca)
+    virtual bool take_prefetched_mark(uint64_t address) = 0;
+};
+
+// Caché L1 con la geometría como parámetro de plantilla (StaticGeometry o DynamicGeometry).
+// Los metadatos viven en un TagStore (tags y estados por set, comparados con SIMD) y los
+// datos en un arreglo contiguo aparte, set por set.
+template <class Geometry>
+class BasicCacheL1 final : public CacheL1 {
+public:
+    // policy == nullptr -> LRU
+    BasicCacheL1(int id, Memory* mem, Geometry geometry = Geometry{},
+                 std::unique_ptr<ReplacementPolicy> policy = nullptr,
+                 CoherenceProtocol protocol = CoherenceProtocol::MESI);
 
-    // helpers de direccionamiento
-    inline uint64_t get_index(uint64_t address) const { return (address >> 5) & 0x7; } // bits [5..7]
-    inline uint64_t get_tag(uint64_t address) const { return (address >> 8); }        // resto arriba de bit 8
-    inline uint64_t get_offset(uint64_t address) const { return address & 0x1F; }      // 5 bits
+    void write(uint64_t address, uint64_t data64) override;
+    uint64_t read(uint64_t address) override;
+    uint64_t read_filled(uint64_t address) override;
+    void write_filled(uint64_t address, uint64_t data64) override;
+    void read_words(uint64_t address, uint64_t* out, unsigned count) override;
+    void write_words(uint64_t address, const uint64_t* in, unsigned count) override;
+    void read_filled_words(uint64_t address, uint64_t* out, unsigned count) override;
+    void write_filled_words(uint64_t address, const uint64_t* in, unsigned count) override;
 
-    CacheLine* find_line(uint64_t index, uint64_t tag);
-    CacheLine* select_victim(uint64_t index);
+    BusSnoopResult snoop_bus_rd(uint64_t address, uint8_t* block_out) override;
+    BusSnoopResult snoop_bus_rdx(uint64_t address, uint8_t* block_out) override;
+    void load_block_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state, bool write) override;
+    void load_prefetch_from_bus(uint64_t address, const uint8_t* block, MESI_State fill_state) override;
+    bool invalidate_line(uint64_t address) override;
 
-    // Cuando se reemplaza una línea sucia -> write-back a memoria
-    void writeback_if_dirty(CacheLine* line, uint64_t index);
+    MESI_State get_line_state(uint64_t address) const override;
+    void print_cache_lines(std::ostream& out = std::cout) const override;
+
+    unsigned sets() const override { return geo_.sets(); }
+    unsigned ways() const override { return geo_.ways(); }
+    unsigned line_bytes() const override { return geo_.line_bytes(); }
+    bool has_static_geometry() const override { return Geometry::is_static(); }
+
+    void flush() override;
+
+    void save_lines(LineSnapshot* lines, uint64_t* replacement, uint8_t* data) const override;
+    void restore_lines(const LineSnapshot* lines, const uint64_t* replacement, const uint8_t* data) override;
+    std::vector<uint64_t> resident_lines() const override;
+
+private:
+    bool take_prefetched_mark(uint64_t address) override;
+    Geometry geo_;
+    TagStore tags_;                // metadatos por set (SoA), separados de los datos
+    std::vector<uint8_t> data_;    // sets * ways * line_bytes datos
+    std::unique_ptr<ReplacementPolicy> policy_;
+    std::vector<uint64_t> repl_state_; // una palabra de estado de reemplazo por set
+
+    void touch(uint64_t index, unsigned way) { policy_->on_hit(repl_state_[index], way); }
+    // Cambia el estado de una línea válida y lo cuenta en la matriz de transiciones
+    void change_state(uint64_t index, unsigned way, MESI_State state) {
+        metrics_.record_transition(tags_.state(index, way), state);
+        tags_.set_state(index, way, state);
+    }
+
+    uint8_t* line_data(uint64_t index, unsigned way) {
+        return data_.data() + (static_cast<size_t>(index) * geo_.ways() + way) * geo_.line_bytes();
+    }
+    const uint8_t* line_data(uint64_t index, unsigned way) const {
+        return data_.data() + (static_cast<size_t>(index) * geo_.ways() + way) * geo_.line_bytes();
+    }
+
+    // Vía con la línea de 'address' (la trae de Memoria si falta); cuenta el hit o miss
+    unsigned lookup_for_access(uint64_t index, uint64_t tag, bool write);
+    // Offset de 'address' en su línea; lanza std::invalid_argument si count palabras no caben
+    unsigned words_offset(uint64_t address, unsigned count) const;
+
+    unsigned select_victim(uint64_t index);
+    // Marca la línea recién llenada ante la política de reemplazo
+    void note_fill(uint64_t index, unsigned way) { policy_->on_fill(repl_state_[index], way); }
+
+    // Miss sin Bus (uso directo de la caché): trae el bloque desde Memoria en estado E
+    unsigned fill_from_memory(uint64_t index, uint64_t tag);
+
+    // Una línea precargada sale de la caché sin usarse
+    void drop_prefetch_mark(uint64_t index, unsigned way) {
+        if (tags_.prefetched(index, way)) {
+            metrics_.prefetch_useless++;
+            tags_.set_prefetched(index, way, false);
+        }
+    }
+    // Instala en la vía 'way' (ya elegida en el set) el bloque que entrega el Bus
+    void fill_line(uint64_t index, unsigned way, uint64_t tag, const uint8_t* block, MESI_State fill_state);
+
+    // Cuando se reemplaza una línea sucia -> write-back a memoria (o a la LLC si la tiene)
+    void writeback_if_dirty(uint64_t index, unsigned way);
+    // Víctima de un fill: write-back, o con LLC entregarla a evict_from_l1
+    void evict(uint64_t index, unsigned way);
 };
 
+// Geometría original del simulador: 8 sets x 2 vías x 32 B
+using DefaultCacheGeometry = StaticGeometry<8, 2, 32>;
+
+// Formas (sets, ways, line_bytes) compiladas con decodificación especializada
+#define CACHE_L1_STATIC_SHAPES(X) \
+    X(8, 1, 32)   X(8, 2, 32)   X(8, 4, 32)   X(8, 8, 32)   \
+    X(16, 1, 32)  X(16, 2, 32)  X(16, 4, 32)  X(16, 8, 32)  \
+    X(32, 1, 32)  X(32, 2, 32)  X(32, 4, 32)  X(32, 8, 32)  \
+    X(64, 1, 32)  X(64, 2, 32)  X(64, 4, 32)  X(64, 8, 32)  \
+    X(128, 2, 32) X(128, 4, 32) X(256, 2, 32) X(256, 4, 32) \
+    X(8, 2, 64)   X(16, 2, 64)  X(32, 2, 64)  X(64, 2, 64)  \
+    X(64, 4, 64)  X(64, 8, 64)  X(128, 4, 64) X(256, 4, 64)
+
+#define CACHE_L1_EXTERN_SHAPE(S, W, L) extern template class BasicCacheL1<StaticGeometry<S, W, L>>;
+CACHE_L1_STATIC_SHAPES(CACHE_L1_EXTERN_SHAPE)
+#undef CACHE_L1_EXTERN_SHAPE
+extern template class BasicCacheL1<DynamicGeometry>;
+
+// Construye una CacheL1: usa la versión especializada si la forma está en
+// CACHE_L1_STATIC_SHAPES y la de geometría en ejecución en otro caso.
+std::unique_ptr<CacheL1> make_cache_l1(int id, Memory* mem, const CacheConfig& config = CacheConfig{});
+
 #endif // CACHE_L1_H
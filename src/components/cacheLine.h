@@ -1,16 +1,23 @@
 #pragma once
 #include <cstdint>
 #include "../interconnect/BusEnums.h"
-#include <array>
 
+// Metadatos de una línea; los datos viven en el arreglo contiguo de la caché
 struct CacheLine {
     bool valid = false;
     bool dirty = false;
     uint64_t tag = 0;
     MESI_State state = MESI_State::INVALID;
-    std::array<uint8_t, 32> data; // bloque de 32 bytes
+    bool prefetched = false; // llenada por un prefetch y aún sin acceso a demanda
+};
 
-    CacheLine() { data.fill(0); }
-
-
-};
\ No newline at end of file
+// Metadatos de una vía tal como se guardan en un checkpoint (sim/Checkpoint.h)
+struct LineSnapshot {
+    uint64_t tag;
+    uint8_t state;      // MESI_State
+    uint8_t valid;
+    uint8_t dirty;
+    uint8_t prefetched;
+    uint32_t reserved;
+};
+static_assert(sizeof(LineSnapshot) == 16, "LineSnapshot debe medir 16 bytes");
@@ -0,0 +1,162 @@
+#include "dram.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+DramModel::DramModel(EventScheduler& scheduler, DramConfig config)
+    : scheduler_(scheduler), config_(config) {
+    if (config_.channels == 0 || config_.banks == 0 || config_.row_bytes == 0) {
+        throw std::invalid_argument("DramModel: channels, banks y row_bytes deben ser al menos 1");
+    }
+    if (config_.queue_depth == 0) config_.queue_depth = 1;
+    channels_.resize(config_.channels);
+    for (Channel& channel : channels_) {
+        channel.banks.resize(config_.banks);
+        channel.queue.reserve(config_.queue_depth);
+    }
+}
+
+void DramModel::access(uint64_t address, bool is_write, Callback on_done) {
+    // fila:banco:canal:columna
+    const uint64_t chunk = address / config_.row_bytes;
+    const unsigned channel = static_cast<unsigned>(chunk % config_.channels);
+    const uint64_t per_channel = chunk / config_.channels;
+    Request request{static_cast<unsigned>(per_channel % config_.banks), per_channel / config_.banks,
+                    scheduler_.now(), std::move(on_done)};
+    if (is_write) writes_++; else reads_++;
+
+    Channel& target = channels_[channel];
+    if (target.queue.size() < config_.queue_depth) {
+        target.queue.push_back(std::move(request));
+    } else {
+        queue_overflows_++;
+        target.overflow.push_back(std::move(request));
+    }
+    schedule_channel(channel);
+}
+
+void DramModel::schedule_channel(unsigned index) {
+    Channel& channel = channels_[index];
+    const Cycle now = scheduler_.now();
+    for (;;) {
+        // FR-FCFS: la cola está en orden de llegada, así el primer acierto es el más antiguo
+        size_t pick = channel.queue.size();
+        for (size_t i = 0; i < channel.queue.size(); ++i) {
+            const Request& request = channel.queue[i];
+            const Bank& bank = channel.banks[request.bank];
+            if (bank.ready_at > now) continue;
+            if (bank.open && bank.row == request.row) { pick = i; break; }
+            if (pick == channel.queue.size()) pick = i;
+        }
+        if (pick == channel.queue.size()) break;
+        issue(channel, pick);
+        if (!channel.overflow.empty()) {
+            channel.queue.push_back(std::move(channel.overflow.front()));
+            channel.overflow.pop_front();
+        }
+    }
+
+    if (channel.queue.empty()) return;
+    // Todos los bancos pedidos están ocupados: reintentar cuando se libere el primero
+    Cycle wake = channel.banks[channel.queue.front().bank].ready_at;
+    for (const Request& request : channel.queue) wake = std::min(wake, channel.banks[request.bank].ready_at);
+    if (channel.wake_at != 0 && channel.wake_at <= wake) return;
+    channel.wake_at = wake;
+    scheduler_.schedule_at(wake, [this, index, wake] {
+        if (channels_[index].wake_at == wake) channels_[index].wake_at = 0;
+        schedule_channel(index);
+    });
+}
+
+void DramModel::issue(Channel& channel, size_t index) {
+    Request request = std::move(channel.queue[index]);
+    channel.queue.erase(channel.queue.begin() + static_cast<std::ptrdiff_t>(index));
+
+    const Cycle now = scheduler_.now();
+    Bank& bank = channel.banks[request.bank];
+    Cycle latency;
+    if (bank.open && bank.row == request.row) {
+        latency = config_.row_hit;
+        bank.stats.row_hits++;
+    } else if (!bank.open) {
+        latency = config_.row_miss;
+        bank.stats.row_misses++;
+    } else {
+        latency = config_.row_conflict;
+        bank.stats.row_conflicts++;
+    }
+    bank.stats.accesses++;
+    bank.open = true; // página abierta
+    bank.row = request.row;
+    bank.ready_at = now + latency;
+
+    const Cycle done = std::max(bank.ready_at, channel.bus_free_at) + config_.burst;
+    channel.bus_free_at = done;
+    total_queue_wait_ += now - request.arrival;
+    total_latency_ += done - request.arrival;
+    latency_.record(done - request.arrival);
+    scheduler_.schedule_at(done, [on_done = std::move(request.on_done), done] { on_done(done); });
+}
+
+void DramModel::export_metrics(MetricsRegistry& registry) const {
+    const BankStats total = total_stats();
+    registry.counter("dram", "reads", reads_);
+    registry.counter("dram", "writes", writes_);
+    registry.counter("dram", "row_hits", total.row_hits);
+    registry.counter("dram", "row_misses", total.row_misses);
+    registry.counter("dram", "row_conflicts", total.row_conflicts);
+    registry.counter("dram", "queue_wait_cycles", total_queue_wait_);
+    registry.counter("dram", "queue_overflows", queue_overflows_);
+    registry.gauge("dram", "row_hit_rate", total.row_hit_rate());
+    // Todos los bancos, aunque no tengan accesos: las columnas no cambian entre corridas
+    for (unsigned c = 0; c < config_.channels; ++c) {
+        for (unsigned b = 0; b < config_.banks; ++b) {
+            const BankStats& stats = channels_[c].banks[b].stats;
+            const std::string prefix = "ch" + std::to_string(c) + "_bank" + std::to_string(b) + "_";
+            registry.counter("dram", prefix + "accesses", stats.accesses);
+            registry.counter("dram", prefix + "row_hits", stats.row_hits);
+            registry.counter("dram", prefix + "row_misses", stats.row_misses);
+            registry.counter("dram", prefix + "row_conflicts", stats.row_conflicts);
+            registry.gauge("dram", prefix + "row_hit_rate", stats.row_hit_rate());
+        }
+    }
+    registry.histogram("dram", "latency", latency_);
+}
+
+DramModel::BankStats DramModel::total_stats() const {
+    BankStats total;
+    for (const Channel& channel : channels_) {
+        for (const Bank& bank : channel.banks) {
+            total.accesses += bank.stats.accesses;
+            total.row_hits += bank.stats.row_hits;
+            total.row_misses += bank.stats.row_misses;
+            total.row_conflicts += bank.stats.row_conflicts;
+        }
+    }
+    return total;
+}
+
+double DramModel::average_latency() const {
+    const uint64_t served = total_stats().accesses;
+    return served ? static_cast<double>(total_latency_) / served : 0.0;
+}
+
+void DramModel::print_stats(std::ostream& out) const {
+    const BankStats total = total_stats();
+    out << "[DRAM] " << config_.channels << " canal(es) x " << config_.banks << " bancos, fila de "
+              << config_.row_bytes << " B. Lecturas: " << reads_ << " Escrituras: " << writes_
+              << " Row hits: " << total.row_hits << " (" << 100.0 * total.row_hit_rate() << "%)"
+              << " Latencia promedio: " << average_latency() << " ciclos"
+              << " Espera en cola: " << (total.accesses ? static_cast<double>(total_queue_wait_) / total.accesses : 0.0)
+              << " Desbordes de cola: " << queue_overflows_ << "\n";
+    for (unsigned c = 0; c < config_.channels; ++c) {
+        for (unsigned b = 0; b < config_.banks; ++b) {
+            const BankStats& stats = channels_[c].banks[b].stats;
+            if (!stats.accesses) continue;
+            out << "[DRAM] Canal " << c << " Banco " << b << ": accesos " << stats.accesses
+                      << " hits " << stats.row_hits << " misses " << stats.row_misses
+                      << " conflictos " << stats.row_conflicts
+                      << " row hit rate " << 100.0 * stats.row_hit_rate() << "%\n";
+        }
+    }
+}
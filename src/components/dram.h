@@ -0,0 +1,104 @@
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "../sim/EventScheduler.h"
+#include "../utils/histogram.h"
+#include "../utils/metricsRegistry.h"
+
+// Organización y latencias (en ciclos) de la DRAM detrás de Memoria
+struct DramConfig {
+    unsigned channels = 1;
+    unsigned banks = 8;          // bancos por canal
+    unsigned row_bytes = 2048;   // tamaño de fila (row buffer) de cada banco
+    Cycle row_hit = 8;           // la fila ya estaba abierta: solo CAS
+    Cycle row_miss = 16;         // banco sin fila abierta: ACT + CAS
+    Cycle row_conflict = 24;     // otra fila abierta: PRE + ACT + CAS
+    Cycle burst = 4;             // ocupación del bus de datos del canal por bloque
+    unsigned queue_depth = 16;   // peticiones visibles al planificador por canal
+};
+
+/*
+ Modelo de temporización de la DRAM (los datos siguen en Memory).
+ - Mapeo fila:banco:canal:columna: bloques consecutivos caen en la misma fila y las
+   filas consecutivas se reparten entre canales y luego entre bancos.
+ - Política de página abierta: la fila queda en el row buffer tras cada acceso.
+ - Cada canal tiene una cola de hasta queue_depth peticiones (el resto espera en
+   orden de llegada) y un planificador FR-FCFS: primero la petición más antigua que
+   acierta en la fila abierta de un banco libre; si no hay, la más antigua con su banco libre.
+ - Los bancos trabajan en paralelo; el bus de datos del canal transfiere un bloque a la vez.
+ access() invoca on_done en el ciclo en que el bloque terminó de transferirse.
+*/
+class DramModel {
+public:
+    using Callback = std::function<void(Cycle done)>;
+
+    struct BankStats {
+        uint64_t accesses = 0;
+        uint64_t row_hits = 0;
+        uint64_t row_misses = 0;    // banco cerrado
+        uint64_t row_conflicts = 0; // otra fila abierta
+        double row_hit_rate() const { return accesses ? static_cast<double>(row_hits) / accesses : 0.0; }
+    };
+
+    // Lanza std::invalid_argument si channels, banks o row_bytes es 0
+    DramModel(EventScheduler& scheduler, DramConfig config = DramConfig{});
+    DramModel(const DramModel&) = delete;
+    DramModel& operator=(const DramModel&) = delete;
+
+    void access(uint64_t address, bool is_write, Callback on_done);
+
+    const DramConfig& config() const { return config_; }
+    const BankStats& bank_stats(unsigned channel, unsigned bank) const { return channels_[channel].banks[bank].stats; }
+    BankStats total_stats() const;
+    uint64_t get_reads() const { return reads_; }
+    uint64_t get_writes() const { return writes_; }
+    uint64_t get_queue_overflows() const { return queue_overflows_; }
+    // Ciclos promedio desde que llega una petición hasta que termina su transferencia
+    double average_latency() const;
+    void print_stats(std::ostream& out = std::cout) const;
+    // Contadores, row hits (totales y por banco) y el histograma de latencias como "dram"
+    void export_metrics(MetricsRegistry& registry) const;
+
+private:
+    struct Request {
+        unsigned bank;
+        uint64_t row;
+        Cycle arrival;
+        Callback on_done;
+    };
+    struct Bank {
+        bool open = false;
+        uint64_t row = 0;
+        Cycle ready_at = 0; // ciclo en que acepta el siguiente comando
+        BankStats stats;
+    };
+    struct Channel {
+        std::vector<Bank> banks;
+        std::vector<Request> queue;   // en orden de llegada, hasta queue_depth
+        std::deque<Request> overflow; // esperan lugar en la cola
+        Cycle bus_free_at = 0;
+        Cycle wake_at = 0;            // reintento agendado (0 = ninguno)
+    };
+
+    EventScheduler& scheduler_;
+    DramConfig config_;
+    std::vector<Channel> channels_;
+
+    uint64_t reads_ = 0;
+    uint64_t writes_ = 0;
+    uint64_t queue_overflows_ = 0; // llegadas con la cola del canal llena
+    Cycle total_latency_ = 0;
+    LatencyHistogram latency_; // llegada -> fin de la transferencia
+    Cycle total_queue_wait_ = 0;   // ciclos en cola antes de emitirse
+
+    // Emite todas las peticiones posibles del canal y agenda un reintento si quedan
+    void schedule_channel(unsigned channel);
+    void issue(Channel& channel, size_t index);
+};
+
+#endif // DRAM_H
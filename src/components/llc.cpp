@@ -0,0 +1,211 @@
+#include "llc.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+SharedLLC::SharedLLC(Memory* memory, EventScheduler& scheduler, unsigned line_bytes, LLCConfig config)
+    : memory_(memory), scheduler_(scheduler), line_bytes_(line_bytes), config_(config) {
+    if (config_.banks == 0 || config_.sets == 0 || config_.ways == 0 || line_bytes_ == 0) {
+        throw std::invalid_argument("SharedLLC: banks, sets, ways y line_bytes deben ser al menos 1");
+    }
+    policy_ = make_replacement_policy(config_.replacement, config_.ways, config_.seed);
+    banks_.resize(config_.banks);
+    const size_t lines_per_bank = static_cast<size_t>(config_.sets) * config_.ways;
+    for (Bank& bank : banks_) {
+        bank.lines.resize(lines_per_bank);
+        bank.data.assign(lines_per_bank * line_bytes_, 0);
+        bank.repl_state.assign(config_.sets, policy_->initial_state());
+    }
+    victim_block_.resize(line_bytes_);
+}
+
+SharedLLC::Line* SharedLLC::find(Bank& bank, uint64_t set, uint64_t tag) {
+    Line* ways = &bank.lines[set * config_.ways];
+    for (unsigned w = 0; w < config_.ways; ++w) {
+        if (ways[w].valid && ways[w].tag == tag) return &ways[w];
+    }
+    return nullptr;
+}
+
+Cycle SharedLLC::occupy_bank(uint64_t line) {
+    Bank& bank = bank_of(line);
+    const Cycle now = scheduler_.now();
+    const Cycle start = std::max(now, bank.ready_at);
+    bank.ready_at = start + config_.hit_latency;
+    bank.accesses++;
+    stats_.bank_wait_cycles += start - now;
+    return start - now + config_.hit_latency;
+}
+
+void SharedLLC::evict(Bank& bank, unsigned bank_index, uint64_t set, Line* victim) {
+    const uint64_t address = block_address(victim->tag, set, bank_index);
+    const uint8_t* data = line_data(bank, victim);
+    stats_.evictions++;
+    if (config_.inclusion == InclusionPolicy::INCLUSIVE && back_invalidate_) {
+        // Inclusión: la línea sale también de las L1; una copia sucia en una L1 es la vigente
+        stats_.back_invalidations++;
+        if (back_invalidate_(address, victim_block_.data())) {
+            data = victim_block_.data();
+            victim->dirty = true;
+        }
+    }
+    if (victim->dirty) {
+        memory_->write_block(address, data, line_bytes_);
+        stats_.memory_writebacks++;
+    }
+    victim->valid = false;
+    victim->dirty = false;
+}
+
+SharedLLC::Line* SharedLLC::allocate(uint64_t line, const uint8_t* block, bool dirty) {
+    const unsigned bank_index = static_cast<unsigned>(line % config_.banks);
+    Bank& bank = banks_[bank_index];
+    const uint64_t set = set_of(line);
+    Line* ways = &bank.lines[set * config_.ways];
+    Line* slot = nullptr;
+    for (unsigned w = 0; w < config_.ways; ++w) {
+        if (!ways[w].valid) { slot = &ways[w]; break; }
+    }
+    if (!slot) {
+        slot = &ways[policy_->victim(bank.repl_state[set])];
+        evict(bank, bank_index, set, slot);
+    }
+    std::memcpy(line_data(bank, slot), block, line_bytes_);
+    slot->valid = true;
+    slot->dirty = dirty;
+    slot->tag = tag_of(line);
+    policy_->on_fill(bank.repl_state[set], way_of(bank, set, slot));
+    stats_.fills++;
+    return slot;
+}
+
+SharedLLC::Access SharedLLC::read_block(uint64_t address, uint8_t* out_block) {
+    const uint64_t line = address / line_bytes_;
+    Bank& bank = bank_of(line);
+    const uint64_t set = set_of(line);
+    Access access;
+    access.latency = occupy_bank(line);
+    stats_.reads++;
+
+    Line* hit = find(bank, set, tag_of(line));
+    if (hit) {
+        access.hit = true;
+        stats_.read_hits++;
+        std::memcpy(out_block, line_data(bank, hit), line_bytes_);
+        if (config_.inclusion == InclusionPolicy::EXCLUSIVE) {
+            // La línea se mueve a la L1 (que la recibe limpia): el dato sucio va a Memoria
+            if (hit->dirty) {
+                memory_->write_block(address, out_block, line_bytes_);
+                stats_.memory_writebacks++;
+            }
+            hit->valid = false;
+            hit->dirty = false;
+        } else {
+            policy_->on_hit(bank.repl_state[set], way_of(bank, set, hit));
+        }
+        return access;
+    }
+
+    memory_->read_block(address, out_block, line_bytes_);
+    if (config_.inclusion != InclusionPolicy::EXCLUSIVE) allocate(line, out_block, false);
+    return access;
+}
+
+bool SharedLLC::write_back(uint64_t address, const uint8_t* block) {
+    const uint64_t line = address / line_bytes_;
+    Bank& bank = bank_of(line);
+    const uint64_t set = set_of(line);
+    Line* present = find(bank, set, tag_of(line));
+    if (!present) return false;
+    occupy_bank(line);
+    std::memcpy(line_data(bank, present), block, line_bytes_);
+    present->dirty = true;
+    stats_.write_backs++;
+    return true;
+}
+
+void SharedLLC::evict_from_l1(uint64_t address, const uint8_t* block, bool dirty) {
+    if (dirty && write_back(address, block)) return;
+    const uint64_t line = address / line_bytes_;
+    switch (config_.inclusion) {
+        case InclusionPolicy::EXCLUSIVE:
+            // Toda víctima de una L1 (limpia o sucia) pasa a la LLC
+            if (find(bank_of(line), set_of(line), tag_of(line))) return;
+            occupy_bank(line);
+            allocate(line, block, dirty);
+            stats_.l1_victims++;
+            return;
+        case InclusionPolicy::NON_INCLUSIVE:
+            // Write-back con asignación; las víctimas limpias se descartan
+            if (!dirty) return;
+            occupy_bank(line);
+            allocate(line, block, true);
+            stats_.l1_victims++;
+            return;
+        case InclusionPolicy::INCLUSIVE:
+            // La línea ya no estaba en la LLC (se desalojó con la transacción en vuelo)
+            if (dirty) memory_->write_block(address, block, line_bytes_);
+            return;
+    }
+}
+
+void SharedLLC::flush() {
+    for (unsigned b = 0; b < config_.banks; ++b) {
+        Bank& bank = banks_[b];
+        for (uint64_t set = 0; set < config_.sets; ++set) {
+            for (unsigned w = 0; w < config_.ways; ++w) {
+                Line& line = bank.lines[set * config_.ways + w];
+                if (!line.valid || !line.dirty) continue;
+                memory_->write_block(block_address(line.tag, set, b), line_data(bank, &line), line_bytes_);
+                line.dirty = false;
+            }
+        }
+    }
+}
+
+void SharedLLC::print_stats(std::ostream& out) const {
+    out << "[LLC] " << config_.banks << " bancos x " << config_.sets << " sets x " << config_.ways
+              << " vias (" << config_.banks * config_.sets * config_.ways * line_bytes_ / 1024 << " KB, "
+              << inclusion_policy_name(config_.inclusion) << ", " << policy_->name() << ")"
+              << " Lecturas: " << stats_.reads << " Hits: " << stats_.read_hits
+              << " Hit rate: " << 100.0 * stats_.hit_rate() << "%\n";
+    out << "[LLC] Write-backs absorbidos: " << stats_.write_backs
+              << " Victimas de L1 guardadas: " << stats_.l1_victims
+              << " Desalojos: " << stats_.evictions
+              << " Write-backs a memoria: " << stats_.memory_writebacks
+              << " Back-invalidations: " << stats_.back_invalidations
+              << " Espera por bancos: " << stats_.bank_wait_cycles << " ciclos\n";
+}
+
+void SharedLLC::export_metrics(MetricsRegistry& registry) const {
+    registry.counter("llc", "reads", stats_.reads);
+    registry.counter("llc", "read_hits", stats_.read_hits);
+    registry.counter("llc", "write_backs", stats_.write_backs);
+    registry.counter("llc", "l1_victims", stats_.l1_victims);
+    registry.counter("llc", "fills", stats_.fills);
+    registry.counter("llc", "evictions", stats_.evictions);
+    registry.counter("llc", "memory_writebacks", stats_.memory_writebacks);
+    registry.counter("llc", "back_invalidations", stats_.back_invalidations);
+    registry.counter("llc", "bank_wait_cycles", stats_.bank_wait_cycles);
+    for (unsigned b = 0; b < config_.banks; ++b) {
+        registry.counter("llc", "bank" + std::to_string(b) + "_accesses", banks_[b].accesses);
+    }
+    registry.gauge("llc", "hit_rate", stats_.hit_rate());
+}
+
+InclusionPolicy parse_inclusion_policy(const std::string& name) {
+    if (name == "inclusive") return InclusionPolicy::INCLUSIVE;
+    if (name == "exclusive") return InclusionPolicy::EXCLUSIVE;
+    if (name == "non-inclusive") return InclusionPolicy::NON_INCLUSIVE;
+    throw std::invalid_argument("Politica de inclusion desconocida: " + name);
+}
+
+const char* inclusion_policy_name(InclusionPolicy policy) {
+    switch (policy) {
+        case InclusionPolicy::INCLUSIVE: return "INCLUSIVE";
+        case InclusionPolicy::EXCLUSIVE: return "EXCLUSIVE";
+        case InclusionPolicy::NON_INCLUSIVE: return "NON_INCLUSIVE";
+        default: return "UNKNOWN";
+    }
+}
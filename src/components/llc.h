@@ -0,0 +1,138 @@
+#ifndef LLC_H
+#define LLC_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory.h"
+#include "replacementPolicy.h"
+#include "../utils/metricsRegistry.h"
+#include "../sim/EventScheduler.h"
+
+// Relación entre el contenido de las L1 y el de la LLC
+enum class InclusionPolicy {
+    INCLUSIVE,     // toda línea de una L1 está en la LLC; desalojar de la LLC invalida las L1 (back-invalidation)
+    EXCLUSIVE,     // la LLC guarda solo víctimas de las L1; un acierto mueve la línea a la L1
+    NON_INCLUSIVE  // se llena en cada miss y absorbe write-backs, sin forzar inclusión
+};
+
+struct LLCConfig {
+    unsigned banks = 4;          // bancos intercalados por línea
+    unsigned sets = 64;          // sets por banco
+    unsigned ways = 8;
+    ReplacementKind replacement = ReplacementKind::LRU;
+    uint64_t seed = 1;
+    InclusionPolicy inclusion = InclusionPolicy::NON_INCLUSIVE;
+    Cycle hit_latency = 8;       // búsqueda de tags y lectura de datos en un banco
+};
+
+/*
+ Caché compartida de último nivel entre el Bus y Memoria. La usan:
+ - el Bus, cuando ninguna L1 suministra el bloque (read_block) y para los write-backs
+   de líneas sucias que siguen en alguna L1 (write_back);
+ - las L1, al desalojar una línea válida (evict_from_l1) y en su flush (write_back).
+ Cada banco atiende un acceso a la vez: un acceso a un banco ocupado espera a que se
+ libere (conflicto de banco). Los write-backs de la LLC a Memoria quedan fuera de la
+ ruta crítica. En modo inclusivo el desalojo de una línea de la LLC la invalida en las
+ L1 mediante el callback del Bus (set_back_invalidate); si una L1 la tenía sucia, ese
+ dato es el que se escribe en Memoria.
+*/
+class SharedLLC {
+public:
+    // Invalida la línea en todas las L1; retorna true y copia el bloque si alguna la tenía sucia
+    using BackInvalidate = std::function<bool(uint64_t address, uint8_t* dirty_block)>;
+
+    struct Access {
+        bool hit = false;
+        Cycle latency = 0; // espera por el banco + hit_latency
+    };
+
+    struct Stats {
+        uint64_t reads = 0;            // bloques pedidos por el Bus
+        uint64_t read_hits = 0;
+        uint64_t write_backs = 0;      // write-backs absorbidos (la línea estaba en la LLC)
+        uint64_t l1_victims = 0;       // líneas desalojadas de una L1 que se guardaron en la LLC
+        uint64_t fills = 0;
+        uint64_t evictions = 0;
+        uint64_t memory_writebacks = 0;   // víctimas sucias escritas en Memoria
+        uint64_t back_invalidations = 0;  // líneas invalidadas en las L1 (modo inclusivo)
+        Cycle bank_wait_cycles = 0;       // esperas por conflicto de banco
+        double hit_rate() const { return reads ? static_cast<double>(read_hits) / reads : 0.0; }
+    };
+
+    // Lanza std::invalid_argument si banks, sets o ways es 0 o la política no admite 'ways'
+    SharedLLC(Memory* memory, EventScheduler& scheduler, unsigned line_bytes, LLCConfig config = LLCConfig{});
+    SharedLLC(const SharedLLC&) = delete;
+    SharedLLC& operator=(const SharedLLC&) = delete;
+
+    void set_back_invalidate(BackInvalidate callback) { back_invalidate_ = std::move(callback); }
+
+    // Bloque que ninguna L1 suministró; en un miss lo lee de Memoria (y lo guarda salvo en modo exclusivo)
+    Access read_block(uint64_t address, uint8_t* out_block);
+    // Actualiza la copia de la LLC; false si no la tiene (el llamador escribe en Memoria)
+    bool write_back(uint64_t address, const uint8_t* block);
+    // Una L1 desaloja una línea válida (limpia o sucia)
+    void evict_from_l1(uint64_t address, const uint8_t* block, bool dirty);
+    // Escribe en Memoria todas las líneas sucias
+    void flush();
+
+    const LLCConfig& config() const { return config_; }
+    const Stats& stats() const { return stats_; }
+    uint64_t bank_accesses(unsigned bank) const { return banks_[bank].accesses; }
+    void print_stats(std::ostream& out = std::cout) const;
+    // Stats y accesos por banco como "llc"
+    void export_metrics(MetricsRegistry& registry) const;
+
+private:
+    struct Line {
+        bool valid = false;
+        bool dirty = false;
+        uint64_t tag = 0;
+    };
+    struct Bank {
+        std::vector<Line> lines;        // sets * ways
+        std::vector<uint8_t> data;      // sets * ways * line_bytes
+        std::vector<uint64_t> repl_state;
+        Cycle ready_at = 0;
+        uint64_t accesses = 0;
+    };
+
+    Memory* memory_;
+    EventScheduler& scheduler_;
+    unsigned line_bytes_;
+    LLCConfig config_;
+    std::unique_ptr<ReplacementPolicy> policy_;
+    std::vector<Bank> banks_;
+    BackInvalidate back_invalidate_;
+    Stats stats_;
+    std::vector<uint8_t> victim_block_; // bloque sucio devuelto por la back-invalidation
+
+    // Decodificación: línea = address / line_bytes; banco = línea % banks; set y tag del resto
+    Bank& bank_of(uint64_t line) { return banks_[line % config_.banks]; }
+    uint64_t set_of(uint64_t line) const { return (line / config_.banks) % config_.sets; }
+    uint64_t tag_of(uint64_t line) const { return line / config_.banks / config_.sets; }
+    uint64_t block_address(uint64_t tag, uint64_t set, unsigned bank) const {
+        return ((tag * config_.sets + set) * config_.banks + bank) * line_bytes_;
+    }
+    Line* find(Bank& bank, uint64_t set, uint64_t tag);
+    uint8_t* line_data(Bank& bank, const Line* line) {
+        return bank.data.data() + static_cast<size_t>(line - bank.lines.data()) * line_bytes_;
+    }
+    unsigned way_of(const Bank& bank, uint64_t set, const Line* line) const {
+        return static_cast<unsigned>(line - &bank.lines[set * config_.ways]);
+    }
+    // Ocupa el banco de 'line' hit_latency ciclos; retorna la espera más hit_latency
+    Cycle occupy_bank(uint64_t line);
+    // Elige una vía para 'tag' (desalojando si hace falta) y copia el bloque
+    Line* allocate(uint64_t line, const uint8_t* block, bool dirty);
+    void evict(Bank& bank, unsigned bank_index, uint64_t set, Line* victim);
+};
+
+// "inclusive", "exclusive", "non-inclusive"
+InclusionPolicy parse_inclusion_policy(const std::string& name);
+const char* inclusion_policy_name(InclusionPolicy policy);
+
+#endif // LLC_H
@@ -1,45 +1,140 @@
 #include "memory.h"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
-#include <iomanip>
+#include <string>
+#include "../utils/trace.h"
 
-Memory::Memory() {
-    mem_.fill(0);
+namespace {
+
+constexpr uint64_t level_index(uint64_t address, unsigned level) {
+    // level 0 = raíz, 2 = hoja
+    return (address >> (Memory::PAGE_SHIFT + (2 - level) * Memory::LEVEL_BITS)) &
+           ((uint64_t{1} << Memory::LEVEL_BITS) - 1);
+}
+
+} // namespace
+
+Memory::Memory() : root_(std::make_unique<RootTable>()) {}
+
+uint64_t Memory::align_addr(uint64_t address, size_t block_bytes) const {
+    return (address / block_bytes) * block_bytes;
+}
+
+void Memory::check_range(uint64_t address, size_t n, const char* what) const {
+    if (address >= ADDRESS_LIMIT || n > ADDRESS_LIMIT - address) {
+        throw std::out_of_range(std::string(what) + ": address out of range");
+    }
+}
+
+const uint8_t* Memory::find_page(uint64_t address) const {
+    if ((address >> PAGE_SHIFT) == cached_page_number_) return cached_page_;
+    const MiddleTable* middle = root_->entries[level_index(address, 0)].get();
+    if (!middle) return nullptr;
+    const LeafTable* leaf = middle->entries[level_index(address, 1)].get();
+    if (!leaf) return nullptr;
+    uint8_t* page = leaf->pages[level_index(address, 2)];
+    if (!page) return nullptr;
+    cached_page_number_ = address >> PAGE_SHIFT;
+    cached_page_ = page;
+    return cached_page_;
+}
+
+uint8_t* Memory::touch_page(uint64_t address) {
+    if ((address >> PAGE_SHIFT) == cached_page_number_) return cached_page_;
+    std::unique_ptr<MiddleTable>& middle = root_->entries[level_index(address, 0)];
+    if (!middle) middle = std::make_unique<MiddleTable>();
+    std::unique_ptr<LeafTable>& leaf = middle->entries[level_index(address, 1)];
+    if (!leaf) leaf = std::make_unique<LeafTable>();
+    uint8_t*& page = leaf->pages[level_index(address, 2)];
+    if (!page) {
+        owned_pages_.push_back(std::make_unique<Page>()); // inicializada en cero
+        page = owned_pages_.back()->data();
+        resident_pages_++;
+    }
+    cached_page_number_ = address >> PAGE_SHIFT;
+    cached_page_ = page;
+    return cached_page_;
 }
 
-uint64_t Memory::align_addr(uint64_t address) const {
-    return (address / BLOCK_BYTES) * BLOCK_BYTES;
+void Memory::map_page(uint64_t page_number, uint8_t* page) {
+    const uint64_t address = page_number << PAGE_SHIFT;
+    check_range(address, PAGE_BYTES, "Memory::map_page");
+    std::unique_ptr<MiddleTable>& middle = root_->entries[level_index(address, 0)];
+    if (!middle) middle = std::make_unique<MiddleTable>();
+    std::unique_ptr<LeafTable>& leaf = middle->entries[level_index(address, 1)];
+    if (!leaf) leaf = std::make_unique<LeafTable>();
+    uint8_t*& slot = leaf->pages[level_index(address, 2)];
+    if (slot) throw std::logic_error("Memory::map_page: la pagina ya existe");
+    slot = page;
+    resident_pages_++;
 }
 
-void Memory::read_block(uint64_t address, uint64_t* out_block) const {
-    uint64_t base = align_addr(address);
-    if (base + BLOCK_BYTES > MEM_BYTES) {
-        throw std::out_of_range("Memory::read_block: address out of range");
+void Memory::copy_out(uint64_t address, uint8_t* out, size_t n) const {
+    const uint64_t first_offset = address & (PAGE_BYTES - 1);
+    if (first_offset + n <= PAGE_BYTES) { // caso común: un bloque alineado nunca cruza páginas
+        const uint8_t* page = find_page(address);
+        if (page) std::memcpy(out, page + first_offset, n);
+        else std::memset(out, 0, n);
+        return;
+    }
+    while (n) {
+        const uint64_t offset = address & (PAGE_BYTES - 1);
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, PAGE_BYTES - offset));
+        const uint8_t* page = find_page(address);
+        if (page) std::memcpy(out, page + offset, chunk);
+        else std::memset(out, 0, chunk); // página nunca escrita
+        address += chunk; out += chunk; n -= chunk;
     }
-    std::memcpy(out_block, mem_.data() + base, BLOCK_BYTES);
-    std::cout << "[MEM] read_block @ 0x" << std::hex << base << std::dec << " (32B)\n";
 }
 
-void Memory::write_block(uint64_t address, const uint64_t* in_block) {
-    uint64_t base = align_addr(address);
-    if (base + BLOCK_BYTES > MEM_BYTES) {
-        throw std::out_of_range("Memory::write_block: address out of range");
+void Memory::copy_in(uint64_t address, const uint8_t* in, size_t n) {
+    const uint64_t first_offset = address & (PAGE_BYTES - 1);
+    if (first_offset + n <= PAGE_BYTES) {
+        std::memcpy(touch_page(address) + first_offset, in, n);
+        return;
     }
-    std::memcpy(mem_.data() + base, in_block, BLOCK_BYTES);
-    std::cout << "[MEM] write_block @ 0x" << std::hex << base << std::dec << " (32B)\n";
+    while (n) {
+        const uint64_t offset = address & (PAGE_BYTES - 1);
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, PAGE_BYTES - offset));
+        std::memcpy(touch_page(address) + offset, in, chunk);
+        address += chunk; in += chunk; n -= chunk;
+    }
+}
+
+void Memory::read_block(uint64_t address, uint8_t* out_block, size_t block_bytes) const {
+    uint64_t base = align_addr(address, block_bytes);
+    check_range(base, block_bytes, "Memory::read_block");
+    copy_out(base, out_block, block_bytes);
+    block_bytes_read_ += block_bytes;
+    MESI_TRACE(TraceEvent::MEM_READ_BLOCK, block_bytes, base, 0);
+}
+
+void Memory::write_block(uint64_t address, const uint8_t* in_block, size_t block_bytes) {
+    uint64_t base = align_addr(address, block_bytes);
+    check_range(base, block_bytes, "Memory::write_block");
+    copy_in(base, in_block, block_bytes);
+    block_bytes_written_ += block_bytes;
+    MESI_TRACE(TraceEvent::MEM_WRITE_BLOCK, block_bytes, base, 0);
 }
 
 void Memory::read_word(uint64_t address, uint64_t* out_word) const {
-    if (address + WORD_BYTES > MEM_BYTES) throw std::out_of_range("Memory::read_word out of range");
-    std::memcpy(out_word, mem_.data() + address, WORD_BYTES);
+    check_range(address, WORD_BYTES, "Memory::read_word");
+    copy_out(address, reinterpret_cast<uint8_t*>(out_word), WORD_BYTES);
 }
 
 void Memory::write_word(uint64_t address, const uint64_t* in_word) {
-    if (address + WORD_BYTES > MEM_BYTES) throw std::out_of_range("Memory::write_word out of range");
-    std::memcpy(mem_.data() + address, in_word, WORD_BYTES);
+    check_range(address, WORD_BYTES, "Memory::write_word");
+    copy_in(address, reinterpret_cast<const uint8_t*>(in_word), WORD_BYTES);
 }
 
 void Memory::read_bytes(uint64_t address, uint64_t* out_buf, size_t n) const {
-    if (address + n > MEM_BYTES) throw std::out_of_range("Memory::read_bytes out of range");
-    std::memcpy(out_buf, mem_.data() + address, n);
-}
\ No newline at end of file
+    check_range(address, n, "Memory::read_bytes");
+    copy_out(address, reinterpret_cast<uint8_t*>(out_buf), n);
+}
+
+void Memory::export_metrics(MetricsRegistry& registry) const {
+    registry.counter("memory", "block_bytes_read", block_bytes_read_);
+    registry.counter("memory", "block_bytes_written", block_bytes_written_);
+    registry.counter("memory", "resident_pages", resident_pages_);
+}
@@ -4,21 +4,38 @@
 #include <array>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <vector>
+#include "../utils/metricsRegistry.h"
 
+/*
+ Memoria principal dispersa y paginada.
+ - Espacio de direcciones de ADDRESS_BITS (48 bits, 256 TB) dividido en páginas de 4 KB.
+ - Las páginas se reservan (en cero) la primera vez que se escriben; leer una página
+   nunca escrita devuelve ceros sin reservarla. La huella sigue al conjunto de trabajo.
+ - Búsqueda de página en tiempo constante: tabla radix de tres niveles
+   (12 + 12 + 12 bits de número de página), como una tabla de páginas, precedida
+   por la última página resuelta (los bloques consecutivos suelen caer en ella).
+ Como el resto del simulador, no admite accesos concurrentes desde varios hilos.
+*/
 class Memory {
 public:
-    static const int MEM_WORDS = 512;         // 512 palabras de 64 bits
     static const int WORD_BYTES = 8;          // 8 bytes por palabra
-    static const int MEM_BYTES = MEM_WORDS * WORD_BYTES;
-    static const int BLOCK_BYTES = 8;        // tamaño de bloque de la caché
+    static constexpr unsigned PAGE_SHIFT = 12;
+    static constexpr uint64_t PAGE_BYTES = 1ULL << PAGE_SHIFT;  // 4 KB
+    static constexpr unsigned LEVEL_BITS = 12;                  // 4096 entradas por tabla
+    static constexpr unsigned ADDRESS_BITS = PAGE_SHIFT + 3 * LEVEL_BITS;
+    static constexpr uint64_t ADDRESS_LIMIT = 1ULL << ADDRESS_BITS;
 
     Memory();
+    Memory(const Memory&) = delete;
+    Memory& operator=(const Memory&) = delete;
 
-    // Lee un bloque completo (32 bytes) alineado en 'address'
-    void read_block(uint64_t address, uint64_t* out_block) const;
+    // Lee un bloque completo (una línea de caché de block_bytes) alineado en 'address'
+    void read_block(uint64_t address, uint8_t* out_block, size_t block_bytes) const;
 
-    // Escribe un bloque completo (32 bytes) alineado en 'address'
-    void write_block(uint64_t address, const uint64_t* in_block);
+    // Escribe un bloque completo (una línea de caché de block_bytes) alineado en 'address'
+    void write_block(uint64_t address, const uint8_t* in_block, size_t block_bytes);
 
     // Operaciones de palabra (8 bytes) para evitar usar buffers pequeños como bloques
     void read_word(uint64_t address, uint64_t* out_word) const;
@@ -27,9 +44,71 @@ public:
     // Lectura directa de bytes (para pruebas)
     void read_bytes(uint64_t address, uint64_t* out_buf, size_t n) const;
 
+    // Páginas residentes en orden de dirección (checkpoints): fn(número de página, PAGE_BYTES bytes)
+    template <class Fn>
+    void for_each_page(Fn&& fn) const {
+        for (size_t r = 0; r < TABLE_ENTRIES; ++r) {
+            const MiddleTable* middle = root_->entries[r].get();
+            if (!middle) continue;
+            for (size_t m = 0; m < TABLE_ENTRIES; ++m) {
+                const LeafTable* leaf = middle->entries[m].get();
+                if (!leaf) continue;
+                for (size_t l = 0; l < TABLE_ENTRIES; ++l) {
+                    if (leaf->pages[l]) fn((((r << LEVEL_BITS) | m) << LEVEL_BITS) | l, leaf->pages[l]);
+                }
+            }
+        }
+    }
+    // Usa 'page' (PAGE_BYTES bytes, externa) como contenido de la página page_number sin
+    // copiarla: debe vivir más que la Memoria y admitir escrituras (p. ej. un mmap privado,
+    // que el sistema copia al escribirse). Lanza std::logic_error si la página ya existe.
+    void map_page(uint64_t page_number, uint8_t* page);
+
+    // Huella: páginas reservadas (las escritas al menos una vez)
+    size_t resident_pages() const { return resident_pages_; }
+    uint64_t resident_bytes() const { return resident_pages_ * PAGE_BYTES; }
+
+    // Tráfico de bloques (read_block/write_block: cachés, LLC y Bus); las palabras de
+    // inicialización y lectura de resultados no cuentan
+    uint64_t block_bytes_read() const { return block_bytes_read_; }
+    uint64_t block_bytes_written() const { return block_bytes_written_; }
+    // Tráfico y huella como "memory"
+    void export_metrics(MetricsRegistry& registry) const;
+
 private:
-    std::array<uint8_t, MEM_BYTES> mem_ = std::array<uint8_t, MEM_BYTES>{0};
-    uint64_t align_addr(uint64_t address) const;
+    static constexpr size_t TABLE_ENTRIES = size_t{1} << LEVEL_BITS;
+
+    using Page = std::array<uint8_t, PAGE_BYTES>;
+    template <class Child>
+    struct Table {
+        std::array<std::unique_ptr<Child>, TABLE_ENTRIES> entries;
+    };
+    // Las hojas apuntan a páginas propias (owned_pages_) o externas (map_page)
+    struct LeafTable {
+        std::array<uint8_t*, TABLE_ENTRIES> pages{}; // 4096 páginas (16 MB)
+    };
+    using MiddleTable = Table<LeafTable>; // 64 GB
+    using RootTable = Table<MiddleTable>; // todo el espacio de direcciones
+
+    std::unique_ptr<RootTable> root_;
+    std::vector<std::unique_ptr<Page>> owned_pages_;
+    size_t resident_pages_ = 0;
+    mutable uint64_t block_bytes_read_ = 0;
+    uint64_t block_bytes_written_ = 0;
+    // Última página reservada que se resolvió (solo páginas existentes)
+    mutable uint64_t cached_page_number_ = ~0ULL;
+    mutable uint8_t* cached_page_ = nullptr;
+
+    uint64_t align_addr(uint64_t address, size_t block_bytes) const;
+    // Lanza std::out_of_range si [address, address + n) sale del espacio de direcciones
+    void check_range(uint64_t address, size_t n, const char* what) const;
+    // Página que contiene 'address'; nullptr si nunca se escribió
+    const uint8_t* find_page(uint64_t address) const;
+    // Igual, pero la reserva (en cero) si no existe
+    uint8_t* touch_page(uint64_t address);
+    // Copias que pueden cruzar páginas
+    void copy_out(uint64_t address, uint8_t* out, size_t n) const;
+    void copy_in(uint64_t address, const uint8_t* in, size_t n);
 };
 
 #endif // MEMORY_H
@@ -0,0 +1,152 @@
+#include "prefetcher.h"
+#include <stdexcept>
+
+namespace {
+
+/* ------------------ Next-N-line ------------------ */
+
+class NextLinePrefetcher final : public Prefetcher {
+public:
+    NextLinePrefetcher(unsigned line_bytes, unsigned degree) : Prefetcher(line_bytes), degree_(degree) {}
+
+    const char* name() const override { return "NEXT_LINE"; }
+
+    void on_access(uint64_t line, uint32_t, bool miss, bool prefetched_hit, std::vector<uint64_t>& out) override {
+        if (!miss && !prefetched_hit) return;
+        for (unsigned i = 1; i <= degree_; ++i) out.push_back(line + uint64_t{i} * line_bytes_);
+    }
+
+private:
+    unsigned degree_;
+};
+
+/* ------------------ Stride (RPT) ------------------ */
+
+// Tabla de predicción de referencias (Chen y Baer): por PC la última dirección,
+// el stride y un estado; predice solo en STEADY (mismo stride dos veces seguidas).
+class StridePrefetcher final : public Prefetcher {
+public:
+    StridePrefetcher(unsigned line_bytes, unsigned degree, unsigned entries)
+        : Prefetcher(line_bytes), degree_(degree), table_(entries ? entries : 1) {}
+
+    const char* name() const override { return "STRIDE"; }
+
+    void on_access(uint64_t line, uint32_t pc, bool, bool, std::vector<uint64_t>& out) override {
+        Entry& entry = table_[pc % table_.size()];
+        if (!entry.valid || entry.pc != pc) {
+            entry = Entry{true, pc, line, 0, State::INITIAL};
+            return;
+        }
+        const int64_t stride = static_cast<int64_t>(line - entry.last_line);
+        const bool match = stride == entry.stride;
+        // Un fallo en STEADY conserva el stride (un salto aislado no lo descarta)
+        if (!match && entry.state != State::STEADY) entry.stride = stride;
+        switch (entry.state) {
+            case State::INITIAL:   entry.state = match ? State::STEADY : State::TRANSIENT; break;
+            case State::TRANSIENT: entry.state = match ? State::STEADY : State::NO_PRED; break;
+            case State::STEADY:    entry.state = match ? State::STEADY : State::INITIAL; break;
+            case State::NO_PRED:   entry.state = match ? State::TRANSIENT : State::NO_PRED; break;
+        }
+        entry.last_line = line;
+
+        if (entry.state != State::STEADY || entry.stride == 0) return;
+        for (unsigned i = 1; i <= degree_; ++i) {
+            out.push_back(line + static_cast<uint64_t>(entry.stride * static_cast<int64_t>(i)));
+        }
+    }
+
+private:
+    enum class State : uint8_t { INITIAL, TRANSIENT, STEADY, NO_PRED };
+    struct Entry {
+        bool valid = false;
+        uint32_t pc = 0;
+        uint64_t last_line = 0;
+        int64_t stride = 0;
+        State state = State::INITIAL;
+    };
+    unsigned degree_;
+    std::vector<Entry> table_;
+};
+
+/* ------------------ Stream ------------------ */
+
+// Flujos secuenciales ascendentes. Un miss que no continúa ningún flujo reemplaza al
+// menos usado; un acceso a la línea esperada de un flujo lo avanza y mantiene degree
+// líneas precargadas por delante.
+class StreamPrefetcher final : public Prefetcher {
+public:
+    StreamPrefetcher(unsigned line_bytes, unsigned degree, unsigned streams)
+        : Prefetcher(line_bytes), degree_(degree ? degree : 1), streams_(streams ? streams : 1) {}
+
+    const char* name() const override { return "STREAM"; }
+
+    void on_access(uint64_t line, uint32_t, bool miss, bool, std::vector<uint64_t>& out) override {
+        ++clock_;
+        for (Stream& stream : streams_) {
+            // la línea cae dentro de la ventana ya precargada del flujo
+            if (stream.valid && line >= stream.next && line < stream.prefetched_to) {
+                stream.next = line + line_bytes_;
+                stream.last_use = clock_;
+                extend(stream, out);
+                return;
+            }
+        }
+        if (!miss) return;
+        Stream* victim = &streams_[0];
+        for (Stream& stream : streams_) {
+            if (!stream.valid) { victim = &stream; break; }
+            if (stream.last_use < victim->last_use) victim = &stream;
+        }
+        *victim = Stream{true, line + line_bytes_, line + line_bytes_, clock_};
+        extend(*victim, out);
+    }
+
+private:
+    struct Stream {
+        bool valid = false;
+        uint64_t next = 0;          // próxima línea que se espera a demanda
+        uint64_t prefetched_to = 0; // primera línea aún no pedida
+        uint64_t last_use = 0;
+    };
+
+    void extend(Stream& stream, std::vector<uint64_t>& out) {
+        const uint64_t target = stream.next + uint64_t{degree_} * line_bytes_;
+        for (; stream.prefetched_to < target; stream.prefetched_to += line_bytes_) out.push_back(stream.prefetched_to);
+    }
+
+    unsigned degree_;
+    std::vector<Stream> streams_;
+    uint64_t clock_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config, unsigned line_bytes) {
+    switch (config.kind) {
+        case PrefetchKind::NONE: return nullptr;
+        case PrefetchKind::NEXT_LINE: return std::make_unique<NextLinePrefetcher>(line_bytes, config.degree);
+        case PrefetchKind::STRIDE:
+            return std::make_unique<StridePrefetcher>(line_bytes, config.degree, config.table_entries);
+        case PrefetchKind::STREAM:
+            return std::make_unique<StreamPrefetcher>(line_bytes, config.degree, config.table_entries);
+    }
+    throw std::invalid_argument("make_prefetcher: tipo de prefetcher desconocido");
+}
+
+PrefetchKind parse_prefetch_kind(const std::string& name) {
+    if (name == "none") return PrefetchKind::NONE;
+    if (name == "next") return PrefetchKind::NEXT_LINE;
+    if (name == "stride") return PrefetchKind::STRIDE;
+    if (name == "stream") return PrefetchKind::STREAM;
+    throw std::invalid_argument("Prefetcher desconocido: " + name);
+}
+
+const char* prefetch_kind_name(PrefetchKind kind) {
+    switch (kind) {
+        case PrefetchKind::NONE: return "NONE";
+        case PrefetchKind::NEXT_LINE: return "NEXT_LINE";
+        case PrefetchKind::STRIDE: return "STRIDE";
+        case PrefetchKind::STREAM: return "STREAM";
+        default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Prefetchers disponibles para CacheL1
+enum class PrefetchKind {
+    NONE,
+    NEXT_LINE, // next-N-line con marca: dispara en un miss o en el primer uso de una línea precargada
+    STRIDE,    // tabla de predicción de referencias (RPT) indexada por PC
+    STREAM     // detectores de flujo secuencial que se mantienen degree líneas adelante
+};
+
+struct PrefetchConfig {
+    PrefetchKind kind = PrefetchKind::NONE;
+    unsigned degree = 2;         // líneas por disparo (distancia de anticipación)
+    unsigned table_entries = 16; // entradas de la RPT o número de flujos
+};
+
+/*
+ Un prefetcher observa los accesos a demanda de su caché (ya alineados a línea) y
+ propone líneas a precargar. No conoce el Bus ni la caché: la MemoryFacade filtra las
+ líneas ya presentes o en vuelo y emite las restantes como BusRd de baja prioridad.
+*/
+class Prefetcher {
+public:
+    virtual ~Prefetcher() = default;
+
+    virtual const char* name() const = 0;
+
+    // line: dirección de la línea accedida; pc: instrucción que la accedió
+    // miss: la línea no estaba en caché; prefetched_hit: primer uso de una línea precargada
+    // Agrega a 'out' las direcciones de línea a precargar
+    virtual void on_access(uint64_t line, uint32_t pc, bool miss, bool prefetched_hit,
+                           std::vector<uint64_t>& out) = 0;
+
+protected:
+    explicit Prefetcher(unsigned line_bytes) : line_bytes_(line_bytes) {}
+    unsigned line_bytes_;
+};
+
+// nullptr con PrefetchKind::NONE
+std::unique_ptr<Prefetcher> make_prefetcher(const PrefetchConfig& config, unsigned line_bytes);
+
+// "none", "next", "stride", "stream"
+PrefetchKind parse_prefetch_kind(const std::string& name);
+const char* prefetch_kind_name(PrefetchKind kind);
+
+#endif // PREFETCHER_H
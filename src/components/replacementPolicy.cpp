@@ -0,0 +1,184 @@
+#include "replacementPolicy.h"
+#include <stdexcept>
+
+namespace {
+
+// Generador xorshift64*: barato y reproducible a partir de la semilla
+class XorShift64 {
+public:
+    explicit XorShift64(uint64_t seed) : state_(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1DULL;
+    }
+private:
+    uint64_t state_;
+};
+
+/* ------------------ LRU verdadero ------------------
+ Edad de 4 bits por vía (0 = MRU, ways-1 = LRU); las edades forman una permutación. */
+class LruPolicy final : public ReplacementPolicy {
+public:
+    explicit LruPolicy(unsigned ways) : ReplacementPolicy(ways) {
+        if (ways > 16) throw std::invalid_argument("LRU soporta hasta 16 vias");
+    }
+    const char* name() const override { return "LRU"; }
+
+    uint64_t initial_state() const override {
+        uint64_t state = 0;
+        for (unsigned w = 0; w < ways_; ++w) state |= static_cast<uint64_t>(w) << (4 * w);
+        return state;
+    }
+    void on_fill(uint64_t& set_state, unsigned way) override { touch(set_state, way); }
+    void on_hit(uint64_t& set_state, unsigned way) override { touch(set_state, way); }
+    unsigned victim(uint64_t& set_state) override {
+        for (unsigned w = 0; w < ways_; ++w) {
+            if (age(set_state, w) == ways_ - 1) return w;
+        }
+        return 0;
+    }
+
+private:
+    static unsigned age(uint64_t state, unsigned way) { return (state >> (4 * way)) & 0xF; }
+
+    void touch(uint64_t& state, unsigned way) const {
+        unsigned old_age = age(state, way);
+        for (unsigned w = 0; w < ways_; ++w) {
+            unsigned a = age(state, w);
+            if (a < old_age) state += 1ULL << (4 * w); // envejecer a las más recientes
+        }
+        state &= ~(0xFULL << (4 * way)); // la vía tocada pasa a MRU
+    }
+};
+
+/* ------------------ Tree-PLRU ------------------
+ Árbol binario implícito de ways-1 nodos; el bit de cada nodo apunta a la mitad a desalojar. */
+class TreePlruPolicy final : public ReplacementPolicy {
+public:
+    explicit TreePlruPolicy(unsigned ways) : ReplacementPolicy(ways) {
+        if (ways > 64 || (ways & (ways - 1)) != 0) {
+            throw std::invalid_argument("Tree-PLRU requiere vias potencia de dos (hasta 64)");
+        }
+    }
+    const char* name() const override { return "TREE_PLRU"; }
+
+    void on_fill(uint64_t& set_state, unsigned way) override { touch(set_state, way); }
+    void on_hit(uint64_t& set_state, unsigned way) override { touch(set_state, way); }
+    unsigned victim(uint64_t& set_state) override {
+        unsigned node = 0;
+        unsigned lo = 0, span = ways_;
+        while (span > 1) {
+            span /= 2;
+            bool right = (set_state >> node) & 1;
+            if (right) lo += span;
+            node = 2 * node + (right ? 2 : 1);
+        }
+        return lo;
+    }
+
+private:
+    void touch(uint64_t& state, unsigned way) const {
+        unsigned node = 0;
+        unsigned lo = 0, span = ways_;
+        while (span > 1) {
+            span /= 2;
+            bool in_right = way >= lo + span;
+            // apuntar a la mitad contraria a la vía usada
+            if (in_right) state &= ~(1ULL << node); else state |= (1ULL << node);
+            if (in_right) lo += span;
+            node = 2 * node + (in_right ? 2 : 1);
+        }
+    }
+};
+
+/* ------------------ SRRIP / BRRIP ------------------
+ RRPV de 2 bits por vía: 0 = re-referencia inminente, 3 = lejana (candidata a desalojo). */
+class RripPolicy final : public ReplacementPolicy {
+public:
+    RripPolicy(unsigned ways, bool bimodal, uint64_t seed)
+        : ReplacementPolicy(ways), bimodal_(bimodal), rng_(seed) {
+        if (ways > 32) throw std::invalid_argument("RRIP soporta hasta 32 vias");
+    }
+    const char* name() const override { return bimodal_ ? "BRRIP" : "SRRIP"; }
+
+    uint64_t initial_state() const override {
+        uint64_t state = 0;
+        for (unsigned w = 0; w < ways_; ++w) state |= static_cast<uint64_t>(RRPV_MAX) << (2 * w);
+        return state;
+    }
+    void on_fill(uint64_t& set_state, unsigned way) override {
+        unsigned insert = RRPV_MAX - 1; // SRRIP: re-referencia "larga"
+        if (bimodal_ && (rng_.next() % BIMODAL_THROTTLE) != 0) insert = RRPV_MAX;
+        set(set_state, way, insert);
+    }
+    void on_hit(uint64_t& set_state, unsigned way) override { set(set_state, way, 0); }
+    unsigned victim(uint64_t& set_state) override {
+        for (;;) {
+            for (unsigned w = 0; w < ways_; ++w) {
+                if (rrpv(set_state, w) == RRPV_MAX) return w;
+            }
+            for (unsigned w = 0; w < ways_; ++w) set(set_state, w, rrpv(set_state, w) + 1);
+        }
+    }
+
+private:
+    static constexpr unsigned RRPV_MAX = 3;
+    static constexpr unsigned BIMODAL_THROTTLE = 32;
+
+    static unsigned rrpv(uint64_t state, unsigned way) { return (state >> (2 * way)) & 0x3; }
+    static void set(uint64_t& state, unsigned way, unsigned value) {
+        state = (state & ~(0x3ULL << (2 * way))) | (static_cast<uint64_t>(value) << (2 * way));
+    }
+
+    bool bimodal_;
+    XorShift64 rng_;
+};
+
+/* ------------------ Aleatoria ------------------ */
+class RandomPolicy final : public ReplacementPolicy {
+public:
+    RandomPolicy(unsigned ways, uint64_t seed) : ReplacementPolicy(ways), rng_(seed) {}
+    const char* name() const override { return "RANDOM"; }
+
+    void on_fill(uint64_t&, unsigned) override {}
+    void on_hit(uint64_t&, unsigned) override {}
+    unsigned victim(uint64_t&) override { return static_cast<unsigned>(rng_.next() % ways_); }
+
+private:
+    XorShift64 rng_;
+};
+
+} // namespace
+
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(ReplacementKind kind, unsigned ways, uint64_t seed) {
+    switch (kind) {
+        case ReplacementKind::LRU: return std::make_unique<LruPolicy>(ways);
+        case ReplacementKind::TREE_PLRU: return std::make_unique<TreePlruPolicy>(ways);
+        case ReplacementKind::SRRIP: return std::make_unique<RripPolicy>(ways, false, seed);
+        case ReplacementKind::BRRIP: return std::make_unique<RripPolicy>(ways, true, seed);
+        case ReplacementKind::RANDOM: return std::make_unique<RandomPolicy>(ways, seed);
+    }
+    throw std::invalid_argument("Politica de reemplazo desconocida");
+}
+
+ReplacementKind parse_replacement_kind(const std::string& name) {
+    if (name == "lru") return ReplacementKind::LRU;
+    if (name == "plru") return ReplacementKind::TREE_PLRU;
+    if (name == "srrip") return ReplacementKind::SRRIP;
+    if (name == "brrip") return ReplacementKind::BRRIP;
+    if (name == "random") return ReplacementKind::RANDOM;
+    throw std::invalid_argument("Politica de reemplazo desconocida: " + name);
+}
+
+const char* replacement_kind_name(ReplacementKind kind) {
+    switch (kind) {
+        case ReplacementKind::LRU: return "LRU";
+        case ReplacementKind::TREE_PLRU: return "TREE_PLRU";
+        case ReplacementKind::SRRIP: return "SRRIP";
+        case ReplacementKind::BRRIP: return "BRRIP";
+        case ReplacementKind::RANDOM: return "RANDOM";
+    }
+    return "UNKNOWN";
+}
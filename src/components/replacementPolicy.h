@@ -0,0 +1,53 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Políticas de reemplazo disponibles para CacheL1::select_victim
+enum class ReplacementKind {
+    LRU,        // LRU verdadero: edad de 4 bits por vía (hasta 16 vías)
+    TREE_PLRU,  // pseudo-LRU en árbol: ways-1 bits (vías potencia de dos, hasta 64)
+    SRRIP,      // Static RRIP: RRPV de 2 bits por vía (hasta 32 vías)
+    BRRIP,      // Bimodal RRIP: inserta lejano salvo 1 de cada 32 fills
+    RANDOM      // aleatoria con semilla (reproducible)
+};
+
+/*
+ Una política guarda todo su estado de un set en una sola palabra de 64 bits
+ (set_state) que la caché mantiene junto a los tags del set. Los objetos de
+ política no guardan estado por set; como mucho un generador con semilla.
+ La caché llena primero las vías inválidas y solo pide victim() con el set lleno.
+*/
+class ReplacementPolicy {
+public:
+    virtual ~ReplacementPolicy() = default;
+
+    virtual const char* name() const = 0;
+
+    // Estado inicial de un set vacío
+    virtual uint64_t initial_state() const { return 0; }
+
+    // Una vía recibió un bloque nuevo
+    virtual void on_fill(uint64_t& set_state, unsigned way) = 0;
+
+    // Acierto del CPU sobre una vía
+    virtual void on_hit(uint64_t& set_state, unsigned way) = 0;
+
+    // Vía a desalojar (todas válidas)
+    virtual unsigned victim(uint64_t& set_state) = 0;
+
+protected:
+    explicit ReplacementPolicy(unsigned ways) : ways_(ways) {}
+    unsigned ways_;
+};
+
+// Lanza std::invalid_argument si la política no soporta ese número de vías
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(ReplacementKind kind, unsigned ways, uint64_t seed);
+
+// "lru", "plru", "srrip", "brrip", "random"
+ReplacementKind parse_replacement_kind(const std::string& name);
+const char* replacement_kind_name(ReplacementKind kind);
+
+#endif // REPLACEMENT_POLICY_H
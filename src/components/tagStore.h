@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cacheLine.h"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ Metadatos de la caché en estructura de arreglos, separados de los datos.
+ Por set: los tags de todas las vías contiguos, una huella de 8 bits por vía
+ (relleno hasta FP_LANES bytes) y máscaras de bits de una palabra para valid,
+ dirty y prefetched; el estado MESI va en un arreglo de bytes aparte. Una
+ búsqueda compara la huella del tag contra todas las vías con una instrucción
+ SIMD por cada 16 vías (SSE2) o 32 (AVX2), filtra con la máscara valid y solo
+ lee el tag completo de las vías candidatas (casi siempre una o ninguna), así
+ el costo no crece con las vías hasta 16/32 ni con los datos de las líneas.
+ Las vías se identifican por su número dentro del set (hasta MAX_WAYS).
+*/
+class TagStore {
+public:
+    static constexpr unsigned MAX_WAYS = 64; // una máscara de 64 bits por set
+    static constexpr unsigned FP_LANES = 32; // relleno de cada fila de huellas
+
+    TagStore(unsigned sets, unsigned ways)
+        : sets_(sets), ways_(ways), fp_stride_((ways + FP_LANES - 1) / FP_LANES * FP_LANES) {
+        if (ways == 0 || ways > MAX_WAYS) throw std::invalid_argument("TagStore: se soportan de 1 a 64 vias");
+        tags_.assign(static_cast<size_t>(sets) * ways, 0);
+        fingerprints_.assign(static_cast<size_t>(sets) * fp_stride_, 0);
+        states_.assign(static_cast<size_t>(sets) * ways, MESI_State::INVALID);
+        valid_.assign(sets, 0);
+        dirty_.assign(sets, 0);
+        prefetched_.assign(sets, 0);
+    }
+
+    unsigned sets() const { return sets_; }
+    unsigned ways() const { return ways_; }
+
+    // Vías válidas del set cuyo tag es 'tag' (a lo sumo una)
+    uint64_t match(uint64_t set, uint64_t tag) const {
+        const uint64_t candidates = fingerprint_match(set, fingerprint(tag)) & valid_[set];
+        const uint64_t* row = &tags_[set * ways_];
+        // Primera candidata sin saltos (acierto o fallo no son predecibles); el resto es raro
+        const unsigned first = static_cast<unsigned>(__builtin_ctzll(candidates | 1ULL << (ways_ - 1)));
+        uint64_t mask = static_cast<uint64_t>(row[first] == tag) << first & candidates;
+        for (uint64_t rest = candidates & (candidates - 1); rest; rest &= rest - 1) {
+            const unsigned w = static_cast<unsigned>(__builtin_ctzll(rest));
+            mask |= static_cast<uint64_t>(row[w] == tag) << w;
+        }
+        return mask;
+    }
+
+    // Vía con 'tag' o -1
+    int find(uint64_t set, uint64_t tag) const {
+        const uint64_t hit = match(set, tag);
+        const int way = __builtin_ctzll(hit | 1ULL << 63);
+        return hit ? way : -1;
+    }
+
+    // Estado de la línea con 'tag' o INVALID, sin saltos (el snoop no sabe si va a acertar)
+    MESI_State lookup_state(uint64_t set, uint64_t tag) const {
+        const uint64_t hit = match(set, tag);
+        const MESI_State state = states_[set * ways_ + __builtin_ctzll(hit | 1ULL << (ways_ - 1))];
+        return hit ? state : MESI_State::INVALID;
+    }
+
+    // Primera vía inválida del set o -1 si está lleno
+    int first_invalid(uint64_t set) const {
+        const uint64_t free = ~valid_[set] & way_mask();
+        return free ? __builtin_ctzll(free) : -1;
+    }
+
+    bool valid(uint64_t set, unsigned way) const { return (valid_[set] >> way) & 1; }
+    bool dirty(uint64_t set, unsigned way) const { return (dirty_[set] >> way) & 1; }
+    bool prefetched(uint64_t set, unsigned way) const { return (prefetched_[set] >> way) & 1; }
+    uint64_t tag(uint64_t set, unsigned way) const { return tags_[set * ways_ + way]; }
+    MESI_State state(uint64_t set, unsigned way) const { return states_[set * ways_ + way]; }
+
+    void set_state(uint64_t set, unsigned way, MESI_State state) { states_[set * ways_ + way] = state; }
+    void set_dirty(uint64_t set, unsigned way, bool on) { assign_bit(dirty_[set], way, on); }
+    void set_prefetched(uint64_t set, unsigned way, bool on) { assign_bit(prefetched_[set], way, on); }
+
+    // Línea nueva: válida, limpia y sin marca de prefetch
+    void fill(uint64_t set, unsigned way, uint64_t tag, MESI_State state) {
+        tags_[set * ways_ + way] = tag;
+        fingerprints_[set * fp_stride_ + way] = fingerprint(tag);
+        states_[set * ways_ + way] = state;
+        assign_bit(valid_[set], way, true);
+        assign_bit(dirty_[set], way, false);
+        assign_bit(prefetched_[set], way, false);
+    }
+
+    void invalidate(uint64_t set, unsigned way) {
+        states_[set * ways_ + way] = MESI_State::INVALID;
+        assign_bit(valid_[set], way, false);
+        assign_bit(dirty_[set], way, false);
+        assign_bit(prefetched_[set], way, false);
+    }
+
+    // Copia de los metadatos de una vía (inspección y depuración)
+    CacheLine line(uint64_t set, unsigned way) const {
+        CacheLine view;
+        view.valid = valid(set, way);
+        view.dirty = dirty(set, way);
+        view.tag = tag(set, way);
+        view.state = state(set, way);
+        view.prefetched = prefetched(set, way);
+        return view;
+    }
+
+private:
+    unsigned sets_;
+    unsigned ways_;
+    unsigned fp_stride_;                 // ways redondeado a FP_LANES
+    std::vector<uint64_t> tags_;         // sets * ways
+    std::vector<uint8_t> fingerprints_;  // sets * fp_stride_
+    std::vector<MESI_State> states_;     // sets * ways
+    std::vector<uint64_t> valid_;        // una máscara por set
+    std::vector<uint64_t> dirty_;
+    std::vector<uint64_t> prefetched_;
+
+    // Pliega los bits del tag en un byte: tags que difieren en cualquier byte bajo no chocan
+    static uint8_t fingerprint(uint64_t tag) {
+        tag ^= tag >> 32;
+        tag ^= tag >> 16;
+        return static_cast<uint8_t>(tag ^ (tag >> 8));
+    }
+
+    // Vías (válidas o no) cuya huella es 'fp'
+    uint64_t fingerprint_match(uint64_t set, uint8_t fp) const {
+        const uint8_t* row = &fingerprints_[set * fp_stride_];
+        uint64_t mask = 0;
+#if defined(__AVX2__)
+        const __m256i key = _mm256_set1_epi8(static_cast<char>(fp));
+        for (unsigned w = 0; w < fp_stride_; w += 32) {
+            const __m256i fps = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+            const uint32_t eq = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(fps, key)));
+            mask |= static_cast<uint64_t>(eq) << w;
+        }
+#elif defined(__SSE2__)
+        const __m128i key = _mm_set1_epi8(static_cast<char>(fp));
+        for (unsigned w = 0; w < fp_stride_; w += 16) {
+            const __m128i fps = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + w));
+            mask |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(fps, key))) << w;
+        }
+#else
+        for (unsigned w = 0; w < ways_; ++w) mask |= static_cast<uint64_t>(row[w] == fp) << w;
+#endif
+        return mask;
+    }
+
+    uint64_t way_mask() const { return ways_ == 64 ? ~0ULL : (1ULL << ways_) - 1; }
+    static void assign_bit(uint64_t& mask, unsigned bit, bool on) {
+        mask = on ? (mask | (1ULL << bit)) : (mask & ~(1ULL << bit));
+    }
+};
@@ -4,20 +4,63 @@
 #include <cstdint>
 
 // Estados del Protocolo MESI (a nivel de linea de cache)
+// OWNED solo existe con MOESI y FORWARD solo con MESIF (ver CoherenceProtocol)
 enum class MESI_State {
     INVALID = 0,
     EXCLUSIVE = 1,
     SHARED = 2,
-    MODIFIED = 3
+    MODIFIED = 3,
+    OWNED = 4,   // sucia y compartida: esta caché responde y hará el write-back
+    FORWARD = 5  // limpia y compartida: esta caché responde en lugar de Memoria
 };
 
+// Letra del estado (I, E, S, M, O, F) para reportes y métricas exportadas
+inline const char* mesi_state_letter(MESI_State state) {
+    switch (state) {
+        case MESI_State::INVALID: return "I";
+        case MESI_State::EXCLUSIVE: return "E";
+        case MESI_State::SHARED: return "S";
+        case MESI_State::MODIFIED: return "M";
+        case MESI_State::OWNED: return "O";
+        case MESI_State::FORWARD: return "F";
+        default: return "?";
+    }
+}
+
+// Variante del protocolo de coherencia (la eligen las cachés, el Bus la respeta)
+enum class CoherenceProtocol {
+    MESI = 0,  // una línea M se escribe a Memoria al ser leída por otra caché
+    MOESI = 1, // una línea M pasa a O y se entrega caché a caché sin write-back
+    MESIF = 2  // la copia limpia en F (o E) se entrega caché a caché sin leer Memoria
+};
+
+inline const char* coherence_protocol_name(CoherenceProtocol protocol) {
+    switch (protocol) {
+        case CoherenceProtocol::MESI: return "MESI";
+        case CoherenceProtocol::MOESI: return "MOESI";
+        case CoherenceProtocol::MESIF: return "MESIF";
+        default: return "UNKNOWN";
+    }
+}
+
 // Comando de Transaccion en el Bus
 enum class BusCommand {
     BUS_READ = 0,
     BUS_READ_X = 1,
-    INVALIDATE = 2,
+    INVALIDATE = 2, // BusUpgr: S/F/O -> M sin transferencia de datos
     BUS_WRITE = 3,
     NONE = 99
 };
 
+// Nombre del comando para los mensajes del Bus (y el decodificador de trazas)
+inline const char* bus_command_name(BusCommand cmd) {
+    switch (cmd) {
+        case BusCommand::BUS_READ: return "BusRd (LECTURA)";
+        case BusCommand::BUS_READ_X: return "BusRdX (ESCRITURA EXCL.)";
+        case BusCommand::INVALIDATE: return "BusUpgr (INVALIDATE)";
+        case BusCommand::BUS_WRITE: return "BusWr (WRITE-BACK)";
+        default: return "NONE/UNKNOWN";
+    }
+}
+
 #endif // BUS_ENUMS_H
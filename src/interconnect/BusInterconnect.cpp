@@ -1,146 +1,538 @@
 #include "BusInterconnect.h"
 #include <iostream>
-#include <functional>
 #include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "../utils/trace.h"
 
 
-BusInterconnect::BusInterconnect(std::vector<CacheL1*>& caches, Memory* memory, bool debug)
-    : caches_(caches),
+BusInterconnect::BusInterconnect(std::vector<CacheL1*>& caches, Memory* memory, EventScheduler& scheduler,
+                                 bool debug, BusTiming timing, std::ostream& log)
+    : debug_(debug),
+    log_(&log),
+    caches_(caches),
     memory_(memory),
-    running_(true),
-    debug_(debug)
+    scheduler_(scheduler),
+    timing_(timing),
+    line_bytes_(caches.empty() ? CacheL1::BLOCK_BYTES : caches[0]->line_bytes()),
+    protocol_(caches.empty() ? CoherenceProtocol::MESI : caches[0]->protocol())
 {
-    std::cout << "BusInterconnect: Inicializando Interconector con " 
+    for (CacheL1* cache : caches_) {
+        if (cache->line_bytes() != line_bytes_) {
+            throw std::invalid_argument("BusInterconnect: todas las caches deben usar el mismo tamaño de línea");
+        }
+        if (cache->protocol() != protocol_) {
+            throw std::invalid_argument("BusInterconnect: todas las caches deben usar el mismo protocolo de coherencia");
+        }
+    }
+    if (timing_.max_outstanding == 0) {
+        throw std::invalid_argument("BusInterconnect: max_outstanding debe ser al menos 1");
+    }
+    in_flight_.resize(timing_.max_outstanding);
+    for (InFlight& slot : in_flight_) slot.data.resize(line_bytes_);
+    snoop_block_.resize(line_bytes_);
+
+    *log_ << "BusInterconnect: Inicializando Interconector con " 
     << caches_.size() << " caches.\n";
     
-    last_granted_pe_ = 3; 
-    std::cout << "Lógica de Arbitraje: Iniciando Round-Robin. El próximo PE a buscar es PE " 
-    << (last_granted_pe_ + 1) % 4 << ".\n"; 
-
-    bus_thread_ = std::thread(&BusInterconnect::run, this);
-    std::cout << "Hilo de Arbitraje del Bus inicializado.\n";
+    num_pes_ = static_cast<int>(caches_.size());
+    if (num_pes_ == 0 || num_pes_ > MAX_PES) {
+        throw std::invalid_argument("BusInterconnect: se soportan de 1 a " + std::to_string(MAX_PES) + " caches");
+    }
+    all_pes_mask_ = num_pes_ == MAX_PES ? ~0ULL : (1ULL << num_pes_) - 1;
+    request_rings_.reserve(num_pes_);
+    prefetch_rings_.reserve(num_pes_);
+    for (int i = 0; i < num_pes_; ++i) {
+        request_rings_.push_back(std::make_unique<RequestRing>());
+        prefetch_rings_.push_back(std::make_unique<RequestRing>());
+    }
+    last_granted_pe_ = num_pes_ - 1; 
+    *log_ << "Lógica de Arbitraje: Iniciando Round-Robin. El próximo PE a buscar es PE " 
+    << (last_granted_pe_ + 1) % num_pes_ << ".\n"; 
 }
 
 BusInterconnect::~BusInterconnect(){
-    stop_flag_ = true;
-    if (bus_thread_.joinable()) {
-        bus_thread_.join();
+    *log_ << "BusInterconnect: " << transactions_ << " transacciones procesadas.\n";
+}
+
+void BusInterconnect::add_request(const BusTransaction& transaction) {
+    BusTransaction queued = transaction;
+    queued.issue_cycle = scheduler_.now();
+    if (queued.pe_id < 0 || queued.pe_id >= num_pes_) {
+        throw std::out_of_range("BusInterconnect: pe_id fuera de rango");
     }
+    if (queued.prefetch) {
+        // Un prefetch es descartable: con la cola llena, o si la única ranura en vuelo
+        // la necesita la demanda (max_outstanding 1), simplemente no se emite
+        if (timing_.max_outstanding == 1 || !prefetch_rings_[queued.pe_id]->try_push(std::move(queued))) {
+            drop_prefetch(transaction);
+            return;
+        }
+        prefetch_mask_.fetch_or(1ULL << transaction.pe_id, std::memory_order_release);
+        try_schedule_arbitration();
+        return;
+    }
+    if (!request_rings_[queued.pe_id]->try_push(std::move(queued))) {
+        throw std::overflow_error("BusInterconnect: cola de peticiones del PE llena");
+    }
+    pending_mask_.fetch_or(1ULL << transaction.pe_id, std::memory_order_release);
+    try_schedule_arbitration();
+}
 
-    std::cout << "BusInterconnect: Hilo de Arbitraje finalizado.\n";
+void BusInterconnect::set_llc(SharedLLC* llc) {
+    llc_ = llc;
+    for (CacheL1* cache : caches_) cache->set_next_level(llc);
+    if (!llc_) return;
+    llc_->set_back_invalidate([this](uint64_t address, uint8_t* dirty_block) {
+        // Como un BusRdX sin solicitante: todas las L1 invalidan y la sucia entrega su dato
+        bool dirty = false;
+        const uint64_t line = address / line_bytes_;
+        for (int i = 0; i < num_pes_; ++i) {
+            if (caches_[i]->snoop_bus_rdx(address, dirty_block).had_modified) dirty = true;
+            if (timing_.snoop_filter) snoop_filter_.remove(line, i);
+        }
+        return dirty;
+    });
 }
 
-void BusInterconnect::stop(){
-    running_.store(false);
-    if (debug_) stop_flag_ = true;
-    if (bus_thread_.joinable()) bus_thread_.join();
+void BusInterconnect::restore_arbitration(int last_granted_pe) {
+    if (!idle()) throw std::logic_error("BusInterconnect::restore_arbitration: el Bus no esta inactivo");
+    if (last_granted_pe < -1 || last_granted_pe >= num_pes_) {
+        throw std::invalid_argument("BusInterconnect::restore_arbitration: PE fuera de rango");
+    }
+    last_granted_pe_ = last_granted_pe;
+    snoop_filter_ = SnoopFilter{};
+    for (int i = 0; i < num_pes_; ++i) {
+        for (uint64_t address : caches_[i]->resident_lines()) snoop_filter_.add(address / line_bytes_, i);
+    }
 }
 
-void BusInterconnect::add_request(const BusTransaction& transaction) {
-    request_queue_.push(transaction);
-}
-
-void BusInterconnect::run() {
-    bool processing = true;
-    while(!stop_flag_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        if (!request_queue_.empty()) {
-            std::cout << "\n[BUS] Peticiones en cola. Iniciando ciclo de Arbitraje...\n";
-            arbitrate_and_process();
-            processing = false;
-        } else if (!processing && !debug_) {
-            std::cout << "[BUS] No hay más peticiones en cola. Esperando nuevas solicitudes...\n";
-            stop_flag_ = true;
-        }
+void BusInterconnect::try_schedule_arbitration() {
+    // Un arbitraje a la vez, con el bus de direcciones libre y una ranura en vuelo disponible
+    if (arbitration_scheduled_ || address_bus_busy_ || outstanding_ >= timing_.max_outstanding) return;
+    if ((pending_mask_.load(std::memory_order_acquire) & ~blocked_mask_) == 0 &&
+        prefetch_mask_.load(std::memory_order_acquire) == 0) return;
+    arbitration_scheduled_ = true;
+    scheduler_.schedule(timing_.arbitration, [this] { arbitrate_and_process(); });
+}
+
+BusInterconnect::InFlight* BusInterconnect::find_in_flight(uint64_t line) {
+    for (InFlight& slot : in_flight_) {
+        if (slot.active && slot.line == line) return &slot;
     }
+    return nullptr;
 }
 
 void BusInterconnect::arbitrate_and_process() {
-    int next_pe_id = (last_granted_pe_ + 1) % 4;
+    arbitration_scheduled_ = false;
+    int next_pe_id = (last_granted_pe_ + 1) % num_pes_;
 
-    BusTransaction active_transaction = request_queue_.pop_priority(last_granted_pe_);
+    // Siguiente PE en Round-Robin cuya petición en cabeza no choca con una línea en vuelo
+    int pe = -1;
+    uint64_t line = 0;
+    bool prefetch = false;
+    for (;;) {
+        uint64_t eligible = pending_mask_.load(std::memory_order_acquire) & ~blocked_mask_;
+        if (eligible != 0) {
+            pe = next_requester(eligible, last_granted_pe_);
+            line = request_rings_[pe]->front()->address / line_bytes_;
+            InFlight* owner = find_in_flight(line);
+            if (!owner) {
+                const BusTransaction& head = *request_rings_[pe]->front();
+                const MESI_State state = caches_[pe]->get_line_state(head.address);
+                if (head.command != BusCommand::BUS_READ || state == MESI_State::INVALID) break;
+                // Un prefetch propio trajo la línea mientras el BusRd esperaba: no necesita el Bus
+                BusTransaction served = pop_request(pe);
+                caches_[pe]->load_block_from_bus(served.address, nullptr, state, false);
+                reads_served_by_prefetch_++;
+                scheduler_.schedule(0, [done = std::move(served.on_complete)] { if (done) done(); });
+                continue;
+            }
+            blocked_mask_ |= 1ULL << pe;
+            owner->waiters |= 1ULL << pe;
+            line_conflicts_++;
+            continue;
+        }
+        // Sin peticiones a demanda elegibles: turno de los prefetches
+        uint64_t prefetching = prefetch_mask_.load(std::memory_order_acquire);
+        if (prefetching == 0) return; // se reintenta al terminar la transacción que bloquea
+        pe = next_requester(prefetching, last_granted_pe_);
+        const BusTransaction& head = *prefetch_rings_[pe]->front();
+        line = head.address / line_bytes_;
+        if (!caches_[pe]->prefetch_in_flight(head.address)) {
+            // Cancelado: un miss a demanda ya pidió la línea
+            pop_prefetch(pe);
+            prefetches_cancelled_++;
+            continue;
+        }
+        if (!find_in_flight(line) && caches_[pe]->get_line_state(head.address) == MESI_State::INVALID) {
+            prefetch = true;
+            break;
+        }
+        drop_prefetch(pop_prefetch(pe)); // ya no hace falta
+    }
+
+    size_t index = 0;
+    while (in_flight_[index].active) ++index;
+    InFlight& slot = in_flight_[index];
+    slot.active = true;
+    slot.transaction = prefetch ? pop_prefetch(pe) : pop_request(pe);
+    slot.line = line;
+    slot.waiters = 0;
+    if (prefetch) {
+        prefetches_granted_++;
+    } else {
+        const Cycle waited = scheduler_.now() - slot.transaction.issue_cycle;
+        wait_cycles_ += waited;
+        arbitration_wait_.record(waited);
+    }
+    address_bus_cycles_ += timing_.arbitration + timing_.snoop;
+    if (outstanding_++ == 0) busy_since_ = scheduler_.now();
+    if (outstanding_ > peak_outstanding_) peak_outstanding_ = outstanding_;
+
+    last_granted_pe_ = pe;
+    MESI_TRACE(TraceEvent::BUS_GRANT, pe, (last_granted_pe_ + 1) % num_pes_, next_pe_id);
+
+    Cycle data_ready = scheduler_.now() + process_transaction(slot);
+    transactions_++;
+    const bool dram_access = dram_ && slot.memory_op != InFlight::MemoryOp::NONE;
+
+    // Fin de la fase de snoop: el bus de direcciones acepta la siguiente petición
+    if (timing_.max_outstanding > 1) {
+        address_bus_busy_ = true;
+        scheduler_.schedule(timing_.snoop, [this] {
+            address_bus_busy_ = false;
+            try_schedule_arbitration();
+        });
+    }
 
-    std::cout << "[BUS ARBITRADO] PE " << active_transaction.pe_id 
-    << " ha ganado el acceso (Prioridad iniciada en PE " << next_pe_id << ").\n";
+    if (slot.transaction.command == BusCommand::INVALIDATE) {
+        // Sin bloque que entregar: no usa el bus de datos
+        scheduler_.schedule_at(data_ready, [this, index] { finish_transaction(index); });
+        return;
+    }
+    if (dram_access) {
+        // La DRAM se consulta al terminar el snoop (y la búsqueda en la LLC)
+        start_dram_phase(index, timing_.snoop + slot.llc_latency);
+        return;
+    }
+    start_data_phase(index, data_ready);
+}
 
-    last_granted_pe_ = active_transaction.pe_id;
-    std::cout << "\t-> Bus bloqueado. Próxima búsqueda Round-Robin iniciará en PE " 
-    << (last_granted_pe_ + 1) % 4 << ".\n";
+void BusInterconnect::start_dram_phase(size_t index, Cycle delay) {
+    scheduler_.schedule(delay, [this, index] {
+        const InFlight& pending = in_flight_[index];
+        dram_->access(pending.transaction.address, pending.memory_op == InFlight::MemoryOp::WRITEBACK,
+                      [this, index](Cycle done) { start_data_phase(index, done); });
+    });
+}
+
+void BusInterconnect::start_data_phase(size_t index, Cycle ready) {
+    // Fase de datos: el bus de datos transfiere un bloque a la vez
+    Cycle transfer_start = std::max(ready, data_bus_free_at_);
+    data_bus_free_at_ = transfer_start + timing_.block_transfer;
+    data_bus_cycles_ += timing_.block_transfer;
+    data_bytes_ += line_bytes_;
+    scheduler_.schedule_at(data_bus_free_at_, [this, index] { finish_transaction(index); });
+}
 
-    process_transaction(active_transaction);
+int BusInterconnect::next_requester(uint64_t pending, int last_granted) {
+    // Rotar la máscara para que el PE last_granted+1 quede en el bit 0; el primer
+    // bit encendido es el siguiente en orden Round-Robin. Los bits >= num_pes_ son 0.
+    unsigned start = static_cast<unsigned>(last_granted + 1) & (MAX_PES - 1);
+    uint64_t rotated = start ? (pending >> start) | (pending << (MAX_PES - start)) : pending;
+    return static_cast<int>((start + __builtin_ctzll(rotated)) & (MAX_PES - 1));
 }
 
-void BusInterconnect::process_transaction(BusTransaction& transaction) {
-    std::array<uint8_t, CacheL1::BLOCK_BYTES> data_block; // ahora 32B
+BusTransaction BusInterconnect::pop_request(int pe) {
+    return pop_from(*request_rings_[pe], pending_mask_, pe);
+}
+
+BusTransaction BusInterconnect::pop_prefetch(int pe) {
+    return pop_from(*prefetch_rings_[pe], prefetch_mask_, pe);
+}
+
+BusTransaction BusInterconnect::pop_from(RequestRing& ring, std::atomic<uint64_t>& mask, int pe) {
+    BusTransaction transaction = std::move(*ring.try_pop());
+
+    if (ring.empty()) {
+        const uint64_t bit = 1ULL << pe;
+        mask.fetch_and(~bit, std::memory_order_acq_rel);
+        // el productor pudo encolar entre el empty() y el borrado del bit
+        if (!ring.empty()) mask.fetch_or(bit, std::memory_order_release);
+    }
+    return transaction;
+}
+
+void BusInterconnect::drop_prefetch(const BusTransaction& transaction) {
+    prefetches_dropped_++;
+    caches_[transaction.pe_id]->note_prefetch_dropped(transaction.address);
+}
+
+void BusInterconnect::finish_transaction(size_t index) {
+    // Fin de la fase de datos: entregar el bloque a la caché solicitante y completar su acceso
+    InFlight& slot = in_flight_[index];
+    if (slot.transaction.command == BusCommand::INVALIDATE &&
+        caches_[slot.transaction.pe_id]->get_line_state(slot.transaction.address) == MESI_State::INVALID) {
+        // El solicitante perdió su copia durante el upgrade (desalojo por un fill o por la
+        // back-invalidation de la LLC): los demás ya invalidaron y el dato vigente está abajo.
+        // Sigue como un BusRdX con su fase de memoria y su fase de datos.
+        slot.transaction.command = BusCommand::BUS_READ_X;
+        upgrades_converted_++;
+        MESI_TRACE(TraceEvent::BUS_DATA_FROM_MEMORY, slot.transaction.pe_id, slot.transaction.address, 0);
+        const Cycle latency = read_from_below(slot);
+        if (dram_ && slot.memory_op != InFlight::MemoryOp::NONE) start_dram_phase(index, slot.llc_latency);
+        else start_data_phase(index, scheduler_.now() + latency);
+        return;
+    }
+    BusTransaction transaction = std::move(slot.transaction);
+
+    if (transaction.prefetch) {
+        caches_[transaction.pe_id]->load_prefetch_from_bus(transaction.address, slot.data.data(), slot.fill_state);
+    } else {
+        caches_[transaction.pe_id]->load_block_from_bus(
+            transaction.address, 
+            transaction.command == BusCommand::INVALIDATE ? nullptr : slot.data.data(), 
+            slot.fill_state,
+            transaction.command != BusCommand::BUS_READ
+        );
+    }
+    if (timing_.snoop_filter) snoop_filter_.add(slot.line, transaction.pe_id);
+
+    // Liberar la ranura y los PEs que esperaban esta línea
+    slot.active = false;
+    blocked_mask_ &= ~slot.waiters;
+    slot.waiters = 0;
+    if (--outstanding_ == 0) busy_cycles_ += scheduler_.now() - busy_since_;
+    if (!transaction.prefetch) transaction_latency_.record(scheduler_.now() - transaction.issue_cycle);
+
+    if (transaction.on_complete) transaction.on_complete();
+
+    // Si quedan peticiones se arbitra de nuevo
+    try_schedule_arbitration();
+}
+
+double BusInterconnect::get_throughput() const {
+    Cycle total = scheduler_.now();
+    return total ? static_cast<double>(transactions_) / total : 0.0;
+}
+
+void BusInterconnect::print_stats(std::ostream& out) const {
+    Cycle total = scheduler_.now();
+    out << "[BUS] Transacciones: " << transactions_
+              << " Ciclos ocupado: " << busy_cycles_
+              << " Utilizacion: " << (total ? (100.0 * busy_cycles_ / total) : 0.0) << "%"
+              << " Espera promedio: " << (transactions_ ? (static_cast<double>(wait_cycles_) / transactions_) : 0.0)
+              << " ciclos\n";
+    out << "[BUS] Throughput: " << get_throughput() << " trans/ciclo"
+              << " En vuelo max: " << peak_outstanding_ << "/" << timing_.max_outstanding
+              << " Conflictos de linea: " << line_conflicts_ << "\n";
+    out << "[BUS] Snoops realizados: " << snoops_performed_
+              << " Snoops evitados: " << snoops_avoided_
+              << " (filtro " << (timing_.snoop_filter ? "activo" : "inactivo") << ")\n";
+    out << "[BUS] Protocolo " << coherence_protocol_name(protocol_)
+              << " Lecturas a memoria: " << memory_reads_ << " (ahorradas " << memory_reads_saved_ << ")"
+              << " Write-backs: " << memory_writebacks_ << " (ahorrados " << memory_writebacks_saved_ << ")\n";
+    out << "[BUS] Bytes de datos: " << data_bytes_ << " Bytes de control: " << control_bytes_
+              << " Upgrades (BusUpgr): " << upgrades_ << " (convertidos a BusRdX: " << upgrades_converted_ << ")\n";
+    if (prefetches_granted_ || prefetches_dropped_ || prefetches_cancelled_) {
+        out << "[BUS] Prefetches concedidos: " << prefetches_granted_
+                  << " descartados: " << prefetches_dropped_ << " cancelados: " << prefetches_cancelled_
+                  << " BusRd resueltos por un prefetch en vuelo: " << reads_served_by_prefetch_ << "\n";
+    }
+}
+
+void BusInterconnect::export_metrics(MetricsRegistry& registry) const {
+    const Cycle total = scheduler_.now();
+    auto share = [total](Cycle cycles) { return total ? static_cast<double>(cycles) / total : 0.0; };
+    registry.counter("bus", "transactions", transactions_);
+    registry.counter("bus", "busy_cycles", busy_cycles_);
+    registry.counter("bus", "address_bus_cycles", address_bus_cycles_);
+    registry.counter("bus", "data_bus_cycles", data_bus_cycles_);
+    registry.counter("bus", "wait_cycles", wait_cycles_);
+    registry.counter("bus", "line_conflicts", line_conflicts_);
+    registry.counter("bus", "peak_outstanding", peak_outstanding_);
+    registry.counter("bus", "snoops_performed", snoops_performed_);
+    registry.counter("bus", "snoops_avoided", snoops_avoided_);
+    registry.counter("bus", "upgrades", upgrades_);
+    registry.counter("bus", "upgrades_converted", upgrades_converted_);
+    registry.counter("bus", "memory_reads", memory_reads_);
+    registry.counter("bus", "memory_writebacks", memory_writebacks_);
+    registry.counter("bus", "memory_reads_saved", memory_reads_saved_);
+    registry.counter("bus", "memory_writebacks_saved", memory_writebacks_saved_);
+    registry.counter("bus", "memory_read_bytes", memory_reads_ * line_bytes_);
+    registry.counter("bus", "memory_write_bytes", memory_writebacks_ * line_bytes_);
+    registry.counter("bus", "data_bytes", data_bytes_);
+    registry.counter("bus", "control_bytes", control_bytes_);
+    registry.counter("bus", "prefetches_granted", prefetches_granted_);
+    registry.counter("bus", "prefetches_dropped", prefetches_dropped_);
+    registry.counter("bus", "prefetches_cancelled", prefetches_cancelled_);
+    registry.counter("bus", "reads_served_by_prefetch", reads_served_by_prefetch_);
+    // Ocupación: fracción de los ciclos simulados con el bus (o cada sub-bus) en uso
+    registry.gauge("bus", "occupancy", share(busy_cycles_));
+    registry.gauge("bus", "address_bus_occupancy", share(address_bus_cycles_));
+    registry.gauge("bus", "data_bus_occupancy", share(data_bus_cycles_));
+    registry.gauge("bus", "throughput", get_throughput());
+    registry.histogram("bus", "arbitration_wait", arbitration_wait_);
+    registry.histogram("bus", "transaction_latency", transaction_latency_);
+}
+
+Cycle BusInterconnect::process_transaction(InFlight& slot) {
+    BusTransaction& transaction = slot.transaction;
+    Cycle latency = timing_.snoop + timing_.memory_access;
+    std::vector<uint8_t>& data_block = slot.data; // una línea completa de caché
     int data_provider_pe = -1;
+    bool dirty_retained = false; // MOESI: el dato sucio no necesita write-back
+
+    slot.memory_op = InFlight::MemoryOp::NONE;
+    slot.llc_latency = 0;
+    control_bytes_ += CONTROL_BYTES;
+    if (transaction.command == BusCommand::INVALIDATE) {
+        if (caches_[transaction.pe_id]->get_line_state(transaction.address) != MESI_State::INVALID) {
+            return process_upgrade(slot);
+        }
+        // La copia local se invalidó mientras esperaba el Bus: necesita el bloque
+        transaction.command = BusCommand::BUS_READ_X;
+        upgrades_converted_++;
+    }
+
+    MESI_TRACE(TraceEvent::BUS_BROADCAST, transaction.pe_id, transaction.address, transaction.command);
 
-    std::cout << "[BUS DIFUSIÓN] Difundiendo " 
-    << get_command_name(transaction.command) << " @ 0x" 
-    << std::hex << transaction.address << std::dec 
-    << " (Solicitado por PE " << transaction.pe_id << ").\n";
+    // Cachés a consultar: todas las demás, o solo las que el filtro marca como posibles compartidoras
+    const uint64_t others = all_pes_mask_ & ~(1ULL << transaction.pe_id);
+    uint64_t targets = timing_.snoop_filter ? (snoop_filter_.sharers(slot.line) & others) : others;
+    snoops_avoided_ += __builtin_popcountll(others & ~targets);
 
-    for (int i = 0; i < 4; ++i) {
-        if (i == transaction.pe_id) continue;
+    for (; targets != 0; targets &= targets - 1) {
+        const int i = __builtin_ctzll(targets);
+        snoops_performed_++;
 
         CacheL1::BusSnoopResult snoop_result;
 
         if (transaction.command == BusCommand::BUS_READ) {
-            snoop_result = caches_[i]->snoop_bus_rd(transaction.address);
+            snoop_result = caches_[i]->snoop_bus_rd(transaction.address, snoop_block_.data());
         } else if (transaction.command == BusCommand::BUS_READ_X) {
-            snoop_result = caches_[i]->snoop_bus_rdx(transaction.address);
+            snoop_result = caches_[i]->snoop_bus_rdx(transaction.address, snoop_block_.data());
         }
 
         if (snoop_result.had_modified) {
-            std::cout << "\t<- Snooping: PE " << i << " tenía el dato en estado MODIFIED (M). REQUIERE WRITE-BACK.\n";
+            MESI_TRACE(snoop_result.dirty_retained ? TraceEvent::BUS_SNOOP_OWNER : TraceEvent::BUS_SNOOP_MODIFIED,
+                       i, transaction.address, 0);
             if (!transaction.hit_modified) {
                 transaction.hit_modified = true;
                 data_provider_pe = i;
-                std::memcpy(data_block.data(), snoop_result.data.data(), CacheL1::BLOCK_BYTES);
+                dirty_retained = snoop_result.dirty_retained;
+                std::memcpy(data_block.data(), snoop_block_.data(), data_block.size());
             }
         }
         
         if (snoop_result.had_shared) {
             transaction.hit_shared = true;
-            std::cout << "\t<- Snooping: PE " << i << " tenía el dato en estado SHARED/EXCLUSIVE (S/E).\n";
+            if (snoop_result.supplied) {
+                // MESIF: copia limpia en F/E; el bloque no se lee de Memoria
+                MESI_TRACE(TraceEvent::BUS_SNOOP_FORWARD, i, transaction.address, 0);
+                if (data_provider_pe < 0) {
+                    data_provider_pe = i;
+                    std::memcpy(data_block.data(), snoop_block_.data(), data_block.size());
+                }
+            } else {
+                MESI_TRACE(TraceEvent::BUS_SNOOP_SHARED, i, transaction.address, 0);
+            }
+        }
+
+        // Invalidada por BusRdX, o ya no la tenía (desalojo silencioso): bit obsoleto
+        if (timing_.snoop_filter && (transaction.command == BusCommand::BUS_READ_X ||
+                                     (!snoop_result.had_modified && !snoop_result.had_shared))) {
+            snoop_filter_.remove(slot.line, i);
         }
     }
 
     if (transaction.hit_modified) {
-        std::cout << "[RESOLUCIÓN] Datos obtenidos de Caché PE " << data_provider_pe << ".\n";
+        MESI_TRACE(TraceEvent::BUS_DATA_FROM_CACHE, data_provider_pe, transaction.address, 0);
         
-        memory_->write_block(transaction.address, reinterpret_cast<const uint64_t *>(data_block.data()));
-        std::cout << "[MEM] Write-back completado a Memoria (32B).\n";
+        if (dirty_retained) {
+            // MOESI: el dueño (O) o el solicitante (M) conserva el dato sucio
+            memory_writebacks_saved_++;
+            latency = timing_.snoop + timing_.cache_transfer;
+        } else if (llc_ && llc_->write_back(transaction.address, data_block.data())) {
+            // La LLC tiene la línea: absorbe el write-back sin ir a Memoria
+            data_bytes_ += line_bytes_;
+            latency = timing_.snoop + llc_->config().hit_latency;
+            MESI_TRACE(TraceEvent::BUS_WRITEBACK_DONE, data_block.size(), transaction.address, 0);
+        } else {
+            memory_->write_block(transaction.address, data_block.data(), data_block.size());
+            memory_writebacks_++;
+            data_bytes_ += line_bytes_;
+            slot.memory_op = InFlight::MemoryOp::WRITEBACK;
+            MESI_TRACE(TraceEvent::BUS_WRITEBACK_DONE, data_block.size(), transaction.address, 0);
+        }
+    } else if (data_provider_pe >= 0) {
+        MESI_TRACE(TraceEvent::BUS_DATA_FROM_CACHE, data_provider_pe, transaction.address, 0);
+        memory_reads_saved_++;
+        latency = timing_.snoop + timing_.cache_transfer;
     } else {
-        std::cout << "[RESOLUCIÓN] Accediendo a Memoria Principal.\n";
-
-        memory_->read_block(transaction.address, reinterpret_cast<uint64_t *>(data_block.data()));
-        transaction.data_from_memory = true;
+        MESI_TRACE(TraceEvent::BUS_DATA_FROM_MEMORY, transaction.pe_id, transaction.address, 0);
+        latency = timing_.snoop + read_from_below(slot);
     }
 
     bool others_have = transaction.hit_shared || transaction.hit_modified;
 
     if (transaction.command == BusCommand::BUS_READ_X) {
         others_have = false;
-        std::cout << "\t-> Escritura (BusRdX): Garantizando estado EXCLUSIVE para PE " << transaction.pe_id << ".\n";
-    } else {
-        std::cout << "\t-> Lectura (BusRd): Estado final es " << (others_have ? "SHARED" : "EXCLUSIVE") << ".\n";
+    }
+    // Con MESIF la copia más reciente queda en F: es la que responde al próximo BusRd
+    slot.fill_state = !others_have ? MESI_State::EXCLUSIVE
+                    : protocol_ == CoherenceProtocol::MESIF ? MESI_State::FORWARD : MESI_State::SHARED;
+    MESI_TRACE(TraceEvent::BUS_RESULT, transaction.pe_id, slot.fill_state, transaction.command);
+
+    MESI_TRACE(TraceEvent::BUS_END, transaction.pe_id, transaction.address, 0);
+    return latency;
+}
+
+Cycle BusInterconnect::process_upgrade(InFlight& slot) {
+    BusTransaction& transaction = slot.transaction;
+    MESI_TRACE(TraceEvent::BUS_BROADCAST, transaction.pe_id, transaction.address, transaction.command);
+
+    const uint64_t others = all_pes_mask_ & ~(1ULL << transaction.pe_id);
+    uint64_t targets = timing_.snoop_filter ? (snoop_filter_.sharers(slot.line) & others) : others;
+    snoops_avoided_ += __builtin_popcountll(others & ~targets);
+
+    for (; targets != 0; targets &= targets - 1) {
+        const int i = __builtin_ctzll(targets);
+        snoops_performed_++;
+        if (caches_[i]->invalidate_line(transaction.address)) {
+            transaction.hit_shared = true;
+            MESI_TRACE(TraceEvent::BUS_SNOOP_SHARED, i, transaction.address, 0);
+        }
+        if (timing_.snoop_filter) snoop_filter_.remove(slot.line, i);
     }
 
-    caches_[transaction.pe_id]->load_block_from_bus(
-        transaction.address, 
-        data_block.data(), 
-        others_have
-    );
+    // El solicitante ya tiene el dato vigente: queda como único dueño
+    slot.fill_state = MESI_State::EXCLUSIVE;
+    upgrades_++;
+    MESI_TRACE(TraceEvent::BUS_RESULT, transaction.pe_id, slot.fill_state, transaction.command);
+    MESI_TRACE(TraceEvent::BUS_END, transaction.pe_id, transaction.address, 0);
+    return timing_.snoop;
+}
 
-    std::cout << "--------------------------------------------------------\n";
+Cycle BusInterconnect::read_from_below(InFlight& slot) {
+    BusTransaction& transaction = slot.transaction;
+    if (llc_) {
+        const SharedLLC::Access access = llc_->read_block(transaction.address, slot.data.data());
+        slot.llc_latency = access.latency;
+        if (access.hit) return access.latency;
+        memory_reads_++;
+        slot.memory_op = InFlight::MemoryOp::READ;
+        transaction.data_from_memory = true;
+        return access.latency + timing_.memory_access;
+    }
+    memory_->read_block(transaction.address, slot.data.data(), slot.data.size());
+    memory_reads_++;
+    slot.memory_op = InFlight::MemoryOp::READ;
+    transaction.data_from_memory = true;
+    return timing_.memory_access;
 }
 
 std::string BusInterconnect::get_command_name(BusCommand cmd) const {
-    switch (cmd) {
-        case BusCommand::BUS_READ: return "BusRd (LECTURA)";
-        case BusCommand::BUS_READ_X: return "BusRdX (ESCRITURA EXCL.)";
-        case BusCommand::INVALIDATE: return "Invalidate";
-        case BusCommand::BUS_WRITE: return "BusWr (WRITE-BACK)";
-        default: return "NONE/UNKNOWN";
-    }
-}
\ No newline at end of file
+    return bus_command_name(cmd);
+}
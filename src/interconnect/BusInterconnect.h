@@ -1,53 +1,230 @@
 #ifndef BUS_INTERCONNECT_H
 #define BUS_INTERCONNECT_H
 
-#include <thread>
-#include <mutex>
+#include <atomic>
+#include <iostream>
 #include <vector>
 #include <memory>
-#include <atomic>
+#include <string>
 #include "BusTransaction.h"
-#include "../utils/ConcurrentQueue.h"
+#include "../utils/SpscRing.h"
+#include "../utils/histogram.h"
+#include "../utils/metricsRegistry.h"
+#include "SnoopFilter.h"
 #include "../components/memory.h"
 #include "../components/cacheL1.h"
+#include "../components/dram.h"
+#include "../components/llc.h"
+#include "../sim/EventScheduler.h"
+
+// Latencias (en ciclos) de cada fase de una transacción del Bus y su capacidad
+struct BusTiming {
+    Cycle arbitration = 1;    // conceder el bus al siguiente PE (Round-Robin)
+    Cycle snoop = 2;          // difusión y respuesta de snooping de las demás cachés
+    Cycle memory_access = 20; // lectura o write-back de un bloque en Memoria (sin DramModel)
+    Cycle cache_transfer = 6; // bloque suministrado por otra caché sin pasar por Memoria (MOESI/MESIF)
+    Cycle block_transfer = 4; // entrega del bloque a la caché solicitante (bus de datos)
+    // Transacciones en vuelo a la vez (bus de transacción partida); 1 = bus atómico
+    unsigned max_outstanding = 1;
+    // Difundir cada snoop solo a las cachés que pueden tener la línea (SnoopFilter)
+    bool snoop_filter = false;
+};
+
+/*
+ Bus de transacción partida. Cada transacción pasa por:
+  1) petición: arbitraje Round-Robin y difusión en el bus de direcciones;
+  2) snoop: las demás cachés responden y cambian de estado (punto de serialización);
+     el bus de direcciones queda libre para la siguiente petición;
+  3) memoria: lectura o write-back del bloque; con MOESI/MESIF, si otra caché
+     suministra el bloque (O/M sucio sin write-back, F/E limpio) se omite Memoria
+     y la fase dura cache_transfer;
+  4) datos: el bloque viaja por el bus de datos (uno a la vez) y se entrega a la caché.
+ Con un DramModel (set_dram) la fase de memoria se encola en la DRAM al terminar el
+ snoop y dura lo que ésta indique; sin él dura memory_access ciclos fijos.
+ Con una SharedLLC (set_llc) la fase de memoria consulta primero la LLC: un acierto dura
+ lo que tarde su banco y evita Memoria; los write-backs de líneas que la LLC tiene se
+ absorben en ella.
+ Un upgrade (INVALIDATE/BusUpgr) termina tras el snoop: solo invalida a los demás
+ compartidores, sin fases de memoria ni de datos. Si el solicitante perdió su copia
+ mientras esperaba el Bus, se convierte en un BusRdX; si la pierde durante el snoop del
+ upgrade, al terminarlo pasa a BusRdX y sigue con las fases de memoria y de datos.
+ Pueden estar en vuelo hasta max_outstanding transacciones. Una petición a una línea
+ que ya tiene una transacción en vuelo no se concede hasta que ésta termine: su PE
+ queda fuera del arbitraje (blocked_mask_) y así nunca hay dos dueños de la misma línea.
+ Los prefetches (BusRd con transaction.prefetch) van en colas propias de baja prioridad:
+ solo se conceden cuando ningún PE tiene una petición a demanda elegible. Un prefetch cuya
+ línea ya está en la caché o en vuelo se descarta al llegar su turno en vez de esperar,
+ y también se descarta si su cola está llena o si un miss a demanda ya pidió su línea.
+ Con max_outstanding 1 se descartan todos al emitirse: ocuparían la única ranura en
+ vuelo y solo demorarían los misses que llegan detrás.
+ Un BusRd a demanda que esperaba la línea de un prefetch propio se completa sin
+ transacción al llegar su turno.
+*/
 
 class BusInterconnect {
 public:
-    BusInterconnect(std::vector<CacheL1*>& caches, Memory* memory, bool debug);
-    ~BusInterconnect();
-
-    // Funcion que se ejecuta en el hilo del Bus
-    void run();
+    static constexpr int MAX_PES = 64;               // un bit por PE en pending_mask_
+    static constexpr size_t REQUEST_RING_CAPACITY = 64; // peticiones en vuelo por PE
+    static constexpr unsigned CONTROL_BYTES = 8;        // dirección + comando de cada petición
 
-    void stop();
+    // log recibe los mensajes de inicio y fin (cada simulación de un barrido usa el suyo)
+    BusInterconnect(std::vector<CacheL1*>& caches, Memory* memory, EventScheduler& scheduler,
+                    bool debug, BusTiming timing = BusTiming{}, std::ostream& log = std::cout);
+    ~BusInterconnect();
 
     // Interfaz para que una CacheL1 envie una peticion al Bus
     void add_request(const BusTransaction& transaction);
 
+    // Modelo de temporización de la Memoria (nullptr = latencia fija memory_access)
+    void set_dram(DramModel* dram) { dram_ = dram; }
+    // Caché compartida de último nivel (nullptr = sin LLC). La conecta también a las L1
+    // y le da la back-invalidation para el modo inclusivo.
+    void set_llc(SharedLLC* llc);
+
+    // Ciclo actual del reloj simulado
+    Cycle now() const { return scheduler_.now(); }
+
+    // Sin peticiones en cola ni transacciones en vuelo (punto seguro para un checkpoint)
+    bool idle() const {
+        return outstanding_ == 0 && !arbitration_scheduled_ && !address_bus_busy_ &&
+               pending_mask_.load() == 0 && prefetch_mask_.load() == 0;
+    }
+    // Último PE concedido por el Round-Robin (-1 = ninguno)
+    int arbitration_pointer() const { return last_granted_pe_; }
+    // Restauración de un checkpoint (con el Bus inactivo): fija el puntero del Round-Robin y
+    // reconstruye el filtro de snoop a partir de las líneas presentes en las cachés
+    void restore_arbitration(int last_granted_pe);
+
     // Funcion auxiliar para obtener el nombre del comando para prints
     std::string get_command_name(BusCommand cmd) const;
 
+    // Estadísticas de tiempo simulado
+    uint64_t get_transaction_count() const { return transactions_; }
+    Cycle get_busy_cycles() const { return busy_cycles_; }
+    Cycle get_wait_cycles() const { return wait_cycles_; }
+    uint64_t get_line_conflicts() const { return line_conflicts_; }
+    unsigned get_peak_outstanding() const { return peak_outstanding_; }
+    uint64_t get_snoops_performed() const { return snoops_performed_; }
+    uint64_t get_snoops_avoided() const { return snoops_avoided_; }
+    CoherenceProtocol get_protocol() const { return protocol_; }
+    uint64_t get_memory_reads() const { return memory_reads_; }
+    uint64_t get_memory_writebacks() const { return memory_writebacks_; }
+    uint64_t get_memory_reads_saved() const { return memory_reads_saved_; }
+    uint64_t get_memory_writebacks_saved() const { return memory_writebacks_saved_; }
+    uint64_t get_upgrades() const { return upgrades_; }
+    uint64_t get_upgrades_converted() const { return upgrades_converted_; }
+    uint64_t get_data_bytes() const { return data_bytes_; }
+    uint64_t get_control_bytes() const { return control_bytes_; }
+    uint64_t get_prefetches_granted() const { return prefetches_granted_; }
+    uint64_t get_prefetches_dropped() const { return prefetches_dropped_; }
+    uint64_t get_prefetches_cancelled() const { return prefetches_cancelled_; }
+    uint64_t get_reads_served_by_prefetch() const { return reads_served_by_prefetch_; }
+    Cycle get_address_bus_cycles() const { return address_bus_cycles_; }
+    Cycle get_data_bus_cycles() const { return data_bus_cycles_; }
+    // Espera en cola hasta la concesión y latencia total (cola a entrega) de las peticiones a demanda
+    const LatencyHistogram& get_arbitration_wait() const { return arbitration_wait_; }
+    const LatencyHistogram& get_transaction_latency() const { return transaction_latency_; }
+    // Transacciones completadas por ciclo simulado
+    double get_throughput() const;
+    void print_stats(std::ostream& out = std::cout) const;
+    // Contadores, ocupación de cada bus, tráfico en bytes e histogramas como "bus"
+    void export_metrics(MetricsRegistry& registry) const;
+
 private:
-    std::thread bus_thread_;
-    std::mutex arbit_mutex_;
     int last_granted_pe_ = -1;
-    std::atomic<bool> stop_flag_ = false;
+    int num_pes_ = 0; // una caché por PE
 
     // Variable para habilitar el modo de depuración
     bool debug_;
+    std::ostream* log_;
 
-    // Cola de peticiones del Bus
-    ConcurrentQueue<BusTransaction> request_queue_;
+    // Una cola SPSC por PE (productor: el PE/su caché, consumidor: el árbitro)
+    // y un bit "pendiente" por PE; el árbitro no recorre las colas.
+    using RequestRing = SpscRing<BusTransaction, REQUEST_RING_CAPACITY>;
+    std::vector<std::unique_ptr<RequestRing>> request_rings_;
+    std::atomic<uint64_t> pending_mask_{0};
+    std::vector<std::unique_ptr<RequestRing>> prefetch_rings_; // baja prioridad
+    std::atomic<uint64_t> prefetch_mask_{0};
 
     // Punteros a los otros modulos para invocar Snooping y accesos a Memoria
     std::vector<CacheL1*>& caches_;
     Memory* memory_;
 
-    std::atomic<bool> running_;
+    // Reloj global y latencias del Bus
+    EventScheduler& scheduler_;
+    BusTiming timing_;
+    unsigned line_bytes_;
+    CoherenceProtocol protocol_; // el de las cachés (todas usan el mismo)
+    DramModel* dram_ = nullptr;
+    SharedLLC* llc_ = nullptr;
+
+    // Transacción que ya pasó su snoop y espera (o usa) el bus de datos
+    struct InFlight {
+        bool active = false;
+        BusTransaction transaction{-1, BusCommand::NONE, 0};
+        uint64_t line = 0;          // address / line_bytes_
+        std::vector<uint8_t> data;  // bloque resuelto en el snoop
+        MESI_State fill_state = MESI_State::EXCLUSIVE; // estado con que la recibe el solicitante
+        enum class MemoryOp { NONE, READ, WRITEBACK } memory_op = MemoryOp::NONE; // fase de memoria
+        Cycle llc_latency = 0;      // búsqueda en la LLC antes de la fase de memoria
+        uint64_t waiters = 0;       // PEs bloqueados esperando esta línea
+    };
+    std::vector<InFlight> in_flight_; // max_outstanding ranuras
+    unsigned outstanding_ = 0;
+    uint64_t blocked_mask_ = 0;       // PEs cuya petición en cabeza choca con una línea en vuelo
+    bool arbitration_scheduled_ = false;
+    bool address_bus_busy_ = false;   // fase de petición+snoop en curso
+    Cycle data_bus_free_at_ = 0;
+    std::vector<uint8_t> snoop_block_; // bloque suministrado por una caché durante el snooping
+    SnoopFilter snoop_filter_;         // solo se consulta con timing_.snoop_filter
+    uint64_t all_pes_mask_ = 0;
+
+    uint64_t transactions_ = 0;
+    Cycle busy_cycles_ = 0;  // ciclos con al menos una transacción en vuelo
+    Cycle busy_since_ = 0;
+    Cycle wait_cycles_ = 0;  // suma de ciclos que las peticiones esperaron en cola
+    uint64_t line_conflicts_ = 0;  // concesiones diferidas por una transacción a la misma línea
+    unsigned peak_outstanding_ = 0;
+    uint64_t snoops_performed_ = 0; // llamadas snoop_bus_rd/rdx a cachés
+    uint64_t snoops_avoided_ = 0;   // cachés que el filtro excluyó de la difusión
+    uint64_t memory_reads_ = 0;      // bloques leídos de Memoria por transacciones
+    uint64_t memory_writebacks_ = 0; // write-backs por snoop a una línea sucia
+    uint64_t memory_reads_saved_ = 0;      // bloques limpios entregados caché a caché (MESIF)
+    uint64_t memory_writebacks_saved_ = 0; // bloques sucios entregados sin write-back (MOESI)
+    uint64_t upgrades_ = 0;           // BusUpgr completados sin transferencia de datos
+    uint64_t upgrades_converted_ = 0; // BusUpgr que llegaron sin la copia local y pasaron a BusRdX
+    uint64_t data_bytes_ = 0;    // bloques en el bus de datos (entregas y write-backs)
+    uint64_t control_bytes_ = 0; // paquetes de dirección/comando
+    uint64_t prefetches_granted_ = 0;
+    uint64_t prefetches_dropped_ = 0; // cola llena, o línea ya presente o en vuelo
+    uint64_t prefetches_cancelled_ = 0; // su línea ya la pidió un miss a demanda
+    uint64_t reads_served_by_prefetch_ = 0; // BusRd que al ser concedidos ya tenían la línea
+    Cycle address_bus_cycles_ = 0; // arbitraje + petición/snoop de cada concesión
+    Cycle data_bus_cycles_ = 0;    // transferencias de bloques
+    LatencyHistogram arbitration_wait_;
+    LatencyHistogram transaction_latency_;
 
-    // Logica de Arbitraje y Proceso MESI
+    // Logica de Arbitraje y Proceso MESI (eventos agendados en el scheduler)
+    void try_schedule_arbitration();
     void arbitrate_and_process();
-    void process_transaction(BusTransaction& transaction);
+    BusTransaction pop_request(int pe);
+    BusTransaction pop_prefetch(int pe);
+    static BusTransaction pop_from(RequestRing& ring, std::atomic<uint64_t>& mask, int pe);
+    void drop_prefetch(const BusTransaction& transaction);
+    // Primer PE con bit en 'pending' a partir de last_granted+1 (rotación + ctz, O(1))
+    static int next_requester(uint64_t pending, int last_granted);
+    InFlight* find_in_flight(uint64_t line);
+    // Fase de datos a partir del ciclo en que el bloque está listo
+    void start_data_phase(size_t slot, Cycle ready);
+    // Fase de memoria en la DRAM dentro de 'delay' ciclos; al terminar, la de datos
+    void start_dram_phase(size_t slot, Cycle delay);
+    void finish_transaction(size_t slot);
+    // Fases de petición y snoop; retorna los ciclos hasta tener el bloque (snoop + memoria)
+    Cycle process_transaction(InFlight& slot);
+    // BusUpgr: invalida a los demás compartidores; retorna los ciclos del snoop
+    Cycle process_upgrade(InFlight& slot);
+    // Lee el bloque de la LLC o de Memoria y cuenta el acceso; retorna los ciclos sin snoop
+    Cycle read_from_below(InFlight& slot);
 
 };
 
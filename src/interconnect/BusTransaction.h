@@ -1,6 +1,7 @@
 #ifndef BUS_TRANSACTION_H
 #define BUS_TRANSACTION_H
 
+#include <functional>
 #include "BusEnums.h"
 
 struct BusTransaction {
@@ -12,10 +13,18 @@ struct BusTransaction {
     bool hit_modified;
     bool data_from_memory;
 
+    uint64_t issue_cycle; // ciclo en que la petición entró a la cola del Bus
+    bool prefetch;        // BusRd del prefetcher: baja prioridad y sin on_complete
+
+    // Se invoca cuando el bloque ya fue entregado a la caché solicitante
+    // (permite al solicitante completar su acceso y reanudar su PE)
+    std::function<void()> on_complete;
+
     // Constructor
     BusTransaction(int id, BusCommand cmd, uint64_t addr) 
         : pe_id(id), command(cmd), address(addr),
-          hit_shared(false), hit_modified(false), data_from_memory(false) {}
+          hit_shared(false), hit_modified(false), data_from_memory(false),
+          issue_cycle(0), prefetch(false) {}
 };
 
 #endif // BUS_TRANSACTION_H
@@ -0,0 +1,38 @@
+#ifndef SNOOP_FILTER_H
+#define SNOOP_FILTER_H
+
+#include <cstdint>
+#include <unordered_map>
+
+/*
+ Filtro de snoop del Bus: un vector de compartidores (un bit por PE) por línea.
+ Es conservador: un bit encendido significa que la caché *puede* tener la línea.
+ - El Bus agrega al solicitante cuando le entrega el bloque (única vía de llenado
+   de una caché conectada al Bus).
+ - Los desalojos silenciosos dejan bits obsoletos; se limpian cuando un snoop a
+   esa caché no encuentra la línea, o cuando un BusRdX la invalida.
+ Las líneas sin compartidores se eliminan, así el mapa solo guarda líneas en caché.
+*/
+class SnoopFilter {
+public:
+    uint64_t sharers(uint64_t line) const {
+        auto it = sharers_.find(line);
+        return it == sharers_.end() ? 0 : it->second;
+    }
+
+    void add(uint64_t line, int pe) { sharers_[line] |= 1ULL << pe; }
+
+    void remove(uint64_t line, int pe) {
+        auto it = sharers_.find(line);
+        if (it == sharers_.end()) return;
+        it->second &= ~(1ULL << pe);
+        if (it->second == 0) sharers_.erase(it);
+    }
+
+    size_t tracked_lines() const { return sharers_.size(); }
+
+private:
+    std::unordered_map<uint64_t, uint64_t> sharers_; // línea -> máscara de PEs
+};
+
+#endif // SNOOP_FILTER_H
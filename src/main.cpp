@@ -1,8 +1,14 @@
 #include <iostream>
 #include <vector>
-#include <thread>
+#include <cctype>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
 // Incluye archivos de Interconnect
 #include "interconnect/BusEnums.h"
@@ -11,12 +17,22 @@
 
 #include "components/memory.h"
 #include "components/cacheL1.h"
+#include "components/dram.h"
+#include "components/llc.h"
 
 #include "PE/ProcessorSystem.hpp"
 #include "PE/Instruction.hpp"
 #include "PE/ProgramLoader.hpp"
 #include "PE/MemoryFacade.hpp"
 #include "PE/SharedMemoryInstance.hpp"
+#include "PE/CaptureMemory.hpp"
+#include "PE/ProgramImage.hpp"
+
+#include "sim/EventScheduler.h"
+#include "sim/TraceReplay.h"
+#include "sim/Checkpoint.h"
+#include "sim/SweepRunner.h"
+#include "utils/trace.h"
 
 
 std::string get_mesi_state_name(MESI_State state) {
@@ -25,35 +41,37 @@ std::string get_mesi_state_name(MESI_State state) {
         case MESI_State::EXCLUSIVE: return "EXCLUSIVE (E)";
         case MESI_State::SHARED: return "SHARED (S)";
         case MESI_State::INVALID: return "INVALID (I)";
+        case MESI_State::OWNED: return "OWNED (O)";
+        case MESI_State::FORWARD: return "FORWARD (F)";
         default: return "UNKNOWN";
     }
 }
 
-// Funcion de prueba del comportamiento de un PE/Cache
-void pe_activity(int pe_id, BusInterconnect& bus, uint64_t address_base, int num_reads, int num_writes) {
+// Funcion de prueba del comportamiento de un PE/Cache: agenda sus peticiones en el reloj simulado
+void pe_activity(int pe_id, BusInterconnect& bus, EventScheduler& scheduler, uint64_t address_base, int num_reads, int num_writes) {
     std::cout << "--> [PE " << pe_id << "] Iniciando actividad: " << num_reads << " lecturas, " << num_writes << " escrituras.\n";
     
+    Cycle when = scheduler.now();
+
     // 1. Lecturas (BusRd)
     for (int i = 0; i < num_reads; ++i) {
         uint64_t address = address_base + (i * 8); 
-        BusTransaction transaction(pe_id, BusCommand::BUS_READ, address);
-        
-        std::cout << "[PE " << pe_id << "] REQ: BusRd @ 0x" << std::hex << address << std::dec << "\n";
-        bus.add_request(transaction);
-        std::this_thread::sleep_for(std::chrono::milliseconds(50 + (pe_id * 5))); // Pausa para simular latencia
+        scheduler.schedule_at(when, [pe_id, address, &bus]() {
+            std::cout << "[PE " << pe_id << "] REQ: BusRd @ 0x" << std::hex << address << std::dec << "\n";
+            bus.add_request(BusTransaction(pe_id, BusCommand::BUS_READ, address));
+        });
+        when += 50 + (pe_id * 5); // Pausa para simular latencia
     }
 
     // 2. Escrituras (BusRdX)
     for (int i = 0; i < num_writes; ++i) {
         uint64_t address = address_base + 0x400 + (i * 8); // Offset para direcciones diferentes
-        BusTransaction transaction(pe_id, BusCommand::BUS_READ_X, address);
-        
-        std::cout << "[PE " << pe_id << "] REQ: BusRdX @ 0x" << std::hex << address << std::dec << "\n";
-        bus.add_request(transaction);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (pe_id * 10))); // Pausa para simular latencia
+        scheduler.schedule_at(when, [pe_id, address, &bus]() {
+            std::cout << "[PE " << pe_id << "] REQ: BusRdX @ 0x" << std::hex << address << std::dec << "\n";
+            bus.add_request(BusTransaction(pe_id, BusCommand::BUS_READ_X, address));
+        });
+        when += 100 + (pe_id * 10); // Pausa para simular latencia
     }
-    
-    std::cout << "<-- [PE " << pe_id << "] Actividad finalizada.\n";
 }
 
 void test_interconnect_full_mesi() {
@@ -66,37 +84,32 @@ void test_interconnect_full_mesi() {
     std::vector<CacheL1*> caches;
     for (int i = 0; i < 4; ++i) {
         // Inicializar cada Cache L1 con su ID y puntero a la Memoria
-        caches.push_back(new CacheL1(i, &memory));
+        caches.push_back(make_cache_l1(i, &memory).release());
     }
 
-    // 2. Inicializar el Bus Interconnect
-    BusInterconnect bus(caches, &memory, false);
+    // 2. Inicializar el reloj simulado y el Bus Interconnect
+    EventScheduler scheduler;
+    BusInterconnect bus(caches, &memory, scheduler, false);
     
-    // 3. Crear hilos de PEs y asignar cargas
-    std::vector<std::thread> pe_threads;
+    // 3. Agendar la actividad de cada PE
 
     // SCENARIO 1: Lecturas Compartidas y Round-Robin
     // PE 0 y PE 2 piden el mismo bloque (0x1000) -> Ambos deben terminar en estado S.
     // PE 1 y PE 3 piden bloques distintos.
-    pe_threads.emplace_back(pe_activity, 0, std::ref(bus), 0x100, 2, 0); 
-    pe_threads.emplace_back(pe_activity, 1, std::ref(bus), 0x200, 1, 0); 
-    pe_threads.emplace_back(pe_activity, 2, std::ref(bus), 0x100, 1, 0); 
-    pe_threads.emplace_back(pe_activity, 3, std::ref(bus), 0x300, 1, 0); 
+    pe_activity(0, bus, scheduler, 0x100, 2, 0); 
+    pe_activity(1, bus, scheduler, 0x200, 1, 0); 
+    pe_activity(2, bus, scheduler, 0x100, 1, 0); 
+    pe_activity(3, bus, scheduler, 0x300, 1, 0); 
     
     // SCENARIO 2: Conflicto de Escritura (Write-Miss)
     // Todos los PEs piden exclusividad sobre direcciones cercanas
-    pe_threads.emplace_back(pe_activity, 0, std::ref(bus), 0x400, 0, 1);
-    pe_threads.emplace_back(pe_activity, 1, std::ref(bus), 0x400, 0, 1);
+    pe_activity(0, bus, scheduler, 0x400, 0, 1);
+    pe_activity(1, bus, scheduler, 0x400, 0, 1);
     
-    // 4. Esperar a que los PEs terminen de generar peticiones
-    for (auto& t : pe_threads) {
-        t.join();
-    }
-    
-    std::cout << "\n[MAIN] Todos los PEs han terminado de generar peticiones. Esperando Arbitraje final...\n";
-    
-    // 5. Dejar que el Bus procese las peticiones restantes (da tiempo para que el Bus vacíe la cola)
-    std::this_thread::sleep_for(std::chrono::seconds(3)); 
+    // 4. Simular hasta que el Bus vacíe la cola
+    Cycle cycles = scheduler.run();
+    std::cout << "\n[MAIN] Simulacion terminada en " << cycles << " ciclos.\n";
+    bus.print_stats();
     
     // 6. Verificación Final de Estados MESI (Debug)
     std::cout << "\n======================================================\n";
@@ -145,10 +158,356 @@ void test_interconnect_full_mesi() {
     // correctamente en el código final para evitar bloqueos.
 }
 
+// ---------------- test_mode (make test): escenarios de coherencia verificados ----------------
+
+// Cuenta los chequeos fallidos; cada uno se imprime con OK/FALLÓ como en la prueba MESI completa
+struct TestReport {
+    int checks = 0;
+    int failures = 0;
+    void expect(bool ok, const std::string& what) {
+        ++checks;
+        if (!ok) ++failures;
+        std::cout << " - " << what << ": " << (ok ? "OK" : "FALLÓ") << "\n";
+    }
+};
+
+// Sistema mínimo para emitir transacciones a mano: Memoria, N cachés y el Bus (su log se descarta)
+struct BusFixture {
+    Memory memory;
+    std::vector<CacheL1*> caches;
+    EventScheduler scheduler;
+    std::ostringstream bus_log;
+    std::unique_ptr<BusInterconnect> bus;
+    std::unique_ptr<SharedLLC> llc;
+
+    BusFixture(int cache_count, const CacheConfig& config, const BusTiming& timing = BusTiming{}) {
+        for (int i = 0; i < cache_count; ++i) caches.push_back(make_cache_l1(i, &memory, config).release());
+        bus = std::make_unique<BusInterconnect>(caches, &memory, scheduler, false, timing, bus_log);
+    }
+    ~BusFixture() {
+        bus.reset();
+        for (auto* c : caches) delete c;
+    }
+
+    // Agrega una SharedLLC entre el Bus y Memoria
+    void attach_llc(const LLCConfig& config) {
+        llc = std::make_unique<SharedLLC>(&memory, scheduler, caches[0]->line_bytes(), config);
+        bus->set_llc(llc.get());
+    }
+
+    // Encola la transacción; si write, al entregarse el bloque el PE escribe 'value' en 'address'
+    void request(int pe, BusCommand command, uint64_t address, bool write = false, uint64_t value = 0) {
+        BusTransaction transaction(pe, command, address);
+        if (write) transaction.on_complete = [this, pe, address, value] { caches[pe]->write_filled(address, value); };
+        bus->add_request(transaction);
+    }
+    MESI_State state(int pe, uint64_t address) const { return caches[pe]->get_line_state(address); }
+    uint64_t memory_word(uint64_t address) {
+        uint64_t value = 0;
+        memory.read_word(address, &value);
+        return value;
+    }
+    double bus_counter(const std::string& name) const {
+        MetricsRegistry registry;
+        bus->export_metrics(registry);
+        return registry.value("bus", name);
+    }
+};
+
+// Transferencias entre cachés de cada protocolo sobre una línea compartida
+void test_protocol_transfers(TestReport& report) {
+    const uint64_t line = 0x100;
+    const uint64_t value = 0x1111;
+    CacheConfig config;
+
+    std::cout << "\n[MESI] M -> S con write-back al leer otro PE\n";
+    {
+        config.protocol = CoherenceProtocol::MESI;
+        BusFixture fx(3, config);
+        fx.request(0, BusCommand::BUS_READ_X, line, true, value);
+        fx.scheduler.run();
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::SHARED && fx.state(1, line) == MESI_State::SHARED,
+                      "PE0 y PE1 en S");
+        report.expect(fx.bus_counter("memory_writebacks") == 1 && fx.memory_word(line) == value,
+                      "el dato sucio se escribe en Memoria");
+    }
+
+    std::cout << "\n[MOESI] M -> O sin write-back; el dueño responde\n";
+    {
+        config.protocol = CoherenceProtocol::MOESI;
+        BusFixture fx(3, config);
+        fx.request(0, BusCommand::BUS_READ_X, line, true, value);
+        fx.scheduler.run();
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::OWNED && fx.state(1, line) == MESI_State::SHARED,
+                      "PE0 en O y PE1 en S");
+        report.expect(fx.bus_counter("memory_writebacks") == 0 && fx.bus_counter("memory_writebacks_saved") == 1 &&
+                      fx.memory_word(line) == 0, "sin write-back: la Memoria conserva el valor viejo");
+        fx.request(2, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::OWNED && fx.state(2, line) == MESI_State::SHARED &&
+                      fx.caches[2]->read_filled(line) == value, "PE2 recibe el dato del dueño (O)");
+        report.expect(fx.bus_counter("memory_reads") == 1, "una sola lectura a Memoria (el primer BusRdX)");
+        fx.caches[0]->flush();
+        report.expect(fx.memory_word(line) == value, "el flush del dueño escribe el dato en Memoria");
+    }
+
+    std::cout << "\n[MESIF] la copia F pasa al último lector\n";
+    {
+        config.protocol = CoherenceProtocol::MESIF;
+        BusFixture fx(3, config);
+        fx.request(0, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::SHARED && fx.state(1, line) == MESI_State::FORWARD,
+                      "PE0 (E) responde y queda en S; PE1 en F");
+        fx.request(2, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        report.expect(fx.state(1, line) == MESI_State::SHARED && fx.state(2, line) == MESI_State::FORWARD,
+                      "F pasa de PE1 a PE2");
+        report.expect(fx.bus_counter("memory_reads") == 1 && fx.bus_counter("memory_reads_saved") == 2,
+                      "los dos BusRd se sirven entre cachés");
+    }
+}
+
+// Falso compartimiento: 4 PEs incrementan cada uno su palabra de la misma línea (LOAD,
+// ADDI, STORE) con cada protocolo y varias configuraciones del Bus, LLC y prefetcher.
+// Ninguna escritura se pierde: al final cada palabra vale 'rounds'.
+void test_false_sharing(TestReport& report) {
+    const uint64_t base = 0x2000; // una línea de 32 B: una palabra por PE
+    const uint64_t rounds = 24;
+    const size_t pe_count = 4;
+    struct Variant {
+        const char* name;
+        unsigned outstanding;
+        bool snoop_filter;
+        bool llc;
+        InclusionPolicy inclusion;
+        PrefetchKind prefetch;
+    };
+    const Variant variants[] = {
+        {"bus atomico", 1, false, false, InclusionPolicy::INCLUSIVE, PrefetchKind::NONE},
+        {"4 en vuelo + filtro de snoop", 4, true, false, InclusionPolicy::INCLUSIVE, PrefetchKind::NONE},
+        {"4 en vuelo + LLC inclusiva chica + prefetch next", 4, false, true, InclusionPolicy::INCLUSIVE,
+         PrefetchKind::NEXT_LINE},
+        {"4 en vuelo + LLC exclusiva chica", 4, false, true, InclusionPolicy::EXCLUSIVE, PrefetchKind::NONE},
+        {"bus atomico + LLC no inclusiva chica", 1, false, true, InclusionPolicy::NON_INCLUSIVE,
+         PrefetchKind::NONE},
+    };
+    const CoherenceProtocol protocols[] = {CoherenceProtocol::MESI, CoherenceProtocol::MOESI,
+                                           CoherenceProtocol::MESIF};
+
+    std::cout << "\n[Falso compartimiento] " << pe_count << " PEs x " << rounds << " incrementos en una linea\n";
+    for (CoherenceProtocol protocol : protocols) {
+        for (const Variant& variant : variants) {
+            CacheConfig config;
+            config.protocol = protocol;
+            config.sets = 2;
+            config.ways = 1;
+            config.prefetch.kind = variant.prefetch;
+            BusTiming timing;
+            timing.max_outstanding = variant.outstanding;
+            timing.snoop_filter = variant.snoop_filter;
+
+            Memory memory;
+            std::vector<CacheL1*> caches;
+            for (size_t i = 0; i < pe_count; ++i) caches.push_back(make_cache_l1(static_cast<int>(i), &memory, config).release());
+            EventScheduler scheduler;
+            std::ostringstream bus_log;
+            BusInterconnect bus(caches, &memory, scheduler, false, timing, bus_log);
+            std::unique_ptr<SharedLLC> llc;
+            if (variant.llc) {
+                LLCConfig llc_config;
+                llc_config.sets = 2;
+                llc_config.ways = 1;
+                llc_config.inclusion = variant.inclusion;
+                llc = std::make_unique<SharedLLC>(&memory, scheduler, caches[0]->line_bytes(), llc_config);
+                bus.set_llc(llc.get());
+            }
+            ProcessorSystem system(false, pe_count);
+            std::vector<std::unique_ptr<MemoryFacade>> facades;
+            for (size_t i = 0; i < pe_count; ++i) {
+                facades.push_back(std::make_unique<MemoryFacade>(caches[i], &bus, static_cast<int>(i)));
+                system.getPE(i).attachMemory(facades.back().get());
+                const uint64_t word = base + i * sizeof(uint64_t);
+                std::vector<Instruction> program;
+                program.push_back({OpCode::MOVI, 7, -1, -1, rounds}); // JNZ prueba R7
+                const size_t loop = program.size();
+                program.push_back({OpCode::LOAD, 2, -1, -1, word});
+                program.push_back({OpCode::ADDI, 2, -1, -1, 1});
+                program.push_back({OpCode::STORE, 2, -1, -1, word});
+                // Otra línea del mismo set: fuerza desalojos y write-backs
+                program.push_back({OpCode::LOAD, 3, -1, -1, base + 0x40 + i * sizeof(uint64_t)});
+                program.push_back({OpCode::DEC, 7});
+                program.push_back({OpCode::JNZ, -1, -1, -1, 0, loop});
+                program.push_back({OpCode::HALT});
+                system.loadProgram(i, program);
+            }
+            system.startAll(scheduler);
+            scheduler.run();
+            for (auto* c : caches) c->flush();
+            if (llc) llc->flush();
+
+            bool ok = true;
+            for (size_t i = 0; i < pe_count; ++i) {
+                uint64_t value = 0;
+                memory.read_word(base + i * sizeof(uint64_t), &value);
+                ok = ok && value == rounds;
+            }
+            report.expect(ok, std::string(coherence_protocol_name(protocol)) + ", " + variant.name);
+            facades.clear();
+            for (auto* c : caches) delete c;
+        }
+    }
+}
+
+// Líneas sucias que salen de una LLC de una sola vía en cada modo de inclusión: el dato
+// llega a Memoria sin flush (back-invalidation, víctima sucia de la LLC) y el acierto
+// sucio de la LLC exclusiva escribe en Memoria y entrega la línea limpia
+void test_llc_evictions(TestReport& report) {
+    const uint64_t a = 0x100, b = 0x200, c = 0x300, d = 0x400, e = 0x500; // todas en el mismo set
+    const uint64_t value_a = 0xA1, value_d = 0xD4;
+    CacheConfig config;
+    config.sets = 1;
+    config.ways = 1;
+
+    for (InclusionPolicy inclusion :
+         {InclusionPolicy::INCLUSIVE, InclusionPolicy::EXCLUSIVE, InclusionPolicy::NON_INCLUSIVE}) {
+        std::cout << "\n[LLC " << inclusion_policy_name(inclusion) << "] desalojos de lineas sucias\n";
+        BusFixture fx(2, config);
+        LLCConfig llc_config;
+        llc_config.banks = 1;
+        llc_config.sets = 1;
+        llc_config.ways = 1;
+        llc_config.inclusion = inclusion;
+        fx.attach_llc(llc_config);
+        auto step = [&fx](int pe, BusCommand command, uint64_t address, bool write = false, uint64_t value = 0) {
+            fx.request(pe, command, address, write, value);
+            fx.scheduler.run();
+        };
+
+        // A sale sucia de la L1 de PE0
+        step(0, BusCommand::BUS_READ_X, a, true, value_a);
+        step(0, BusCommand::BUS_READ, b);
+        if (inclusion == InclusionPolicy::INCLUSIVE) {
+            report.expect(fx.memory_word(a) == value_a, "la back-invalidation escribe A en Memoria");
+        } else {
+            report.expect(fx.memory_word(a) == 0, "A sucia queda en la LLC");
+        }
+        // C desaloja de la LLC lo que quede de A
+        step(0, BusCommand::BUS_READ, c);
+        report.expect(fx.memory_word(a) == value_a, "A llega a Memoria al salir de la LLC");
+
+        // D sale sucia de la L1 de PE0 y PE1 la lee de donde quede
+        step(0, BusCommand::BUS_READ_X, d, true, value_d);
+        step(0, BusCommand::BUS_READ, e);
+        step(1, BusCommand::BUS_READ, d);
+        report.expect(fx.caches[1]->read_filled(d) == value_d, "PE1 lee el valor escrito de D");
+        if (inclusion == InclusionPolicy::EXCLUSIVE) {
+            report.expect(fx.memory_word(d) == value_d && fx.state(1, d) == MESI_State::EXCLUSIVE,
+                          "el acierto sucio escribe D en Memoria y PE1 la recibe limpia (E)");
+        }
+        for (auto* cache : fx.caches) cache->flush();
+        fx.llc->flush();
+        report.expect(fx.memory_word(a) == value_a && fx.memory_word(d) == value_d,
+                      "tras el flush Memoria tiene A y D");
+    }
+}
+
+// BusUpgr (INVALIDATE): upgrade S -> M, upgrade cuyo solicitante fue invalidado antes de
+// su turno y upgrade que pierde la copia durante el snoop
+void test_upgrades(TestReport& report) {
+    const uint64_t line = 0x100;
+    CacheConfig config;
+
+    std::cout << "\n[BusUpgr] S -> M sin leer el bloque\n";
+    {
+        BusFixture fx(2, config);
+        fx.request(0, BusCommand::BUS_READ, line);
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        const double reads = fx.bus_counter("memory_reads");
+        fx.request(0, BusCommand::INVALIDATE, line, true, 0x2222);
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::MODIFIED && fx.state(1, line) == MESI_State::INVALID,
+                      "PE0 en M y PE1 invalidado");
+        report.expect(fx.bus_counter("upgrades") == 1 && fx.bus_counter("upgrades_converted") == 0 &&
+                      fx.bus_counter("memory_reads") == reads, "un upgrade sin lectura a Memoria");
+    }
+
+    std::cout << "\n[BusUpgr] dos upgrades a la vez: el segundo ya fue invalidado al llegar su turno\n";
+    {
+        BusFixture fx(2, config);
+        fx.request(0, BusCommand::BUS_READ, line);
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        // Cada PE escribe su propia palabra de la línea al completar su acceso
+        fx.request(0, BusCommand::INVALIDATE, line, true, 0xA);
+        fx.request(1, BusCommand::INVALIDATE, line + 8, true, 0xB);
+        fx.scheduler.run();
+        const bool one_owner = (fx.state(0, line) == MESI_State::MODIFIED) != (fx.state(1, line) == MESI_State::MODIFIED);
+        report.expect(one_owner, "un solo dueño en M");
+        report.expect(fx.bus_counter("upgrades") == 1 && fx.bus_counter("upgrades_converted") == 1,
+                      "el segundo se convierte en BusRdX");
+        for (auto* c : fx.caches) c->flush();
+        report.expect(fx.memory_word(line) == 0xA && fx.memory_word(line + 8) == 0xB,
+                      "las dos escrituras llegan a Memoria");
+    }
+
+    std::cout << "\n[BusUpgr] el solicitante pierde su copia durante el snoop\n";
+    {
+        // 1 set x 1 vía: el prefetch propio que termina durante el snoop desaloja la línea
+        CacheConfig tiny;
+        tiny.sets = 1;
+        tiny.ways = 1;
+        BusTiming timing;
+        timing.snoop = 50;
+        timing.memory_access = 10;
+        timing.max_outstanding = 2;
+        BusFixture fx(2, tiny, timing);
+        fx.request(0, BusCommand::BUS_READ, line);
+        fx.request(1, BusCommand::BUS_READ, line);
+        fx.scheduler.run();
+        const uint64_t prefetched = line + 0x100;
+        fx.caches[0]->note_prefetch_issued(prefetched);
+        BusTransaction prefetch(0, BusCommand::BUS_READ, prefetched);
+        prefetch.prefetch = true;
+        fx.bus->add_request(prefetch);
+        fx.scheduler.schedule(timing.arbitration + 1, [&fx, line] {
+            fx.request(0, BusCommand::INVALIDATE, line, true, 0x3333);
+        });
+        const double reads = fx.bus_counter("memory_reads");
+        fx.scheduler.run();
+        report.expect(fx.state(0, line) == MESI_State::MODIFIED && fx.state(1, line) == MESI_State::INVALID,
+                      "PE0 vuelve a tener la línea, en M");
+        report.expect(fx.bus_counter("upgrades") == 1 && fx.bus_counter("upgrades_converted") == 1,
+                      "el upgrade se convierte en BusRdX");
+        report.expect(fx.bus_counter("memory_reads") == reads + 2, "el bloque se relee de Memoria (y el prefetch)");
+        fx.caches[0]->flush();
+        report.expect(fx.memory_word(line) == 0x3333, "la escritura llega a Memoria");
+    }
+}
+
+// make test: retorna 0 si todos los escenarios dan el resultado esperado
+int test_mode() {
+    std::cout << "==== Escenarios de coherencia ====\n";
+    TestReport report;
+    test_protocol_transfers(report);
+    test_false_sharing(report);
+    test_llc_evictions(report);
+    test_upgrades(report);
+    std::cout << "\n" << report.checks - report.failures << "/" << report.checks << " chequeos OK\n";
+    return report.failures == 0 ? 0 : 1;
+}
+
 void test_memory(){
     Memory mem;
-    CacheL1 cache0(0, &mem);
-    CacheL1 cache1(1, &mem);
+    BasicCacheL1<DefaultCacheGeometry> cache0(0, &mem);
+    BasicCacheL1<DefaultCacheGeometry> cache1(1, &mem);
 
     uint64_t addr = 0x00; // mismo bloque
 
@@ -161,20 +520,21 @@ void test_memory(){
 
     // 2) PE1 hace un Read -> Bus broadcast BusRd(addr)
     // Bus debe preguntar a todas las caches (incluye cache0)
-    auto r0 = cache0.snoop_bus_rd(addr); // debería indicar had_modified = true y pasar cache0->S
-    auto r1 = cache1.snoop_bus_rd(addr); // cache1 no la tiene
+    std::array<uint8_t,32> r0_data, r1_data;
+    auto r0 = cache0.snoop_bus_rd(addr, r0_data.data()); // debería indicar had_modified = true y pasar cache0->S
+    auto r1 = cache1.snoop_bus_rd(addr, r1_data.data()); // cache1 no la tiene
 
-    // Determinar fuente de datos: si r0.had_modified -> usar r0.data; else leer de memoria
+    // Determinar fuente de datos: si r0.had_modified -> usar r0_data; else leer de memoria
     std::array<uint8_t,32> block;
     if (r0.had_modified) {
-        block = r0.data;
+        block = r0_data;
         // (en una implementación completa, el bus sería responsable de escribir a memoria)
     } else {
-        mem.read_block(addr, reinterpret_cast<uint64_t *>(block.data()));
+        mem.read_block(addr, block.data(), block.size());
     }
 
-    // Ahora bus entrega el bloque a cache1 (others_have = true porque cache0 tenía la línea)
-    cache1.load_block_from_bus(addr, block.data(), /*others_have=*/true); // pasa a SHARED
+    // Ahora bus entrega el bloque a cache1 (SHARED porque cache0 tenía la línea)
+    cache1.load_block_from_bus(addr, block.data(), MESI_State::SHARED, false);
 
     std::cout << "States after BusRd -> cache0: " << static_cast<int>(cache0.get_line_state(addr))
               << " cache1: " << static_cast<int>(cache1.get_line_state(addr)) << "\n";
@@ -184,17 +544,18 @@ void test_memory(){
     std::cout << "cache1 read (64b): 0x" << std::hex << out64 << std::dec << "\n";
 
     // 3) Ahora PE1 quiere escribir -> BusRdX (invalida a otros)
-    auto s0 = cache0.snoop_bus_rdx(addr);
-    auto s1 = cache1.snoop_bus_rdx(addr); // cache1 will be invalidated by BusRdX as well
+    std::array<uint8_t,32> s0_data, s1_data;
+    auto s0 = cache0.snoop_bus_rdx(addr, s0_data.data());
+    auto s1 = cache1.snoop_bus_rdx(addr, s1_data.data()); // cache1 will be invalidated by BusRdX as well
 
     // si alguien devolvió had_modified==true, bus would writeback before granting
     std::array<uint8_t,32> block_for_requester;
-    if (s0.had_modified) block_for_requester = s0.data;
-    else if (s1.had_modified) block_for_requester = s1.data;
-    else mem.read_block(addr, reinterpret_cast<uint64_t *>(block_for_requester.data()));
+    if (s0.had_modified) block_for_requester = s0_data;
+    else if (s1.had_modified) block_for_requester = s1_data;
+    else mem.read_block(addr, block_for_requester.data(), block_for_requester.size());
 
-    // bus grants exclusive ownership to requester (cache1) -> load block from bus with others_have=false
-    cache1.load_block_from_bus(addr, block_for_requester.data(), /*others_have=*/false);
+    // bus grants exclusive ownership to requester (cache1) -> load block from bus in EXCLUSIVE
+    cache1.load_block_from_bus(addr, block_for_requester.data(), MESI_State::EXCLUSIVE, true);
 
     std::cout << "States after BusRdX -> cache0: " << static_cast<int>(cache0.get_line_state(addr))
               << " cache1: " << static_cast<int>(cache1.get_line_state(addr)) << "\n";
@@ -212,7 +573,7 @@ void test_memory(){
 
     // Finally check memory (if a writeback occurred earlier it would be reflected)
     uint64_t memblk_first8 = 0;
-    mem.read_block(addr, &memblk_first8);
+    mem.read_word(addr, &memblk_first8);
     std::cout << "Memory first 8 bytes (raw 64b): 0x" << std::hex << memblk_first8 << std::dec << "\n";
 }
 
@@ -225,10 +586,11 @@ void processor_system_with_memory_facade(){
     
     std::vector<CacheL1*> caches;
     for (int i = 0; i < 4; ++i) {
-        caches.push_back(new CacheL1(i, &memory));
+        caches.push_back(make_cache_l1(i, &memory).release());
     }
 
-    BusInterconnect bus(caches, &memory, false);
+    EventScheduler scheduler;
+    BusInterconnect bus(caches, &memory, scheduler, false);
 
     std::vector<MemoryFacade*> memory_facades;
     for (int i = 0; i < 4; ++i) {
@@ -236,15 +598,13 @@ void processor_system_with_memory_facade(){
     }
 
     // Inicializar memoria con valores base 10,20,30,40 en direcciones 0,32,64,96
-    memory.write_block(0, (new uint64_t[1]{10}));
-    memory.write_block(32, (new uint64_t[1]{20}));
-    memory.write_block(64, (new uint64_t[1]{30}));
-    memory.write_block(96, (new uint64_t[1]{40}));
+    const uint64_t initial[4] = {10, 20, 30, 40};
+    for (size_t j = 0; j < 4; ++j) memory.write_word(j * 32, &initial[j]);
 
     uint64_t data = 0;
     // std::cout << "Initial memory contents:\n";
     for (size_t j = 0; j < 4; ++j) {
-        memory.read_block(j * 32, &data);
+        memory.read_word(j * 32, &data);
         std::cout << "Mem[" << j * 32 << "] = " << static_cast<int>(data) << "\n";
     }
 
@@ -255,7 +615,7 @@ void processor_system_with_memory_facade(){
     std::vector<Instruction> p3 = loadProgramFile("pe3.pec");
 
     // // Adjuntar memoria y cargar programas
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) {
+    for (size_t i = 0; i < system.size(); ++i) {
         system.getPE(i).attachMemory(memory_facades[i]);
     }
     system.loadProgram(0, p0);
@@ -263,23 +623,21 @@ void processor_system_with_memory_facade(){
     system.loadProgram(2, p2);
     system.loadProgram(3, p3);
 
-    // Lanzar todos usando su programa (funcion nula)
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) {
-        system.getPE(i).start(nullptr);
-    }
-
-    system.joinAll();
+    // Lanzar todos usando su programa sobre el reloj simulado
+    system.startAll(scheduler);
+    scheduler.run();
 
     std::cout << "Final memory contents:\n";
     for (size_t j = 0; j < 4; ++j) {
-        memory.read_block(j * 32, &data);
+        memory.read_word(j * 32, &data);
         std::cout << "Mem[" << j * 32 << "] = " << static_cast<int>(data) << "\n";
     }
 }
 
 
 void processor_system(){
-        ProcessorSystem system;
+    ProcessorSystem system;
+    EventScheduler scheduler;
     SharedMemoryInstance mem(256); // suficiente para nuestras posiciones
 
     // Inicializar memoria con valores base 10,20,30,40 en direcciones 0,8,16,24
@@ -295,7 +653,7 @@ void processor_system(){
     std::vector<Instruction> p3 = loadProgramFile("pe3.pec");
 
     // Adjuntar memoria y cargar programas
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) {
+    for (size_t i = 0; i < system.size(); ++i) {
         system.getPE(i).attachMemory(&mem);
     }
     system.loadProgram(0, p0);
@@ -303,12 +661,9 @@ void processor_system(){
     system.loadProgram(2, p2);
     system.loadProgram(3, p3);
 
-    // Lanzar todos usando su programa (funcion nula)
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) {
-        system.getPE(i).start(nullptr);
-    }
-
-    system.joinAll();
+    // Lanzar todos usando su programa sobre el reloj simulado
+    system.startAll(scheduler);
+    scheduler.run();
 
     std::cout << "Mem[0]  = " << mem.load(0) << " (esperado 10)\n";
     std::cout << "Mem[8]  = " << mem.load(8) << " (esperado 21)\n";
@@ -316,90 +671,426 @@ void processor_system(){
     std::cout << "Mem[24] = " << mem.load(24) << " (esperado 43)\n";
 }
 
-// Nueva función: prueba de producto punto distribuido en 4 PEs
-void processor_system_dot_product(bool debug = false) {
-    std::cout << "==== Dot Product distribuido ====" << std::endl;
-    std::cout << "Inicializando sistema con Memoria, Cachés y Bus..." << std::endl;
-    ProcessorSystem system(debug);
+// Kernel de pe0.pec..pe3.pec generalizado a 'pe_count' PEs (mismo layout: A en 0,
+// B en 128*N y parciales en 256*N; ELEMS_PER_PE elementos separados 32 bytes por PE)
+static constexpr uint64_t DOT_ELEMS_PER_PE = 4;
+static constexpr uint64_t DOT_STRIDE = 32;
+
+// Variante del producto punto (--kernel):
+//  strided: la original, un elemento por línea de 32 B (usa 8 de cada 32 bytes que trae)
+//  packed:  A y B contiguos, recorridos con LOADR de a un elemento
+//  vector:  el layout de packed con VLOAD/VFMA de a una línea y VREDUCE al final
+enum class DotKernel { STRIDED, PACKED, VECTOR };
+
+DotKernel parse_dot_kernel(const std::string& name) {
+    if (name == "strided") return DotKernel::STRIDED;
+    if (name == "packed") return DotKernel::PACKED;
+    if (name == "vector") return DotKernel::VECTOR;
+    throw std::invalid_argument("Kernel desconocido: " + name + " (strided, packed, vector)");
+}
+
+const char* dot_kernel_name(DotKernel kernel) {
+    switch (kernel) {
+        case DotKernel::STRIDED: return "strided";
+        case DotKernel::PACKED: return "packed";
+        case DotKernel::VECTOR: return "vector";
+    }
+    return "?";
+}
+
+struct DotWorkload {
+    DotKernel kernel = DotKernel::STRIDED;
+    uint64_t elems_per_pe = DOT_ELEMS_PER_PE; // --elems; múltiplo de VECTOR_LANES con vector
+
+    uint64_t stride() const { return kernel == DotKernel::STRIDED ? DOT_STRIDE : sizeof(uint64_t); }
+    bool is_default() const { return kernel == DotKernel::STRIDED && elems_per_pe == DOT_ELEMS_PER_PE; }
+};
+
+// Bases de B y de los parciales (uno por PE, en líneas distintas)
+struct DotLayout {
+    uint64_t base_b;
+    uint64_t base_partials;
+};
+
+DotLayout dot_layout(size_t pe_count, const DotWorkload& workload) {
+    const uint64_t bytes = pe_count * workload.elems_per_pe * workload.stride();
+    const uint64_t aligned = (bytes + DOT_STRIDE - 1) / DOT_STRIDE * DOT_STRIDE;
+    return {aligned, 2 * aligned};
+}
+
+std::vector<Instruction> make_dot_product_program(size_t pe, size_t pe_count, const DotWorkload& workload = DotWorkload{}) {
+    const DotLayout layout = dot_layout(pe_count, workload);
+    const uint64_t chunk = workload.elems_per_pe * workload.stride();
+    const uint64_t base_a = pe * chunk;
+    const uint64_t base_b = layout.base_b + pe * chunk;
+    const uint64_t partial = layout.base_partials + pe * DOT_STRIDE;
+
+    std::vector<Instruction> prog;
+    if (workload.kernel == DotKernel::VECTOR) {
+        prog.push_back({OpCode::MOVI, 4, -1, -1, base_a});
+        prog.push_back({OpCode::MOVI, 5, -1, -1, base_b});
+        prog.push_back({OpCode::MOVI, 7, -1, -1, workload.elems_per_pe / VECTOR_LANES});
+        prog.push_back({OpCode::MOVI, 0, -1, -1, 0});
+        prog.push_back({OpCode::VBCAST, 0, 0}); // V0 = 0.0
+        const size_t loop = prog.size();
+        prog.push_back({OpCode::VLOAD, 1, 4});
+        prog.push_back({OpCode::VLOAD, 2, 5});
+        prog.push_back({OpCode::VFMA, 0, 1, 2});
+        prog.push_back({OpCode::ADDI, 4, -1, -1, VECTOR_BYTES});
+        prog.push_back({OpCode::ADDI, 5, -1, -1, VECTOR_BYTES});
+        prog.push_back({OpCode::DEC, 7});
+        prog.push_back({OpCode::JNZ, -1, -1, -1, 0, loop});
+        prog.push_back({OpCode::VREDUCE, 0, 0});
+        prog.push_back({OpCode::MOVI, 1, -1, -1, partial});
+        prog.push_back({OpCode::STORER, 0, 1});
+        prog.push_back({OpCode::HALT});
+        return prog;
+    }
+    prog.push_back({OpCode::MOVI, 4, -1, -1, base_a});
+    prog.push_back({OpCode::MOVI, 5, -1, -1, base_b});
+    prog.push_back({OpCode::MOVI, 6, -1, -1, workload.stride()});
+    prog.push_back({OpCode::MOVI, 7, -1, -1, workload.elems_per_pe});
+    prog.push_back({OpCode::MOVI, 0, -1, -1, 0});
+    const size_t loop = prog.size();
+    prog.push_back({OpCode::LOADR, 1, 4});
+    prog.push_back({OpCode::LOADR, 2, 5});
+    prog.push_back({OpCode::FMUL, 3, 1, 2});
+    prog.push_back({OpCode::FADD, 0, 0, 3});
+    prog.push_back({OpCode::ADDI, 4, -1, -1, workload.stride()});
+    prog.push_back({OpCode::ADDI, 5, -1, -1, workload.stride()});
+    prog.push_back({OpCode::DEC, 7});
+    prog.push_back({OpCode::JNZ, -1, -1, -1, 0, loop});
+    prog.push_back({OpCode::MOVI, 1, -1, -1, partial});
+    prog.push_back({OpCode::STORER, 0, 1});
+    prog.push_back({OpCode::HALT});
+    return prog;
+}
+
+// Carga 'path' (.pec) en el PE; si junto a él hay una imagen ensamblada (path + "b", ver
+// ./pec_asm) no más vieja que el fuente, ejecuta sobre ella sin parsear
+void load_pe_program(ProcessorSystem& system, size_t pe, const std::string& path) {
+    namespace fs = std::filesystem;
+    const std::string image_path = path + "b";
+    std::error_code ec;
+    const auto source_time = fs::last_write_time(path, ec);
+    const bool source_ok = !ec;
+    const auto image_time = fs::last_write_time(image_path, ec);
+    if (!ec && (!source_ok || image_time >= source_time)) {
+        try {
+            system.loadProgram(pe, std::make_shared<const ProgramImage>(image_path, ProcessingElement::REG_COUNT));
+            return;
+        } catch (const std::runtime_error& e) {
+            // Imagen corrupta, truncada o de otra versión: sin fuente no hay alternativa
+            if (!source_ok) throw;
+            std::cerr << "Aviso: " << e.what() << "; se usa " << path << "\n";
+        }
+    }
+    system.loadProgram(pe, loadProgramFile(path));
+}
+
+// --checkpoint/--checkpoint-at y --restore (ver sim/Checkpoint.h)
+struct CheckpointOptions {
+    std::string save_path;    // guardar al pausar los PEs en el ciclo save_at
+    Cycle save_at = 0;
+    std::string restore_path; // arrancar desde un checkpoint en vez de inicializar la Memoria
+};
+
+// Nueva función: prueba de producto punto distribuido en N PEs (4 por defecto, hasta 64)
+// Retorna los contadores de todas las cachés sumados. dram_config != nullptr agrega un DramModel
+// y llc_config != nullptr una SharedLLC entre el Bus y Memoria. Con registry != nullptr cada
+// componente copia allí sus métricas al terminar (para --metrics-json/--metrics-csv).
+// capture != nullptr registra los accesos de los PEs; checkpoint guarda o restaura el estado.
+// workload elige el kernel y la cantidad de elementos por PE.
+Metrics processor_system_dot_product(bool debug = false, const CacheConfig& cache_config = CacheConfig{},
+                                     size_t pe_count = ProcessorSystem::DEFAULT_PE_COUNT,
+                                     const BusTiming& bus_timing = BusTiming{},
+                                     const DramConfig* dram_config = nullptr,
+                                     const LLCConfig* llc_config = nullptr,
+                                     MetricsRegistry* registry = nullptr,
+                                     ExecTraceWriter* capture = nullptr,
+                                     const CheckpointOptions* checkpoint = nullptr,
+                                     const DotWorkload& workload = DotWorkload{},
+                                     std::ostream& out = std::cout) {
+    out << "==== Dot Product distribuido ====" << std::endl;
+    out << "Inicializando sistema con Memoria, Cachés y Bus..." << std::endl;
+    ProcessorSystem system(debug, pe_count);
+    EventScheduler scheduler; // reloj global de la simulación
+    const auto restore_start = std::chrono::steady_clock::now();
+    // Las páginas del checkpoint pasan a ser la Memoria: debe vivir más que ella
+    std::unique_ptr<Checkpoint> restore_from;
+    if (checkpoint && !checkpoint->restore_path.empty()) {
+        restore_from = std::make_unique<Checkpoint>(checkpoint->restore_path);
+    }
     Memory memory; // memoria compartida detrás de cachés
 
     std::vector<CacheL1*> caches;
-    for (int i = 0; i < 4; ++i) caches.push_back(new CacheL1(i, &memory));
-    BusInterconnect bus(caches, &memory, debug);
+    for (size_t i = 0; i < pe_count; ++i) {
+        caches.push_back(make_cache_l1(static_cast<int>(i), &memory, cache_config).release());
+    }
+    out << "PEs: " << pe_count << "\n";
+    out << "Kernel: " << dot_kernel_name(workload.kernel) << " (" << workload.elems_per_pe
+              << " elementos por PE)\n";
+    out << "Geometria de cache: " << caches[0]->sets() << " sets x " << caches[0]->ways()
+              << " vias x " << caches[0]->line_bytes() << " B ("
+              << (caches[0]->has_static_geometry() ? "especializada" : "configurada en ejecucion") << ")\n";
+    if (caches[0]->prefetcher()) {
+        out << "Prefetcher: " << caches[0]->prefetcher()->name()
+                  << " (grado " << cache_config.prefetch.degree << ")\n";
+    }
+    BusInterconnect bus(caches, &memory, scheduler, debug, bus_timing, out);
+    std::unique_ptr<DramModel> dram;
+    if (dram_config) {
+        dram = std::make_unique<DramModel>(scheduler, *dram_config);
+        bus.set_dram(dram.get());
+    }
+    std::unique_ptr<SharedLLC> llc;
+    if (llc_config) {
+        llc = std::make_unique<SharedLLC>(&memory, scheduler, caches[0]->line_bytes(), *llc_config);
+        bus.set_llc(llc.get());
+    }
 
     std::vector<MemoryFacade*> facades;
-    for (int i = 0; i < 4; ++i) facades.push_back(new MemoryFacade(caches[i], &bus, i));
-
-    for (int blk = 0; blk < 16; ++blk) {
+    for (size_t i = 0; i < pe_count; ++i) facades.push_back(new MemoryFacade(caches[i], &bus, static_cast<int>(i)));
+
+    const uint64_t elems = pe_count * workload.elems_per_pe;
+    const DotLayout layout = dot_layout(pe_count, workload);
+    const uint64_t baseArrB = layout.base_b;
+    const uint64_t basePartials = layout.base_partials;
+    // Con --restore la Memoria sale del checkpoint
+    for (uint64_t blk = 0; blk < elems && !restore_from; ++blk) {
         double aVal = static_cast<double>(blk + 1);
         double bVal = static_cast<double>(2 * (blk + 1));
         uint64_t aBits; std::memcpy(&aBits, &aVal, 8);
         uint64_t bBits; std::memcpy(&bBits, &bVal, 8);
-        const int baseArrB = 512;
-        memory.write_word(blk * 32, &aBits); // usar write_word para una palabra
-        memory.write_word(baseArrB + blk * 32, &bBits);
+        memory.write_word(blk * workload.stride(), &aBits); // usar write_word para una palabra
+        memory.write_word(baseArrB + blk * workload.stride(), &bBits);
     }
     uint64_t zero = 0;
-    memory.write_word(1024, &zero);
-    memory.write_word(1056, &zero);
-    memory.write_word(1088, &zero);
-    memory.write_word(1120, &zero);
+    for (size_t pe = 0; pe < pe_count && !restore_from; ++pe) memory.write_word(basePartials + pe * DOT_STRIDE, &zero);
 
     uint64_t data = 0;
     
     
-    for (size_t j = 0; j < 4; ++j) {
-        memory.read_block(j * 32, &data);
+    for (size_t j = 0; j < 4 && !restore_from; ++j) {
+        memory.read_word(j * 32, &data);
         double a; std::memcpy(&a, &data, sizeof(uint64_t));
-        std::cout << "Mem[" << j * 32 << "] = " << a << "\n";
+        out << "Mem[" << j * 32 << "] = " << a << "\n";
     }
 
-    std::vector<Instruction> p0 = loadProgramFile("pe0.pec");
-    std::vector<Instruction> p1 = loadProgramFile("pe1.pec");
-    std::vector<Instruction> p2 = loadProgramFile("pe2.pec");
-    std::vector<Instruction> p3 = loadProgramFile("pe3.pec");
-
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) system.getPE(i).attachMemory(facades[i]);
-    system.loadProgram(0, p0); system.loadProgram(1, p1); system.loadProgram(2, p2); system.loadProgram(3, p3);
+    // --capture: cada PE pasa por un CaptureMemory que registra sus accesos
+    std::vector<std::unique_ptr<CaptureMemory>> captures;
+    for (size_t i = 0; i < system.size(); ++i) {
+        if (capture) {
+            captures.push_back(std::make_unique<CaptureMemory>(facades[i], capture, static_cast<unsigned>(i)));
+            system.getPE(i).attachMemory(captures.back().get());
+        } else {
+            system.getPE(i).attachMemory(facades[i]);
+        }
+    }
+    if (pe_count == ProcessorSystem::DEFAULT_PE_COUNT && workload.is_default()) {
+        // Configuración original: programas en disco (o sus imágenes .pecb)
+        for (size_t i = 0; i < pe_count; ++i) load_pe_program(system, i, "pe" + std::to_string(i) + ".pec");
+    } else {
+        for (size_t i = 0; i < pe_count; ++i) system.loadProgram(i, make_dot_product_program(i, pe_count, workload));
+    }
 
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) system.getPE(i).start(nullptr);
-    system.joinAll();
-    std::cout << "Todos los PEs han terminado la ejecución.\n";
-    bus.stop();
+    if (restore_from) {
+        restore_from->restore(scheduler, system, caches, memory, bus);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restore_start).count();
+        out << "[CHECKPOINT] Restaurado " << checkpoint->restore_path << " en el ciclo " << restore_from->cycle()
+                  << " (" << memory.resident_pages() << " paginas, " << (restore_from->mapped() ? "mmap" : "copia")
+                  << ") en " << ms << " ms\n";
+    } else if (checkpoint && !checkpoint->save_path.empty()) {
+        // Avanza hasta el ciclo pedido, deja drenar los accesos en vuelo, guarda y continúa
+        for (size_t i = 0; i < system.size(); ++i) system.getPE(i).pauseAt(checkpoint->save_at);
+        system.startAll(scheduler);
+        scheduler.run();
+        save_checkpoint(checkpoint->save_path, scheduler, system, caches, memory, bus);
+        out << "[CHECKPOINT] Guardado " << checkpoint->save_path << " en el ciclo " << scheduler.now()
+                  << " (" << memory.resident_pages() << " paginas)\n";
+        for (size_t i = 0; i < system.size(); ++i) {
+            ProcessingElement& pe = system.getPE(i);
+            if (pe.isPaused()) pe.resume(scheduler, pe.getResumeCycle());
+        }
+    } else {
+        system.startAll(scheduler);
+    }
+    Cycle total_cycles = scheduler.run();
+    out << "Todos los PEs han terminado la ejecución.\n";
+    for (auto& c : captures) c->flush();
 
     // flush caches antes de leer resultados
     for (auto* c : caches) c->flush();
+    if (llc) llc->flush();
 
+    Metrics totals;
     for (auto* c : caches) {
-        c->print_metrics();
-        c->print_cache_lines();
+        c->print_metrics(out);
+        c->print_cache_lines(out);
+        totals += c->metrics();
     }
 
     for (auto* f: facades) {
         // Suponiendo que MemoryFacade tiene un método para imprimir contadores
-        std::cout << "[MemoryFacade PE " << f->getPEId() << "] Load count: " << f->getLoadCount()
-                  << ", Store count: " << f->getStoreCount() << "\n";
+        out << "[MemoryFacade PE " << f->getPEId() << "] Load count: " << f->getLoadCount()
+                  << ", Store count: " << f->getStoreCount()
+                  << ", Aciertos locales (sin Bus): " << f->getLocalHitCount() << "\n";
     }
     double dot_product = 0.0;
-    for (size_t j = 0; j < 4; ++j) {
-        memory.read_word(j * 32 + 1024, &data);
+    for (size_t j = 0; j < pe_count; ++j) {
+        memory.read_word(basePartials + j * DOT_STRIDE, &data);
         double a; std::memcpy(&a, &data, sizeof(uint64_t));
         dot_product += a;
     }
-    std::cout << "Producto punto calculado: " << dot_product << std::endl;
+    out << "Producto punto calculado: " << dot_product << std::endl;
+
+    out << "Ciclos simulados: " << total_cycles
+              << " (" << scheduler.events_processed() << " eventos)\n";
+    system.printStats(out);
+    bus.print_stats(out);
+    if (dram) dram->print_stats(out);
+    if (llc) llc->print_stats(out);
+    // AMAT medido: ciclos que los PEs esperaron por sus accesos / accesos
+    uint64_t mem_accesses = 0;
+    Cycle mem_stall = 0;
+    for (size_t i = 0; i < system.size(); ++i) {
+        mem_accesses += system.getPE(i).getMemAccessCount();
+        mem_stall += system.getPE(i).getMemStallCycles();
+    }
+    out << "[AMAT] Hit rate L1: " << 100.0 * (1.0 - totals.miss_rate()) << "%";
+    if (llc) out << " LLC: " << 100.0 * llc->stats().hit_rate() << "%";
+    out << " AMAT: " << (mem_accesses ? static_cast<double>(mem_stall) / mem_accesses : 0.0) << " ciclos\n";
+    out << "[MEM] Paginas residentes: " << memory.resident_pages()
+              << " (" << memory.resident_bytes() / 1024 << " KB)\n";
+
+    if (registry) {
+        registry->label("protocol", coherence_protocol_name(cache_config.protocol));
+        registry->label("policy", totals.policy);
+        registry->label("sets", std::to_string(caches[0]->sets()));
+        registry->label("ways", std::to_string(caches[0]->ways()));
+        registry->label("line_bytes", std::to_string(caches[0]->line_bytes()));
+        registry->label("pes", std::to_string(pe_count));
+        registry->label("kernel", dot_kernel_name(workload.kernel));
+        registry->label("elems_per_pe", std::to_string(workload.elems_per_pe));
+        registry->label("outstanding", std::to_string(bus_timing.max_outstanding));
+        registry->label("prefetch", caches[0]->prefetcher() ? caches[0]->prefetcher()->name() : "none");
+        registry->label("dram", dram ? "on" : "off");
+        registry->label("llc", llc ? inclusion_policy_name(llc_config->inclusion) : "off");
+        registry->counter("system", "cycles", total_cycles);
+        registry->counter("system", "events", scheduler.events_processed());
+        registry->gauge("system", "dot_product", dot_product);
+        registry->gauge("system", "l1_hit_rate", 1.0 - totals.miss_rate());
+        registry->gauge("system", "amat", mem_accesses ? static_cast<double>(mem_stall) / mem_accesses : 0.0);
+        system.exportMetrics(*registry);
+        for (auto* c : caches) c->export_metrics(*registry);
+        bus.export_metrics(*registry);
+        if (llc) llc->export_metrics(*registry);
+        if (dram) dram->export_metrics(*registry);
+        memory.export_metrics(*registry);
+    }
 
     // for (size_t j = 0; j < 4; ++j) {
     //     memory.read_word(j * 32 + 1024, &data);
     //     double a; std::memcpy(&a, &data, sizeof(uint64_t));
     //     std::cout << "Partials[" << j * 32 + 1024 << "] = " << a << "\n";
     // }
-    for (auto* f : facades) delete f; for (auto* c : caches) delete c;
+    for (auto* f : facades) delete f;
+    for (auto* c : caches) delete c;
+    return totals;
+}
 
+// Modo --replay: cada core de la traza de accesos maneja su propia L1 (vía MemoryFacade)
+// sobre el mismo Bus, LLC y DRAM que el producto punto. stream fuerza la lectura sin mmap.
+void trace_replay(const std::string& path, bool stream, const CacheConfig& cache_config,
+                  const BusTiming& bus_timing, const DramConfig* dram_config,
+                  const LLCConfig* llc_config, MetricsRegistry* registry) {
+    AccessTraceReader reader(path, stream ? AccessTraceReader::Mode::STREAM : AccessTraceReader::Mode::MMAP);
+    std::cout << "==== Reproduccion de traza " << path << " ====\n";
+    std::cout << "Cores: " << reader.cores() << " Registros: " << reader.records() << " ("
+              << (reader.mode() == AccessTraceReader::Mode::MMAP ? "mmap" : "stream") << ")\n";
+
+    EventScheduler scheduler;
+    Memory memory;
+    std::vector<CacheL1*> caches;
+    for (unsigned i = 0; i < reader.cores(); ++i) {
+        caches.push_back(make_cache_l1(static_cast<int>(i), &memory, cache_config).release());
+    }
+    std::cout << "Geometria de cache: " << caches[0]->sets() << " sets x " << caches[0]->ways()
+              << " vias x " << caches[0]->line_bytes() << " B\n";
+    BusInterconnect bus(caches, &memory, scheduler, false, bus_timing);
+    std::unique_ptr<DramModel> dram;
+    if (dram_config) {
+        dram = std::make_unique<DramModel>(scheduler, *dram_config);
+        bus.set_dram(dram.get());
+    }
+    std::unique_ptr<SharedLLC> llc;
+    if (llc_config) {
+        llc = std::make_unique<SharedLLC>(&memory, scheduler, caches[0]->line_bytes(), *llc_config);
+        bus.set_llc(llc.get());
+    }
+    std::vector<std::unique_ptr<MemoryFacade>> facades;
+    std::vector<SharedMemory*> memories;
+    for (unsigned i = 0; i < reader.cores(); ++i) {
+        facades.push_back(std::make_unique<MemoryFacade>(caches[i], &bus, static_cast<int>(i)));
+        memories.push_back(facades.back().get());
+    }
+
+    TraceReplay replay(reader, memories, scheduler, caches[0]->line_bytes());
+    const auto host_start = std::chrono::steady_clock::now();
+    replay.start();
+    const Cycle total_cycles = scheduler.run();
+    const double host_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - host_start).count();
+    for (auto* c : caches) c->flush();
+    if (llc) llc->flush();
+
+    Metrics totals;
+    for (auto* c : caches) {
+        c->print_metrics();
+        totals += c->metrics();
+    }
+    replay.print_stats();
+    std::cout << "Ciclos simulados: " << total_cycles << " (" << scheduler.events_processed() << " eventos)\n";
+    std::cout << "[REPLAY] Accesos: " << replay.accesses() << " en " << host_seconds << " s ("
+              << (host_seconds > 0 ? replay.accesses() / host_seconds / 1e6 : 0.0) << " M accesos/s)\n";
+    bus.print_stats();
+    if (dram) dram->print_stats();
+    if (llc) llc->print_stats();
+    std::cout << "[AMAT] Hit rate L1: " << 100.0 * (1.0 - totals.miss_rate()) << "%";
+    if (llc) std::cout << " LLC: " << 100.0 * llc->stats().hit_rate() << "%";
+    std::cout << "\n[MEM] Paginas residentes: " << memory.resident_pages()
+              << " (" << memory.resident_bytes() / 1024 << " KB)\n";
+
+    if (registry) {
+        registry->label("trace", path);
+        registry->label("protocol", coherence_protocol_name(cache_config.protocol));
+        registry->label("policy", totals.policy);
+        registry->label("sets", std::to_string(caches[0]->sets()));
+        registry->label("ways", std::to_string(caches[0]->ways()));
+        registry->label("line_bytes", std::to_string(caches[0]->line_bytes()));
+        registry->label("cores", std::to_string(reader.cores()));
+        registry->label("outstanding", std::to_string(bus_timing.max_outstanding));
+        registry->label("prefetch", caches[0]->prefetcher() ? caches[0]->prefetcher()->name() : "none");
+        registry->label("dram", dram ? "on" : "off");
+        registry->label("llc", llc ? inclusion_policy_name(llc_config->inclusion) : "off");
+        registry->counter("system", "cycles", total_cycles);
+        registry->counter("system", "events", scheduler.events_processed());
+        registry->gauge("system", "host_seconds", host_seconds);
+        replay.export_metrics(*registry);
+        for (auto* c : caches) c->export_metrics(*registry);
+        bus.export_metrics(*registry);
+        if (llc) llc->export_metrics(*registry);
+        if (dram) dram->export_metrics(*registry);
+        memory.export_metrics(*registry);
+    }
+    facades.clear();
+    for (auto* c : caches) delete c;
 }
 
 void processor_system_dot_product_shared() {
     std::cout << "==== Dot Product (SharedMemoryInstance) ====\n";
     ProcessorSystem system;
+    EventScheduler scheduler;
     SharedMemoryInstance mem(2048); // suficiente para direccionar hasta 280
 
     // Inicializar vectores A (base 0) y B (base 128) con 16 doubles
@@ -421,12 +1112,12 @@ void processor_system_dot_product_shared() {
     std::vector<Instruction> p3 = loadProgramFile("pe3.pec");
 
     // Adjuntar memoria
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) system.getPE(i).attachMemory(&mem);
+    for (size_t i = 0; i < system.size(); ++i) system.getPE(i).attachMemory(&mem);
     system.loadProgram(0, p0); system.loadProgram(1, p1); system.loadProgram(2, p2); system.loadProgram(3, p3);
 
     // Ejecutar
-    for (size_t i = 0; i < ProcessorSystem::PE_COUNT; ++i) system.getPE(i).start(nullptr);
-    system.joinAll();
+    system.startAll(scheduler);
+    scheduler.run();
 
     // Leer parciales
     double partials[4];
@@ -441,14 +1132,367 @@ void processor_system_dot_product_shared() {
     std::cout << "\nDot final = " << finalDot << "\n";
 }
 
-int main(int argc, char* argv[]) {
+// Opciones que definen una corrida del producto punto; --sweep arma una por línea
+struct RunOptions {
+    bool debug = false;
+    bool compare_policies = false;
+    CacheConfig cache_config;
+    size_t pe_count = ProcessorSystem::DEFAULT_PE_COUNT;
+    BusTiming bus_timing;
+    bool use_dram = false;
+    DramConfig dram_config;
+    bool use_llc = false;
+    LLCConfig llc_config;
+    DotWorkload workload;
+
+    const DramConfig* dram() const { return use_dram ? &dram_config : nullptr; }
+    const LLCConfig* llc() const { return use_llc ? &llc_config : nullptr; }
+};
+
+// Consume args[i] (y su valor, avanzando i) si es una opción de RunOptions; false si no lo es
+// Valor numérico de 'flag': solo dígitos decimales y a lo sumo 'max' (stoul acepta "-1",
+// "12abc" y valores que no caben en unsigned; aquí se rechazan antes de reducir el tipo)
+uint64_t parse_option_number(const std::string& flag, const std::string& text,
+                             uint64_t max = std::numeric_limits<unsigned>::max()) {
+    uint64_t value = 0;
+    bool in_range = !text.empty();
+    for (char c : text) {
+        const uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (!std::isdigit(static_cast<unsigned char>(c)) || value > (max - digit) / 10) {
+            in_range = false;
+            break;
+        }
+        value = value * 10 + digit;
+    }
+    if (!in_range) {
+        throw std::invalid_argument(flag + " " + text + ": se espera un entero entre 0 y " + std::to_string(max));
+    }
+    return value;
+}
+
+// Tope de --sets, --llc-sets y --llc-banks: el arreglo de cada caché se reserva completo
+constexpr unsigned MAX_CACHE_SETS = 1u << 20;
+
+bool parse_run_option(RunOptions& run, const std::vector<std::string>& args, size_t& i) {
+    const std::string& arg = args[i];
+    auto next_string = [&]() -> const std::string& {
+        if (i + 1 >= args.size()) throw std::invalid_argument("Falta el valor de " + arg);
+        return args[++i];
+    };
+    auto next_value = [&](uint64_t max = std::numeric_limits<unsigned>::max()) -> unsigned {
+        return static_cast<unsigned>(parse_option_number(arg, next_string(), max));
+    };
+    if (arg == "--debug") run.debug = true;
+    else if (arg == "--sets") run.cache_config.sets = next_value(MAX_CACHE_SETS);
+    else if (arg == "--ways") run.cache_config.ways = next_value();
+    else if (arg == "--line") run.cache_config.line_bytes = next_value(Memory::PAGE_BYTES);
+    else if (arg == "--seed") run.cache_config.seed = next_value();
+    else if (arg == "--pes") run.pe_count = next_value();
+    else if (arg == "--elems") run.workload.elems_per_pe = next_value();
+    else if (arg == "--kernel") run.workload.kernel = parse_dot_kernel(next_string());
+    else if (arg == "--outstanding") run.bus_timing.max_outstanding = next_value();
+    else if (arg == "--snoop-filter") run.bus_timing.snoop_filter = true;
+    else if (arg == "--dram") run.use_dram = true;
+    else if (arg == "--dram-channels") { run.use_dram = true; run.dram_config.channels = next_value(); }
+    else if (arg == "--dram-banks") { run.use_dram = true; run.dram_config.banks = next_value(); }
+    else if (arg == "--dram-row") { run.use_dram = true; run.dram_config.row_bytes = next_value(); }
+    else if (arg == "--llc") run.use_llc = true;
+    else if (arg == "--llc-banks") { run.use_llc = true; run.llc_config.banks = next_value(MAX_CACHE_SETS); }
+    else if (arg == "--llc-sets") { run.use_llc = true; run.llc_config.sets = next_value(MAX_CACHE_SETS); }
+    else if (arg == "--llc-ways") { run.use_llc = true; run.llc_config.ways = next_value(); }
+    else if (arg == "--llc-policy") {
+        run.use_llc = true;
+        run.llc_config.replacement = parse_replacement_kind(next_string());
+    }
+    else if (arg == "--llc-inclusion") {
+        run.use_llc = true;
+        run.llc_config.inclusion = parse_inclusion_policy(next_string());
+    }
+    else if (arg == "--protocol") run.cache_config.protocol = parse_coherence_protocol(next_string());
+    else if (arg == "--prefetch") run.cache_config.prefetch.kind = parse_prefetch_kind(next_string());
+    else if (arg == "--prefetch-degree") run.cache_config.prefetch.degree = next_value();
+    else if (arg == "--policy") {
+        const std::string& name = next_string();
+        if (name == "all") run.compare_policies = true;
+        else run.cache_config.replacement = parse_replacement_kind(name);
+    }
+    else return false;
+    return true;
+}
+
+// Cada política admite hasta cierto número de vías (LRU 16, RRIP 32, PLRU potencia de dos):
+// se valida al leer las opciones para sugerir otra en vez de abortar al construir la caché
+void check_policy_ways(ReplacementKind kind, unsigned ways, const std::string& ways_flag,
+                       const std::string& policy_flag) {
+    try {
+        make_replacement_policy(kind, ways, 0);
+    } catch (const std::invalid_argument& e) {
+        std::string supported;
+        for (const char* name : {"lru", "plru", "srrip", "brrip", "random"}) {
+            try {
+                make_replacement_policy(parse_replacement_kind(name), ways, 0);
+                supported += std::string(supported.empty() ? "" : ", ") + name;
+            } catch (const std::invalid_argument&) {
+            }
+        }
+        std::string message = ways_flag + " " + std::to_string(ways) + ": " + e.what();
+        if (!supported.empty()) message += "; elegir otra con " + policy_flag + " (" + supported + ")";
+        throw std::invalid_argument(message);
+    }
+}
+
+void validate_run_options(const RunOptions& run) {
+    if (run.cache_config.ways == 0 || run.cache_config.ways > TagStore::MAX_WAYS) {
+        throw std::invalid_argument("--ways debe estar entre 1 y " + std::to_string(TagStore::MAX_WAYS));
+    }
+    // --policy all omite las políticas que no admiten las vías pedidas
+    if (!run.compare_policies) {
+        check_policy_ways(run.cache_config.replacement, run.cache_config.ways, "--ways", "--policy");
+    }
+    if (run.use_llc) check_policy_ways(run.llc_config.replacement, run.llc_config.ways, "--llc-ways", "--llc-policy");
+    const DotWorkload& workload = run.workload;
+    if (workload.elems_per_pe == 0 ||
+        (workload.kernel == DotKernel::VECTOR && workload.elems_per_pe % VECTOR_LANES != 0)) {
+        throw std::invalid_argument("--elems debe ser positivo (y multiplo de " + std::to_string(VECTOR_LANES) +
+                                    " con --kernel vector)");
+    }
+    // VLOAD/VSTORE acceden VECTOR_BYTES alineados y no pueden cruzar de línea
+    if (workload.kernel == DotKernel::VECTOR && run.cache_config.line_bytes % VECTOR_BYTES != 0) {
+        throw std::invalid_argument("--line debe ser multiplo de " + std::to_string(VECTOR_BYTES) +
+                                    " con --kernel vector");
+    }
+}
+
+// Archivo de --sweep: una corrida por línea con las mismas opciones de la línea de comandos,
+// aplicadas sobre 'base'; '#' comenta hasta el fin de línea. El nombre de la corrida es el
+// texto de la línea. Lanza std::invalid_argument ante opciones que no definen una corrida.
+std::vector<std::pair<std::string, RunOptions>> load_sweep_file(const std::string& path, const RunOptions& base) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("No se pudo abrir " + path);
+    std::vector<std::pair<std::string, RunOptions>> runs;
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::vector<std::string> args;
+        for (std::string token; tokens >> token;) args.push_back(token);
+        if (args.empty()) continue;
+        const std::string where = path + ":" + std::to_string(number) + ": ";
+        RunOptions run = base;
+        try {
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (!parse_run_option(run, args, i)) throw std::invalid_argument("opcion no valida en un barrido: " + args[i]);
+            }
+            if (run.debug || run.compare_policies) {
+                throw std::invalid_argument("--debug y --policy all no se usan en un barrido");
+            }
+            validate_run_options(run);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument(where + e.what());
+        }
+        std::string name = args[0];
+        for (size_t i = 1; i < args.size(); ++i) name += " " + args[i];
+        runs.emplace_back(name, run);
+    }
+    if (runs.empty()) throw std::invalid_argument(path + ": el barrido no tiene corridas");
+    return runs;
+}
+
+// Modo --sweep: cada corrida es un sistema completo e independiente; jobs hilos del host
+// las reparten (0 = todos los cores). Imprime una tabla resumen en el orden del archivo.
+// Retorna false si alguna corrida falló.
+bool run_sweep(const std::vector<std::pair<std::string, RunOptions>>& configs, unsigned jobs,
+               std::vector<MetricsRegistry>& runs) {
+    SweepRunner sweep(jobs);
+    for (const auto& config : configs) {
+        const RunOptions& run = config.second;
+        sweep.add(config.first, [&run](MetricsRegistry& metrics, std::ostream& log) {
+            processor_system_dot_product(false, run.cache_config, run.pe_count, run.bus_timing, run.dram(),
+                                         run.llc(), &metrics, nullptr, nullptr, run.workload, log);
+        });
+    }
+    std::cout << "==== Barrido de parametros: " << sweep.size() << " corridas en " << sweep.threads()
+              << " hilos ====" << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<SweepRunner::Result> results = sweep.run();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t width = 8;
+    for (const auto& r : results) width = std::max(width, r.metrics.run().size() + 2);
+    std::cout << std::left << std::setw(static_cast<int>(width)) << "corrida" << std::right
+              << std::setw(10) << "ciclos" << std::setw(10) << "hit L1" << std::setw(10) << "bus tx"
+              << std::setw(10) << "AMAT" << std::setw(12) << "producto" << std::setw(10) << "seg" << "\n";
+    double busy = 0.0;
+    bool all_ok = true;
+    for (SweepRunner::Result& r : results) {
+        busy += r.seconds;
+        std::cout << std::left << std::setw(static_cast<int>(width)) << r.metrics.run() << std::right;
+        if (!r.ok()) {
+            all_ok = false;
+            std::cout << "ERROR: " << r.error << "\n";
+            continue;
+        }
+        const MetricsRegistry& m = r.metrics;
+        std::cout << std::fixed << std::setprecision(0) << std::setw(10) << m.value("system", "cycles")
+                  << std::setprecision(2) << std::setw(9) << 100.0 * m.value("system", "l1_hit_rate") << "%"
+                  << std::setprecision(0) << std::setw(10) << m.value("bus", "transactions")
+                  << std::setprecision(2) << std::setw(10) << m.value("system", "amat")
+                  << std::setprecision(0) << std::setw(12) << m.value("system", "dot_product")
+                  << std::setprecision(3) << std::setw(10) << r.seconds << std::defaultfloat << "\n";
+        runs.push_back(std::move(r.metrics));
+    }
+    // busy / wall: cuántas corridas avanzaron a la vez en promedio
+    std::cout << "Tiempo total: " << wall << " s (suma de corridas " << busy << " s, paralelismo "
+              << (wall > 0.0 ? busy / wall : 0.0) << "x)\n";
+    return all_ok;
+}
+
+int run_simulator(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "test_mode") return test_mode();
+    RunOptions options;
+    std::string trace_path;
+    TraceLevel trace_level = TraceLevel::DEBUG;
+    std::string metrics_json_path;
+    std::string metrics_csv_path;
+    std::string replay_path;
+    bool replay_stream = false;
+    std::string capture_path;
+    CheckpointOptions checkpoint;
+    std::string sweep_path;
+    unsigned sweep_jobs = 0;
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (parse_run_option(options, args, i)) continue;
+        const std::string& arg = args[i];
+        auto next_string = [&]() -> const std::string& {
+            if (i + 1 >= args.size()) throw std::invalid_argument("Falta el valor de " + arg);
+            return args[++i];
+        };
+        if (arg == "--trace") trace_path = next_string();
+        else if (arg == "--trace-level") trace_level = trace::parse_level(next_string());
+        else if (arg == "--replay") replay_path = next_string();
+        else if (arg == "--replay-stream") replay_stream = true;
+        else if (arg == "--checkpoint") checkpoint.save_path = next_string();
+        else if (arg == "--restore") checkpoint.restore_path = next_string();
+        else if (arg == "--checkpoint-at") checkpoint.save_at = parse_option_number(arg, next_string(), UINT64_MAX);
+        else if (arg == "--capture") capture_path = next_string();
+        else if (arg == "--metrics-json") metrics_json_path = next_string();
+        else if (arg == "--metrics-csv") metrics_csv_path = next_string();
+        else if (arg == "--sweep") sweep_path = next_string();
+        else if (arg == "--jobs") sweep_jobs = static_cast<unsigned>(parse_option_number(arg, next_string()));
+        else throw std::invalid_argument("opcion no reconocida: " + arg);
+    }
+
+    validate_run_options(options);
+    // Nombres cortos para el resto de main
+    const bool debug = options.debug;
+    const bool compare_policies = options.compare_policies;
+    CacheConfig& cache_config = options.cache_config;
+    const size_t pe_count = options.pe_count;
+    const BusTiming& bus_timing = options.bus_timing;
+    const DotWorkload& workload = options.workload;
+
+    // Las trazas, la captura y los checkpoints son de un solo sistema: no se mezclan corridas
+    if (!sweep_path.empty() && (debug || compare_policies || !trace_path.empty() || !capture_path.empty() ||
+                                !replay_path.empty() || !checkpoint.save_path.empty() ||
+                                !checkpoint.restore_path.empty())) {
+        throw std::invalid_argument("--sweep no se combina con --debug, --policy all, --trace, --capture, "
+                                    "--replay ni --checkpoint/--restore");
+    }
+
+    if (!capture_path.empty() && (!replay_path.empty() || compare_policies)) {
+        throw std::invalid_argument("--capture no se combina con --replay ni con --policy all");
+    }
+
+    const bool use_checkpoint = !checkpoint.save_path.empty() || !checkpoint.restore_path.empty();
+    if (use_checkpoint && (!replay_path.empty() || compare_policies || options.use_llc)) {
+        throw std::invalid_argument("--checkpoint/--restore no se combinan con --replay, --policy all ni --llc");
+    }
+    if (!checkpoint.save_path.empty() && !checkpoint.restore_path.empty()) {
+        throw std::invalid_argument("--checkpoint y --restore son excluyentes");
+    }
+
+    // Trazas binarias: se leen con ./trace_decode <archivo>
+    if (!trace_path.empty()) trace::open(trace_path, trace_level);
+
+    // Una instantánea de métricas por corrida; se exportan todas al final
+    const bool export_metrics = !metrics_json_path.empty() || !metrics_csv_path.empty();
+    std::vector<MetricsRegistry> runs;
+    auto save_runs = [&]() {
+        if (!metrics_json_path.empty()) save_metrics(metrics_json_path, runs, true);
+        if (!metrics_csv_path.empty()) save_metrics(metrics_csv_path, runs, false);
+    };
+
+    if (!sweep_path.empty()) {
+        // Las opciones de la línea de comandos son la base de cada línea del archivo
+        const bool ok = run_sweep(load_sweep_file(sweep_path, options), sweep_jobs, runs);
+        save_runs();
+        return ok ? 0 : 1;
+    }
+
+    if (!replay_path.empty()) {
+        if (export_metrics) runs.emplace_back("replay");
+        trace_replay(replay_path, replay_stream, cache_config, bus_timing, options.dram(),
+                     options.llc(), export_metrics ? &runs.back() : nullptr);
+        save_runs();
+        trace::close();
+        return 0;
+    }
+
+    if (compare_policies) {
+        // Misma carga con cada política; tabla final de hits/misses
+        const ReplacementKind kinds[] = { ReplacementKind::LRU, ReplacementKind::TREE_PLRU,
+            ReplacementKind::SRRIP, ReplacementKind::BRRIP, ReplacementKind::RANDOM };
+        std::vector<Metrics> results;
+        std::vector<std::string> skipped;
+        for (ReplacementKind kind : kinds) {
+            try {
+                make_replacement_policy(kind, cache_config.ways, 0);
+            } catch (const std::invalid_argument& e) {
+                skipped.push_back(std::string(replacement_kind_name(kind)) + ": omitida (" + e.what() + ")");
+                continue;
+            }
+            cache_config.replacement = kind;
+            MetricsRegistry* registry = nullptr;
+            if (export_metrics) {
+                runs.emplace_back(replacement_kind_name(kind));
+                registry = &runs.back();
+            }
+            results.push_back(processor_system_dot_product(false, cache_config, pe_count, bus_timing,
+                                                           options.dram(), options.llc(), registry,
+                                                           nullptr, nullptr, workload));
+        }
+        std::cout << "\n==== Comparacion de politicas de reemplazo ====\n";
+        for (const Metrics& m : results) {
+            std::cout << m.policy << ": Hits " << m.hits << " Misses " << m.misses
+                      << " Desalojos " << m.evictions << " Miss rate " << (100.0 * m.miss_rate()) << "%\n";
+        }
+        for (const std::string& line : skipped) std::cout << line << "\n";
+        save_runs();
+        trace::close();
+        return 0;
+    }
+
     // processor_system_dot_product_shared();
-    if (argc > 1 && std::string(argv[1]) == "--debug") {
-        processor_system_dot_product(true);
-    } else {
-        std::cout << "PRUEBA PRODUCTO PUNTO DISTRIBUIDO EN 4 PEs CON CACHÉS Y BUS INTERCONNECT" << std::endl << std::flush;
-        processor_system_dot_product();
+    if (!debug) {
+        std::cout << "PRUEBA PRODUCTO PUNTO DISTRIBUIDO EN " << pe_count
+                  << " PEs CON CACHÉS Y BUS INTERCONNECT" << std::endl << std::flush;
+    }
+    if (export_metrics) runs.emplace_back("dot_product");
+    std::unique_ptr<ExecTraceWriter> capture;
+    if (!capture_path.empty()) capture = std::make_unique<ExecTraceWriter>(capture_path, static_cast<unsigned>(pe_count));
+    processor_system_dot_product(debug, cache_config, pe_count, bus_timing, options.dram(),
+                                 options.llc(), export_metrics ? &runs.back() : nullptr,
+                                 capture.get(), use_checkpoint ? &checkpoint : nullptr, workload);
+    if (capture) {
+        capture->close();
+        std::cout << "[CAPTURE] " << capture_path << ": " << capture->records() << " accesos, "
+                  << capture->encoded_bytes() << " bytes ("
+                  << (capture->records() ? static_cast<double>(capture->encoded_bytes()) / capture->records() : 0.0)
+                  << " B/acceso)\n";
     }
+    save_runs();
+    trace::close();
     // test_interconnect_full_mesi();
     //processor_system_dot_product_shared();
     //std::cout << "\n";
@@ -462,3 +1506,17 @@ int main(int argc, char* argv[]) {
     // processor_system_with_memory_facade();
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    try {
+        return run_simulator(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        // Opciones o configuración inválidas: mensaje en lugar de terminate()
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    } catch (const std::exception& e) {
+        // Archivos que no se pueden abrir o no coinciden (checkpoint, traza, programa)
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,258 @@
+#include "Checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define CHECKPOINT_HAS_MMAP 1
+#endif
+
+using namespace checkpoint;
+
+namespace {
+
+uint64_t align_up(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Relleno con ceros hasta 'offset'
+void pad_to(std::FILE* file, uint64_t offset) {
+    static const uint8_t zeros[256] = {};
+    uint64_t at = static_cast<uint64_t>(std::ftell(file));
+    while (at < offset) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(sizeof(zeros), offset - at));
+        std::fwrite(zeros, 1, n, file);
+        at += n;
+    }
+}
+
+// Aritmética del layout de un archivo leído: un encabezado dañado no debe desbordar
+uint64_t checked_mul(uint64_t a, uint64_t b) {
+    uint64_t result;
+    if (__builtin_mul_overflow(a, b, &result)) throw std::overflow_error("desborde");
+    return result;
+}
+
+uint64_t checked_add(uint64_t a, uint64_t b) {
+    uint64_t result;
+    if (__builtin_add_overflow(a, b, &result)) throw std::overflow_error("desborde");
+    return result;
+}
+
+// Recalcula el layout que escribe save_checkpoint a partir de la geometría y page_count;
+// false si algún offset del encabezado no coincide o el cálculo desborda
+bool layout_matches(const FileHeader& h) {
+    try {
+        const uint64_t lines = checked_mul(h.sets, h.ways);
+        const uint64_t cache_bytes = checked_add(checked_add(checked_mul(lines, sizeof(LineSnapshot)),
+                                                             checked_mul(h.sets, sizeof(uint64_t))),
+                                                 checked_mul(lines, h.line_bytes));
+        const uint64_t cache_offset = checked_add(sizeof(FileHeader), checked_mul(h.pes, sizeof(PEState)));
+        const uint64_t page_index_offset = checked_add(cache_offset, checked_mul(h.pes, cache_bytes));
+        const uint64_t index_end = checked_add(page_index_offset, checked_mul(h.page_count, sizeof(uint64_t)));
+        const uint64_t page_data_offset =
+            checked_add(index_end, Memory::PAGE_BYTES - 1) / Memory::PAGE_BYTES * Memory::PAGE_BYTES;
+        const uint64_t file_bytes = checked_add(page_data_offset, checked_mul(h.page_count, Memory::PAGE_BYTES));
+        return h.pe_offset == sizeof(FileHeader) && h.cache_offset == cache_offset &&
+               h.cache_bytes == cache_bytes && h.page_index_offset == page_index_offset &&
+               h.page_data_offset == page_data_offset && h.file_bytes == file_bytes;
+    } catch (const std::overflow_error&) {
+        return false;
+    }
+}
+
+} // namespace
+
+/* ---------------- Guardar ---------------- */
+
+void save_checkpoint(const std::string& path, const EventScheduler& scheduler, const ProcessorSystem& system,
+                     const std::vector<CacheL1*>& caches, const Memory& memory, const BusInterconnect& bus) {
+    if (!scheduler.empty() || !bus.idle()) {
+        throw std::logic_error("save_checkpoint: hay eventos o transacciones del Bus pendientes");
+    }
+    if (caches.size() != system.size()) throw std::invalid_argument("save_checkpoint: se necesita una cache por PE");
+
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.pes = static_cast<uint32_t>(system.size());
+    header.cycle = scheduler.now();
+    header.sets = caches[0]->sets();
+    header.ways = caches[0]->ways();
+    header.line_bytes = caches[0]->line_bytes();
+    header.protocol = static_cast<uint32_t>(caches[0]->protocol());
+    std::strncpy(header.replacement, caches[0]->metrics().policy, sizeof(header.replacement) - 1);
+    header.arbitration_pointer = bus.arbitration_pointer();
+
+    const uint64_t lines = static_cast<uint64_t>(header.sets) * header.ways;
+    header.cache_bytes = lines * sizeof(LineSnapshot) + header.sets * sizeof(uint64_t) + lines * header.line_bytes;
+    header.pe_offset = sizeof(FileHeader);
+    header.cache_offset = header.pe_offset + header.pes * sizeof(PEState);
+    header.page_index_offset = header.cache_offset + header.pes * header.cache_bytes;
+    header.page_count = memory.resident_pages();
+    header.page_data_offset = align_up(header.page_index_offset + header.page_count * sizeof(uint64_t),
+                                       Memory::PAGE_BYTES);
+    header.file_bytes = header.page_data_offset + header.page_count * Memory::PAGE_BYTES;
+
+    std::vector<PEState> pes(header.pes);
+    for (size_t i = 0; i < system.size(); ++i) {
+        const ProcessingElement& pe = system.getPE(i);
+        if (!pe.isPaused() && pe.isRunning()) {
+            throw std::logic_error("save_checkpoint: el PE " + std::to_string(i) + " no esta en pausa ni terminado");
+        }
+        const auto registers = pe.snapshotRegisters();
+        PEState& state = pes[i];
+        std::memcpy(state.registers, registers.data(), sizeof(state.registers));
+        std::memcpy(state.vector_registers, pe.vectorRegisters().data(), sizeof(state.vector_registers));
+        state.pc = pe.getPC();
+        state.resume_cycle = pe.getResumeCycle();
+        state.program_size = pe.getProgramSize();
+        state.program_fingerprint = pe.getProgramFingerprint();
+        state.paused = pe.isPaused();
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) throw std::runtime_error("save_checkpoint: no se pudo crear " + path);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fwrite(pes.data(), sizeof(PEState), pes.size(), file);
+
+    std::vector<uint8_t> block(header.cache_bytes);
+    for (const CacheL1* cache : caches) {
+        if (cache->sets() != header.sets || cache->ways() != header.ways || cache->line_bytes() != header.line_bytes) {
+            std::fclose(file);
+            throw std::invalid_argument("save_checkpoint: las caches no tienen la misma geometria");
+        }
+        auto* line_out = reinterpret_cast<LineSnapshot*>(block.data());
+        auto* replacement_out = reinterpret_cast<uint64_t*>(block.data() + lines * sizeof(LineSnapshot));
+        uint8_t* data_out = block.data() + lines * sizeof(LineSnapshot) + header.sets * sizeof(uint64_t);
+        cache->save_lines(line_out, replacement_out, data_out);
+        std::fwrite(block.data(), 1, block.size(), file);
+    }
+
+    std::vector<uint64_t> page_numbers;
+    page_numbers.reserve(header.page_count);
+    memory.for_each_page([&](uint64_t number, const uint8_t*) { page_numbers.push_back(number); });
+    std::fwrite(page_numbers.data(), sizeof(uint64_t), page_numbers.size(), file);
+    pad_to(file, header.page_data_offset);
+    memory.for_each_page([&](uint64_t, const uint8_t* page) { std::fwrite(page, 1, Memory::PAGE_BYTES, file); });
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!ok) throw std::runtime_error("save_checkpoint: error escribiendo " + path);
+}
+
+/* ---------------- Restaurar ---------------- */
+
+Checkpoint::Checkpoint(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Checkpoint: no se pudo abrir " + path);
+    size_ = static_cast<uint64_t>(in.tellg());
+    FileHeader header{};
+    in.seekg(0);
+    if (size_ < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " no es un checkpoint");
+    }
+    if (header.version != FILE_VERSION) {
+        throw std::runtime_error("Version de checkpoint no soportada (" + std::to_string(header.version) + ")");
+    }
+    if (header.file_bytes != size_ || !layout_matches(header)) {
+        throw std::runtime_error(path + ": checkpoint truncado o dañado");
+    }
+#ifdef CHECKPOINT_HAS_MMAP
+    // Privado y con escritura: la Memoria restaurada escribe sobre sus páginas sin tocar el archivo
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    void* data = fd >= 0 ? ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (fd >= 0) ::close(fd);
+    if (data != MAP_FAILED) {
+        data_ = static_cast<uint8_t*>(data);
+        mapped_ = true;
+    }
+#endif
+    if (!mapped_) {
+        buffer_.resize(size_);
+        in.seekg(0);
+        if (!in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size_))) {
+            throw std::runtime_error("Checkpoint: no se pudo leer " + path);
+        }
+        data_ = buffer_.data();
+    }
+    header_ = reinterpret_cast<const FileHeader*>(data_);
+
+    // save_checkpoint escribe las páginas en orden de dirección: crecientes y dentro de la Memoria
+    const auto* page_numbers = reinterpret_cast<const uint64_t*>(data_ + header_->page_index_offset);
+    for (uint64_t p = 0; p < header_->page_count; ++p) {
+        if (page_numbers[p] >= Memory::ADDRESS_LIMIT / Memory::PAGE_BYTES ||
+            (p > 0 && page_numbers[p] <= page_numbers[p - 1])) {
+#ifdef CHECKPOINT_HAS_MMAP
+            if (mapped_) ::munmap(data_, size_); // el destructor no corre si el constructor lanza
+#endif
+            throw std::runtime_error(path + ": checkpoint con paginas de Memoria invalidas");
+        }
+    }
+}
+
+Checkpoint::~Checkpoint() {
+#ifdef CHECKPOINT_HAS_MMAP
+    if (mapped_) ::munmap(data_, size_);
+#endif
+}
+
+void Checkpoint::restore(EventScheduler& scheduler, ProcessorSystem& system, std::vector<CacheL1*>& caches,
+                         Memory& memory, BusInterconnect& bus) {
+    if (restored_) throw std::logic_error("Checkpoint::restore: ya se restauro (usar un Checkpoint por corrida)");
+    const FileHeader& h = *header_;
+    if (h.pes != system.size() || caches.size() != system.size()) {
+        throw std::runtime_error("Checkpoint: se guardo con " + std::to_string(h.pes) + " PEs");
+    }
+    for (const CacheL1* cache : caches) {
+        if (cache->sets() != h.sets || cache->ways() != h.ways || cache->line_bytes() != h.line_bytes) {
+            throw std::runtime_error("Checkpoint: la geometria de las caches no coincide (" + std::to_string(h.sets) +
+                                     " sets x " + std::to_string(h.ways) + " vias x " +
+                                     std::to_string(h.line_bytes) + " B)");
+        }
+        if (static_cast<uint32_t>(cache->protocol()) != h.protocol) {
+            throw std::runtime_error("Checkpoint: el protocolo de coherencia no coincide");
+        }
+    }
+    const auto* pes = reinterpret_cast<const PEState*>(data_ + h.pe_offset);
+    for (size_t i = 0; i < system.size(); ++i) {
+        const ProcessingElement& pe = system.getPE(i);
+        if (pe.getProgramSize() != pes[i].program_size || pe.getProgramFingerprint() != pes[i].program_fingerprint) {
+            throw std::runtime_error("Checkpoint: el programa del PE " + std::to_string(i) + " no es el guardado");
+        }
+    }
+    if (memory.resident_pages() != 0) throw std::logic_error("Checkpoint::restore: la Memoria no esta vacia");
+    restored_ = true;
+
+    scheduler.advance_to(h.cycle);
+
+    const auto* page_numbers = reinterpret_cast<const uint64_t*>(data_ + h.page_index_offset);
+    for (uint64_t p = 0; p < h.page_count; ++p) {
+        memory.map_page(page_numbers[p], data_ + h.page_data_offset + p * Memory::PAGE_BYTES);
+    }
+
+    const uint64_t lines = static_cast<uint64_t>(h.sets) * h.ways;
+    const bool same_policy = std::strncmp(caches[0]->metrics().policy, h.replacement, sizeof(h.replacement)) == 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        const uint8_t* block = data_ + h.cache_offset + i * h.cache_bytes;
+        const auto* replacement = reinterpret_cast<const uint64_t*>(block + lines * sizeof(LineSnapshot));
+        caches[i]->restore_lines(reinterpret_cast<const LineSnapshot*>(block), same_policy ? replacement : nullptr,
+                                 block + lines * sizeof(LineSnapshot) + h.sets * sizeof(uint64_t));
+    }
+    bus.restore_arbitration(h.arbitration_pointer);
+
+    for (size_t i = 0; i < system.size(); ++i) {
+        ProcessingElement& pe = system.getPE(i);
+        std::array<uint64_t, REGISTERS> registers;
+        std::memcpy(registers.data(), pes[i].registers, sizeof(pes[i].registers));
+        std::array<VectorRegister, VREG_COUNT> vector_registers;
+        std::memcpy(vector_registers.data(), pes[i].vector_registers, sizeof(pes[i].vector_registers));
+        pe.restoreState(registers, vector_registers, static_cast<size_t>(pes[i].pc), h.cycle);
+        if (pes[i].paused) pe.resume(scheduler, pes[i].resume_cycle);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EventScheduler.h"
+#include "../components/cacheL1.h"
+#include "../components/memory.h"
+#include "../interconnect/BusInterconnect.h"
+#include "../PE/ProcessorSystem.hpp"
+
+/*
+ Checkpoint del sistema completo en un solo archivo versionado.
+ Se toma en un punto seguro: los PEs en pausa (ProcessingElement::pauseAt) o terminados,
+ sin eventos pendientes y con el Bus inactivo. Así no hay transacciones, colas ni
+ prefetches en vuelo que guardar: el estado es el de los PEs (registros escalares y
+ vectoriales, PC y ciclo de su próxima instrucción), cada línea de las L1 (tag, estado,
+ dirty, marca de prefetch, estado de reemplazo del set y datos), las páginas residentes
+ de la Memoria y el puntero del Round-Robin del Bus.
+ Formato: FileHeader, PEState por PE, el bloque de cada caché (LineSnapshot por vía,
+ una palabra de reemplazo por set y los datos) y las páginas de Memoria alineadas a
+ PAGE_BYTES. Al restaurar, el archivo se proyecta con mmap privado y sus páginas pasan a
+ ser la Memoria sin copiarse (el sistema las copia solo cuando se escriben).
+ No incluye la LLC ni los contadores: las métricas de una corrida restaurada cuentan
+ desde el checkpoint; la DRAM y los prefetchers empiezan sin historia.
+*/
+namespace checkpoint {
+
+constexpr char FILE_MAGIC[8] = {'M', 'E', 'S', 'I', 'C', 'K', 'P', '1'};
+constexpr uint32_t FILE_VERSION = 2; // 2: registros vectoriales en PEState
+constexpr unsigned REGISTERS = ProcessingElement::REG_COUNT;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pes;
+    uint64_t cycle;              // reloj del scheduler al guardar
+    uint32_t sets;               // geometría de las L1 (todas iguales)
+    uint32_t ways;
+    uint32_t line_bytes;
+    uint32_t protocol;           // CoherenceProtocol
+    char replacement[16];        // política de las L1 (su estado por set solo vale para ella)
+    int32_t arbitration_pointer; // último PE concedido por el Bus
+    uint32_t reserved;
+    uint64_t pe_offset;          // pes * PEState
+    uint64_t cache_offset;       // pes * cache_bytes
+    uint64_t cache_bytes;        // sets*ways LineSnapshot + sets palabras + sets*ways*line_bytes datos
+    uint64_t page_index_offset;  // page_count números de página
+    uint64_t page_count;
+    uint64_t page_data_offset;   // page_count * PAGE_BYTES, alineado a PAGE_BYTES
+    uint64_t file_bytes;
+};
+
+struct PEState {
+    uint64_t registers[REGISTERS];
+    double vector_registers[VREG_COUNT][VECTOR_LANES];
+    uint64_t pc;
+    uint64_t resume_cycle;        // ciclo de la próxima instrucción (si paused)
+    uint64_t program_size;
+    uint64_t program_fingerprint; // el programa cargado al restaurar debe ser el mismo
+    uint32_t paused;              // 0 = terminado (HALT o fin del programa)
+    uint32_t reserved;
+};
+
+} // namespace checkpoint
+
+// Guarda el estado en 'path'. Lanza std::logic_error si el sistema no está en un punto
+// seguro y std::runtime_error si no puede escribir el archivo.
+void save_checkpoint(const std::string& path, const EventScheduler& scheduler, const ProcessorSystem& system,
+                     const std::vector<CacheL1*>& caches, const Memory& memory, const BusInterconnect& bus);
+
+// Checkpoint abierto para restaurar una vez: sus páginas quedan en uso por la Memoria
+// restaurada, así que debe vivir más que ella (un Checkpoint por corrida).
+class Checkpoint {
+public:
+    // Lanza std::runtime_error si el archivo no existe, no es un checkpoint, está truncado o
+    // sus offsets y páginas no son los que escribe save_checkpoint
+    explicit Checkpoint(const std::string& path);
+    ~Checkpoint();
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    const checkpoint::FileHeader& header() const { return *header_; }
+    Cycle cycle() const { return header_->cycle; }
+    uint64_t file_bytes() const { return size_; }
+    bool mapped() const { return mapped_; }
+
+    // Instala el estado en un sistema recién construido con la misma configuración (PEs,
+    // geometría y protocolo de las L1, mismos programas ya cargados) y una Memoria vacía;
+    // adelanta el reloj y agenda la reanudación de los PEs en pausa. Si la política de
+    // reemplazo difiere, los sets vuelven a su estado inicial. Lanza std::runtime_error
+    // si la configuración no coincide y std::logic_error si ya se restauró.
+    void restore(EventScheduler& scheduler, ProcessorSystem& system, std::vector<CacheL1*>& caches,
+                 Memory& memory, BusInterconnect& bus);
+
+private:
+    uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+    bool mapped_ = false;         // false: copia en memoria (sin mmap)
+    std::vector<uint8_t> buffer_;
+    const checkpoint::FileHeader* header_ = nullptr;
+    bool restored_ = false;
+};
+
+#endif // CHECKPOINT_H
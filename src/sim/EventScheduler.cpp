@@ -0,0 +1,50 @@
+#include "EventScheduler.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "../utils/trace.h"
+
+EventScheduler::EventScheduler() {
+    trace::bind_clock(&now_);
+}
+
+EventScheduler::~EventScheduler() {
+    trace::unbind_clock(&now_);
+}
+
+void EventScheduler::schedule(Cycle delay, Action action) {
+    schedule_at(now_ + delay, std::move(action));
+}
+
+void EventScheduler::schedule_at(Cycle when, Action action) {
+    if (when < now_) {
+        throw std::invalid_argument("EventScheduler::schedule_at: evento en el pasado");
+    }
+    queue_.push_back(Event{when, next_seq_++, std::move(action)});
+    std::push_heap(queue_.begin(), queue_.end(), Later{});
+}
+
+void EventScheduler::advance_to(Cycle when) {
+    if (!queue_.empty() || when < now_) {
+        throw std::logic_error("EventScheduler::advance_to: hay eventos pendientes o el ciclo ya paso");
+    }
+    now_ = when;
+}
+
+bool EventScheduler::step() {
+    if (queue_.empty()) return false;
+    std::pop_heap(queue_.begin(), queue_.end(), Later{});
+    Event ev = std::move(queue_.back());
+    queue_.pop_back();
+
+    now_ = ev.when;
+    events_processed_++;
+    ev.action();
+    return true;
+}
+
+Cycle EventScheduler::run() {
+    stopped_ = false;
+    while (!stopped_ && step()) {}
+    return now_;
+}
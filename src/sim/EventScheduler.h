@@ -0,0 +1,69 @@
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Tiempo simulado, en ciclos del reloj global
+using Cycle = uint64_t;
+
+// Planificador de eventos discretos: reloj global + cola de prioridad de eventos temporizados.
+// Los eventos de un mismo ciclo se ejecutan en el orden en que fueron agendados,
+// por lo que una simulación es determinista y avanza tan rápido como el host pueda.
+class EventScheduler {
+public:
+    using Action = std::function<void()>;
+
+    // Enlaza el reloj como marca de tiempo de las trazas del hilo que lo crea
+    EventScheduler();
+    ~EventScheduler();
+    EventScheduler(const EventScheduler&) = delete;
+    EventScheduler& operator=(const EventScheduler&) = delete;
+
+    Cycle now() const { return now_; }
+
+    // Adelanta el reloj sin eventos pendientes (restauración de un checkpoint);
+    // lanza std::logic_error si la cola no está vacía o el ciclo es anterior a now()
+    void advance_to(Cycle when);
+
+    // Agenda 'action' para dentro de 'delay' ciclos (0 = más tarde en el ciclo actual)
+    void schedule(Cycle delay, Action action);
+
+    // Agenda 'action' en el ciclo absoluto 'when' (debe ser >= now())
+    void schedule_at(Cycle when, Action action);
+
+    // Ejecuta el siguiente evento; false si la cola estaba vacía
+    bool step();
+
+    // Ejecuta eventos hasta vaciar la cola o hasta stop(); retorna el ciclo final
+    Cycle run();
+
+    void stop() { stopped_ = true; }
+
+    bool empty() const { return queue_.empty(); }
+    size_t pending() const { return queue_.size(); }
+    uint64_t events_processed() const { return events_processed_; }
+
+private:
+    struct Event {
+        Cycle when;
+        uint64_t seq; // desempate FIFO dentro del mismo ciclo
+        Action action;
+    };
+
+    // Comparador para un min-heap sobre (when, seq)
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.when != b.when ? a.when > b.when : a.seq > b.seq;
+        }
+    };
+
+    std::vector<Event> queue_; // heap administrado con std::push_heap/pop_heap
+    Cycle now_ = 0;
+    uint64_t next_seq_ = 0;
+    uint64_t events_processed_ = 0;
+    bool stopped_ = false;
+};
+
+#endif // EVENT_SCHEDULER_H
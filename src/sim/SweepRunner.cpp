@@ -0,0 +1,50 @@
+#include "SweepRunner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <thread>
+
+SweepRunner::SweepRunner(unsigned threads) : threads_(threads) {
+    if (threads_ == 0) threads_ = std::max(1u, std::thread::hardware_concurrency());
+}
+
+void SweepRunner::add(const std::string& name, Job job) {
+    jobs_.push_back(Entry{name, std::move(job)});
+}
+
+std::vector<SweepRunner::Result> SweepRunner::run() {
+    std::vector<Result> results;
+    results.reserve(jobs_.size());
+    for (const Entry& entry : jobs_) results.push_back(Result{MetricsRegistry(entry.name), {}, {}, 0.0});
+
+    // Cada hilo escribe solo en el Result del índice que tomó
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < jobs_.size(); i = next.fetch_add(1)) {
+            Result& result = results[i];
+            std::ostringstream log;
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                jobs_[i].job(result.metrics, log);
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            } catch (...) {
+                result.error = "excepcion desconocida";
+            }
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.log = log.str();
+        }
+    };
+
+    const size_t count = std::min<size_t>(threads_, jobs_.size());
+    std::vector<std::thread> pool;
+    pool.reserve(count > 0 ? count - 1 : 0);
+    for (size_t t = 1; t < count; ++t) pool.emplace_back(worker);
+    worker(); // el hilo llamador también toma trabajos
+    for (std::thread& thread : pool) thread.join();
+
+    jobs_.clear();
+    return results;
+}
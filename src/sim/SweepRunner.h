@@ -0,0 +1,54 @@
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../utils/metricsRegistry.h"
+
+/*
+ Barrido de parámetros (--sweep): corre muchas simulaciones independientes repartidas en
+ un pool de hilos del host. Cada trabajo construye su propio sistema completo (Memoria,
+ cachés, Bus, PEs, EventScheduler) y no comparte estado mutable con los demás: escribe su
+ salida en un ostream propio y sus métricas en un MetricsRegistry propio. Los hilos toman
+ el siguiente trabajo de un índice atómico, así que las corridas largas no dejan hilos
+ ociosos esperando a un reparto fijo.
+ Los resultados se devuelven en el orden en que se agregaron los trabajos, sin importar
+ en qué orden terminaron: la salida no depende de la cantidad de hilos.
+*/
+class SweepRunner {
+public:
+    using Job = std::function<void(MetricsRegistry& metrics, std::ostream& log)>;
+
+    struct Result {
+        MetricsRegistry metrics;
+        std::string log;      // todo lo que el trabajo escribió en su ostream
+        std::string error;    // what() de la excepción que lo abortó; vacío si terminó bien
+        double seconds = 0.0; // tiempo de host de la corrida
+        bool ok() const { return error.empty(); }
+    };
+
+    // threads == 0 usa std::thread::hardware_concurrency()
+    explicit SweepRunner(unsigned threads = 0);
+
+    // 'name' es el nombre de la corrida en las métricas exportadas
+    void add(const std::string& name, Job job);
+    size_t size() const { return jobs_.size(); }
+    unsigned threads() const { return threads_; }
+
+    // Corre todos los trabajos y vacía la lista; una excepción en un trabajo queda en su
+    // Result y no detiene a los demás
+    std::vector<Result> run();
+
+private:
+    struct Entry {
+        std::string name;
+        Job job;
+    };
+
+    unsigned threads_;
+    std::vector<Entry> jobs_;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "TraceReplay.h"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../components/memory.h"
+
+TraceReplay::TraceReplay(const AccessTraceReader& reader, std::vector<SharedMemory*> memories,
+                         EventScheduler& scheduler, unsigned line_bytes)
+    : scheduler_(scheduler), line_bytes_(line_bytes) {
+    if (memories.size() != reader.cores()) {
+        throw std::invalid_argument("TraceReplay: se necesita una SharedMemory por core de la traza");
+    }
+    if (line_bytes_ < Memory::WORD_BYTES) throw std::invalid_argument("TraceReplay: line_bytes menor que una palabra");
+    cores_.reserve(memories.size());
+    for (unsigned i = 0; i < memories.size(); ++i) {
+        cores_.push_back(Core{i, reader.cursor(i), memories[i], {}, 0, 0, false, {}});
+    }
+}
+
+void TraceReplay::start() {
+    for (Core& core : cores_) {
+        scheduler_.schedule(0, [this, &core] { advance(core); });
+    }
+}
+
+void TraceReplay::advance(Core& core) {
+    if (!core.active) {
+        if (!core.cursor.next(core.record)) {
+            core.stats.finish_cycle = scheduler_.now();
+            return;
+        }
+        const uint64_t size = core.record.size ? core.record.size : 1;
+        if (core.record.address >= Memory::ADDRESS_LIMIT || size > Memory::ADDRESS_LIMIT - core.record.address) {
+            // Sale del scheduler hasta main, que lo informa como error
+            std::ostringstream message;
+            message << "TraceReplay: el registro " << core.stats.records + 1 << " del core " << core.id
+                    << " accede a 0x" << std::hex << core.record.address << std::dec << " (" << size
+                    << " B), fuera del espacio de direcciones de " << Memory::ADDRESS_BITS << " bits";
+            throw std::out_of_range(message.str());
+        }
+        core.stats.records++;
+        core.next_line = core.record.address / line_bytes_;
+        core.last_line = (core.record.address + size - 1) / line_bytes_;
+        core.active = true;
+        if (core.record.gap) {
+            // Cómputo entre accesos: el acceso se emite 'gap' ciclos después
+            scheduler_.schedule(core.record.gap, [this, &core] { advance(core); });
+            return;
+        }
+    }
+
+    // Palabra alineada dentro de la línea: el inicio del registro o el de la línea siguiente
+    const uint64_t line_start = core.next_line * line_bytes_;
+    const uint64_t address = (core.record.address > line_start ? core.record.address : line_start) &
+                             ~static_cast<uint64_t>(Memory::WORD_BYTES - 1);
+    core.active = core.next_line++ != core.last_line;
+    core.stats.accesses++;
+    MemRequestHandle req;
+    if (core.record.write) {
+        core.stats.stores++;
+        req = core.memory->issueStore(address, core.record.address, 0);
+    } else {
+        core.stats.loads++;
+        req = core.memory->issueLoad(address, 0);
+    }
+
+    if (req->done) {
+        // Acierto local: 1 ciclo, como en un PE
+        core.stats.latency.record(req->latency());
+        scheduler_.schedule(1, [this, &core] { advance(core); });
+        return;
+    }
+    req->onComplete = [this, &core](MemRequest& done) {
+        core.stats.latency.record(done.latency());
+        core.stats.stall_cycles += done.latency();
+        scheduler_.schedule(0, [this, &core] { advance(core); });
+    };
+}
+
+uint64_t TraceReplay::records() const {
+    uint64_t total = 0;
+    for (const Core& core : cores_) total += core.stats.records;
+    return total;
+}
+
+uint64_t TraceReplay::accesses() const {
+    uint64_t total = 0;
+    for (const Core& core : cores_) total += core.stats.accesses;
+    return total;
+}
+
+void TraceReplay::print_stats() const {
+    for (const Core& core : cores_) {
+        const CoreStats& s = core.stats;
+        std::cout << "[Core " << core.id << "] Registros: " << s.records << " Accesos: " << s.accesses
+                  << " (loads " << s.loads << ", stores " << s.stores << ")"
+                  << " Fin: ciclo " << s.finish_cycle
+                  << " Latencia promedio: " << s.latency.mean() << " ciclos (p99 <= " << s.latency.percentile(99)
+                  << ")\n";
+    }
+}
+
+void TraceReplay::export_metrics(MetricsRegistry& registry) const {
+    for (const Core& core : cores_) {
+        const CoreStats& s = core.stats;
+        const std::string name = "core" + std::to_string(core.id);
+        registry.counter(name, "records", s.records);
+        registry.counter(name, "accesses", s.accesses);
+        registry.counter(name, "loads", s.loads);
+        registry.counter(name, "stores", s.stores);
+        registry.counter(name, "stall_cycles", s.stall_cycles);
+        registry.counter(name, "finish_cycle", s.finish_cycle);
+        registry.histogram(name, "latency", s.latency);
+    }
+}
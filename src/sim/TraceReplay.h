@@ -0,0 +1,74 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <cstdint>
+#include <vector>
+#include "EventScheduler.h"
+#include "../PE/SharedMemory.hpp"
+#include "../utils/accessTrace.h"
+#include "../utils/histogram.h"
+#include "../utils/metricsRegistry.h"
+
+/*
+ Frontend de trazas: en lugar de PEs ejecutando programas, cada core de una traza de
+ accesos emite sus loads y stores sobre su SharedMemory (la MemoryFacade de su caché).
+ Como un PE, un core emite un acceso y espera a que se complete: un acierto local cuesta
+ 1 ciclo y un acceso por el Bus reanuda al core en el ciclo en que se entrega. El gap del
+ registro son ciclos de cómputo que se suman antes de emitirlo.
+ Un acceso que cruza líneas se emite como un acceso de palabra (8 bytes alineados) por
+ línea tocada. Los registros se leen del cursor de cada core a medida que se necesitan:
+ la memoria usada no depende del largo de la traza.
+*/
+class TraceReplay {
+public:
+    struct CoreStats {
+        uint64_t records = 0;     // registros de la traza consumidos
+        uint64_t accesses = 0;    // accesos de palabra emitidos (>= records si hay cruces de línea)
+        uint64_t loads = 0;
+        uint64_t stores = 0;
+        Cycle stall_cycles = 0;   // espera por accesos que pasaron por el Bus
+        Cycle finish_cycle = 0;
+        LatencyHistogram latency; // emisión -> entrega de cada acceso
+    };
+
+    // memories[i] atiende al core i (memories.size() debe ser reader.cores()); line_bytes es
+    // el tamaño de línea de las cachés. Lanza std::invalid_argument si no coinciden.
+    TraceReplay(const AccessTraceReader& reader, std::vector<SharedMemory*> memories,
+                EventScheduler& scheduler, unsigned line_bytes);
+    TraceReplay(const TraceReplay&) = delete;
+    TraceReplay& operator=(const TraceReplay&) = delete;
+
+    // Agenda el primer acceso de cada core; la simulación avanza con scheduler.run().
+    // Lanza std::out_of_range (durante run) si un registro sale del espacio de direcciones.
+    void start();
+
+    unsigned cores() const { return static_cast<unsigned>(cores_.size()); }
+    const CoreStats& core_stats(unsigned core) const { return cores_[core].stats; }
+    uint64_t records() const;
+    uint64_t accesses() const;
+
+    void print_stats() const;
+    // Contadores e histogramas de cada core como "core<i>"
+    void export_metrics(MetricsRegistry& registry) const;
+
+private:
+    struct Core {
+        unsigned id;
+        AccessTraceReader::Cursor cursor;
+        SharedMemory* memory;
+        AccessRecord record{};
+        uint64_t next_line = 0;  // próxima línea del registro actual por emitir
+        uint64_t last_line = 0;
+        bool active = false;     // hay un registro con líneas pendientes
+        CoreStats stats;
+    };
+
+    EventScheduler& scheduler_;
+    unsigned line_bytes_;
+    std::vector<Core> cores_;
+
+    // Emite el siguiente acceso del core (leyendo otro registro si hace falta)
+    void advance(Core& core);
+};
+
+#endif // TRACE_REPLAY_H
@@ -0,0 +1,227 @@
+// Herramienta de trazas de accesos para ./MESI_simulator --replay
+// Uso:
+//   ./access_trace gen archivo [cores] [accesos por core] [stream|shared|random] [gap]
+//       genera una traza sintética: 'stream' recorre una región propia por core, 'shared'
+//       lee y escribe un arreglo compartido (tráfico de coherencia), 'random' accede al azar
+//       a 16 MB; gap son los ciclos de cómputo entre accesos (0 por defecto)
+//   ./access_trace text entrada.txt archivo
+//       convierte líneas "core R|W dirección tamaño [gap]" (dirección decimal o 0x..., '#' comenta)
+//   ./access_trace dump archivo [max registros por core] [--stream]
+//       imprime la cabecera y los registros de cada core como texto
+//   ./access_trace exec captura.exec archivo
+//       convierte una traza de ejecución (./MESI_simulator --capture) en una traza de accesos;
+//       el gap de cada registro reproduce los ciclos de cómputo entre accesos del PE
+//   ./access_trace dump-exec captura.exec [max registros por PE]
+//       imprime los registros de una traza de ejecución
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../utils/accessTrace.h"
+#include "../utils/execTrace.h"
+
+namespace {
+
+int usage(const char* program) {
+    std::cerr << "Uso: " << program << " gen archivo [cores] [accesos] [stream|shared|random] [gap]\n"
+              << "     " << program << " text entrada.txt archivo\n"
+              << "     " << program << " dump archivo [max] [--stream]\n"
+              << "     " << program << " exec captura.exec archivo\n"
+              << "     " << program << " dump-exec captura.exec [max]\n";
+    return 1;
+}
+
+int generate(int argc, char* argv[]) {
+    const std::string path = argv[2];
+    const unsigned cores = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 4;
+    const uint64_t accesses = argc > 4 ? std::stoull(argv[4]) : 100000;
+    const std::string pattern = argc > 5 ? argv[5] : "stream";
+    const uint32_t gap = argc > 6 ? static_cast<uint32_t>(std::stoul(argv[6])) : 0;
+    if (pattern != "stream" && pattern != "shared" && pattern != "random") {
+        std::cerr << "Patron desconocido: " << pattern << "\n";
+        return 1;
+    }
+
+    AccessTraceWriter writer(path, cores);
+    std::mt19937_64 rng(1);
+    constexpr uint64_t REGION_BYTES = 1ULL << 24; // 16 MB por core (stream) o en total (random)
+    constexpr uint64_t SHARED_WORDS = 512;        // 4 KB compartidos
+    // Intercalados por ronda, como los produciría un capturador con varios cores
+    for (uint64_t i = 0; i < accesses; ++i) {
+        for (unsigned core = 0; core < cores; ++core) {
+            AccessRecord record{};
+            record.core = static_cast<uint8_t>(core);
+            record.size = 8;
+            record.gap = gap;
+            if (pattern == "stream") {
+                record.address = core * REGION_BYTES + (i * 8) % REGION_BYTES;
+                record.write = (i % 4) == 3;
+            } else if (pattern == "shared") {
+                record.address = (rng() % SHARED_WORDS) * 8;
+                record.write = rng() % 10 < 3;
+            } else {
+                record.address = (rng() % (REGION_BYTES / 8)) * 8;
+                record.write = rng() % 4 == 0;
+            }
+            writer.append(record);
+        }
+    }
+    writer.close();
+    std::cout << "Traza " << path << ": " << cores << " cores, " << writer.records() << " registros\n";
+    return 0;
+}
+
+int convert_text(const std::string& input, const std::string& path) {
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "No se pudo abrir " << input << "\n";
+        return 1;
+    }
+    // Las trazas de texto son chicas (escritas a mano): se leen completas porque la
+    // cabecera necesita la cantidad de cores antes del primer bloque
+    unsigned cores = 0;
+    std::string line;
+    std::vector<AccessRecord> records;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        unsigned core;
+        std::string op, address, size;
+        if (!(fields >> core)) continue; // línea vacía
+        uint32_t gap = 0;
+        if (!(fields >> op >> address >> size) || (op != "R" && op != "W") || core >= access_trace::MAX_CORES) {
+            std::cerr << input << ":" << number << ": se esperaba \"core R|W direccion tamano [gap]\"\n";
+            return 1;
+        }
+        fields >> gap;
+        AccessRecord record{};
+        record.core = static_cast<uint8_t>(core);
+        record.write = op == "W";
+        record.address = std::stoull(address, nullptr, 0);
+        record.size = static_cast<uint16_t>(std::stoul(size, nullptr, 0));
+        record.gap = gap;
+        records.push_back(record);
+        if (core + 1 > cores) cores = core + 1;
+    }
+    if (!cores) {
+        std::cerr << input << ": sin registros\n";
+        return 1;
+    }
+    AccessTraceWriter writer(path, cores);
+    for (const AccessRecord& record : records) writer.append(record);
+    writer.close();
+    std::cout << "Traza " << path << ": " << cores << " cores, " << writer.records() << " registros\n";
+    return 0;
+}
+
+int dump(const std::string& path, uint64_t max, bool stream) {
+    AccessTraceReader reader(path, stream ? AccessTraceReader::Mode::STREAM : AccessTraceReader::Mode::MMAP);
+    std::cout << path << ": " << reader.cores() << " cores, " << reader.records() << " registros, "
+              << reader.file_bytes() << " bytes ("
+              << (reader.mode() == AccessTraceReader::Mode::MMAP ? "mmap" : "stream") << ")\n";
+    for (unsigned core = 0; core < reader.cores(); ++core) {
+        AccessTraceReader::Cursor cursor = reader.cursor(core);
+        AccessRecord record{};
+        uint64_t count = 0;
+        while (cursor.next(record)) {
+            if (count++ < max) {
+                std::cout << core << " " << (record.write ? "W" : "R") << " 0x" << std::hex << record.address
+                          << std::dec << " " << record.size << " " << record.gap << "\n";
+            }
+        }
+        std::cout << "# core " << core << ": " << count << " registros\n";
+    }
+    return 0;
+}
+
+int convert_exec(const std::string& input, const std::string& path) {
+    ExecTraceReader reader(input);
+    std::vector<ExecTraceReader::Cursor> cursors;
+    std::vector<ExecRecord> heads(reader.pes());
+    std::vector<bool> live(reader.pes());
+    std::vector<uint64_t> resume(reader.pes(), 0); // ciclo en que el PE quedó libre para seguir
+    for (unsigned pe = 0; pe < reader.pes(); ++pe) {
+        cursors.push_back(reader.cursor(pe));
+        live[pe] = cursors[pe].next(heads[pe]);
+    }
+
+    // Se escriben en orden de emisión (sequence) para que los bloques queden intercalados
+    // como en la ejecución original
+    AccessTraceWriter writer(path, reader.pes());
+    for (;;) {
+        unsigned pe = reader.pes();
+        for (unsigned i = 0; i < reader.pes(); ++i) {
+            if (live[i] && (pe == reader.pes() || heads[i].sequence < heads[pe].sequence)) pe = i;
+        }
+        if (pe == reader.pes()) break;
+        const ExecRecord& exec = heads[pe];
+        // Un acierto ocupa 1 ciclo; un fallo reanuda al PE en el ciclo de entrega
+        const uint64_t gap = exec.cycle > resume[pe] ? exec.cycle - resume[pe] : 0;
+        resume[pe] = exec.cycle + (exec.latency ? exec.latency : 1);
+        AccessRecord record{};
+        record.address = exec.address;
+        record.gap = static_cast<uint32_t>(std::min<uint64_t>(gap, UINT32_MAX));
+        record.size = 8;
+        record.core = static_cast<uint8_t>(pe);
+        record.write = exec.write;
+        writer.append(record);
+        live[pe] = cursors[pe].next(heads[pe]);
+    }
+    writer.close();
+    std::cout << "Traza " << path << ": " << reader.pes() << " cores, " << writer.records() << " registros\n";
+    return 0;
+}
+
+int dump_exec(const std::string& path, uint64_t max) {
+    ExecTraceReader reader(path);
+    std::cout << path << ": " << reader.pes() << " PEs, " << reader.records() << " registros, "
+              << reader.file_bytes() << " bytes (" << reader.encoded_bytes() << " de registros codificados)\n";
+    std::cout << "# pe secuencia ciclo R|W direccion dato instruccion latencia\n";
+    for (unsigned pe = 0; pe < reader.pes(); ++pe) {
+        ExecTraceReader::Cursor cursor = reader.cursor(pe);
+        ExecRecord record{};
+        uint64_t count = 0;
+        while (cursor.next(record)) {
+            if (count++ < max) {
+                std::cout << pe << " " << record.sequence << " " << record.cycle << " "
+                          << (record.write ? "W" : "R") << " 0x" << std::hex << record.address << std::dec
+                          << " " << record.value << " " << record.pc << " " << record.latency << "\n";
+            }
+        }
+        std::cout << "# PE " << pe << ": " << count << " registros\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return usage(argv[0]);
+    const std::string command = argv[1];
+    try {
+        if (command == "gen") return generate(argc, argv);
+        if (command == "text" && argc >= 4) return convert_text(argv[2], argv[3]);
+        if (command == "exec" && argc >= 4) return convert_exec(argv[2], argv[3]);
+        if (command == "dump-exec") return dump_exec(argv[2], argc > 3 ? std::stoull(argv[3]) : ~0ULL);
+        if (command == "dump") {
+            uint64_t max = ~0ULL;
+            bool stream = false;
+            for (int i = 3; i < argc; ++i) {
+                if (std::string(argv[i]) == "--stream") stream = true;
+                else max = std::stoull(argv[i]);
+            }
+            return dump(argv[2], max, stream);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return usage(argv[0]);
+}
@@ -0,0 +1,129 @@
+// Microbenchmark de búsqueda de tags de la caché L1 (make bench)
+// Uso: ./cache_bench [busquedas por configuracion]
+// Compara, para 2 a 16 vías y 64 a 4096 sets, el costo por búsqueda de:
+//   aos    arreglo de CacheLine recorrido vía por vía (disposición anterior)
+//   soa    TagStore::find (huellas de 8 bits por set comparadas con SIMD, luego el tag)
+//   cache  CacheL1::get_line_state completo (decodificación + TagStore), como un snoop
+// La mitad de las búsquedas acierta. La columna simd indica el camino compilado.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../components/cacheL1.h"
+#include "../components/memory.h"
+#include "../components/tagStore.h"
+
+namespace {
+
+struct Probe {
+    uint64_t set;
+    uint64_t tag;
+};
+
+// Referencia: la búsqueda lineal sobre líneas AoS que usaba BasicCacheL1
+int find_aos(const std::vector<CacheLine>& lines, unsigned ways, uint64_t set, uint64_t tag) {
+    const CacheLine* row = &lines[set * ways];
+    for (unsigned w = 0; w < ways; ++w) {
+        if (row[w].valid && row[w].tag == tag) return static_cast<int>(w);
+    }
+    return -1;
+}
+
+// Mejor de REPEATS corridas, para filtrar el ruido de la máquina
+constexpr int REPEATS = 5;
+
+template <class F>
+double ns_per_probe(size_t probes, F&& body) {
+    double best = 0.0;
+    for (int r = 0; r < REPEATS; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(probes);
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+const char* simd_path() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t probes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    const unsigned line_bytes = 32;
+    std::mt19937_64 rng(42);
+    volatile int64_t sink = 0;
+
+    std::cout << "Busquedas por configuracion: " << probes << " (simd: " << simd_path() << ")\n";
+    std::cout << std::setw(6) << "ways" << std::setw(7) << "sets"
+              << std::setw(12) << "aos ns" << std::setw(12) << "soa ns" << std::setw(12) << "cache ns" << "\n";
+
+    for (unsigned ways : {2u, 4u, 8u, 16u}) {
+        for (unsigned sets : {64u, 1024u, 4096u}) {
+            // Todas las vías válidas con tags distintos; cada búsqueda acierta o falla al 50%
+            std::vector<CacheLine> aos(static_cast<size_t>(sets) * ways);
+            TagStore soa(sets, ways);
+            for (unsigned s = 0; s < sets; ++s) {
+                for (unsigned w = 0; w < ways; ++w) {
+                    CacheLine& line = aos[static_cast<size_t>(s) * ways + w];
+                    line.valid = true;
+                    line.tag = w;
+                    line.state = MESI_State::SHARED;
+                    soa.fill(s, w, w, MESI_State::SHARED);
+                }
+            }
+            std::vector<Probe> stream(probes);
+            for (Probe& p : stream) {
+                p.set = rng() % sets;
+                p.tag = rng() % (2 * ways);
+            }
+
+            const double aos_ns = ns_per_probe(probes, [&] {
+                int64_t acc = 0;
+                for (const Probe& p : stream) acc += find_aos(aos, ways, p.set, p.tag);
+                sink = sink + acc;
+            });
+            const double soa_ns = ns_per_probe(probes, [&] {
+                int64_t acc = 0;
+                for (const Probe& p : stream) acc += soa.find(p.set, p.tag);
+                sink = sink + acc;
+            });
+
+            // Caché completa llena con los tags 0..ways-1 de cada set
+            Memory memory;
+            CacheConfig config;
+            config.sets = sets;
+            config.ways = ways;
+            config.line_bytes = line_bytes;
+            std::unique_ptr<CacheL1> cache = make_cache_l1(0, &memory, config);
+            for (unsigned t = 0; t < ways; ++t) {
+                for (unsigned s = 0; s < sets; ++s) cache->read((static_cast<uint64_t>(t) * sets + s) * line_bytes);
+            }
+            std::vector<uint64_t> addresses(probes);
+            for (size_t i = 0; i < probes; ++i) {
+                addresses[i] = (stream[i].tag * sets + stream[i].set) * line_bytes;
+            }
+            const double cache_ns = ns_per_probe(probes, [&] {
+                int64_t acc = 0;
+                for (uint64_t a : addresses) acc += static_cast<int>(cache->get_line_state(a));
+                sink = sink + acc;
+            });
+
+            std::cout << std::fixed << std::setprecision(2)
+                      << std::setw(6) << ways << std::setw(7) << sets
+                      << std::setw(12) << aos_ns << std::setw(12) << soa_ns << std::setw(12) << cache_ns << "\n";
+        }
+    }
+    return 0;
+}
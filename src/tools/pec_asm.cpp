@@ -0,0 +1,35 @@
+// Ensamblador de programas .pec a imágenes binarias .pecb (ver PE/ProgramImage.hpp)
+// Uso: ./pec_asm programa.pec [otro.pec ...]
+//   Escribe programa.pecb junto a cada fuente; el simulador la usa en lugar del .pec
+//   mientras no sea más vieja que él.
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "../PE/ProcessingElement.hpp"
+#include "../PE/ProgramImage.hpp"
+#include "../PE/ProgramLoader.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " programa.pec [otro.pec ...]\n";
+        return 1;
+    }
+    int failures = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string source = argv[i];
+        const std::string image_path = source + "b";
+        try {
+            writeProgramImage(loadProgramFile(source), ProcessingElement::REG_COUNT, image_path);
+            // Releer la imagen: valida lo mismo que validará el simulador al cargarla
+            const ProgramImage image(image_path, ProcessingElement::REG_COUNT);
+            std::cout << source << " -> " << image_path << ": " << image.size() << " instrucciones, checksum 0x"
+                      << std::hex << std::setw(16) << std::setfill('0') << image.checksum() << std::dec
+                      << std::setfill(' ') << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << source << ": " << e.what() << "\n";
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
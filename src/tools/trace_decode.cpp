@@ -0,0 +1,63 @@
+// Decodificador de trazas binarias del simulador (./MESI_simulator --trace archivo)
+// Uso: ./trace_decode archivo [--cycles]
+//   --cycles  antepone a cada evento el ciclo simulado en que ocurrió
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../utils/trace.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " archivo.trace [--cycles]\n";
+        return 1;
+    }
+    bool show_cycles = argc > 2 && std::string(argv[2]) == "--cycles";
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "No se pudo abrir " << argv[1] << "\n";
+        return 1;
+    }
+    trace::FileHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, trace::FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << argv[1] << " no es un archivo de trazas\n";
+        return 1;
+    }
+    if (header.version != trace::FILE_VERSION || header.record_bytes != sizeof(TraceRecord)) {
+        std::cerr << "Version de trazas no soportada (" << header.version << ")\n";
+        return 1;
+    }
+
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    uint16_t max_thread = 0;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        max_thread = std::max(max_thread, record.thread);
+        records.push_back(record);
+    }
+    // Con varios hilos los buffers se vuelcan por bloques: se reordena por ciclo
+    // (estable, así cada hilo conserva su orden)
+    if (max_thread > 0) {
+        std::stable_sort(records.begin(), records.end(),
+                         [](const TraceRecord& a, const TraceRecord& b) { return a.cycle < b.cycle; });
+    }
+
+    for (const TraceRecord& r : records) {
+        if (!show_cycles) {
+            trace::format_record(r, std::cout);
+            continue;
+        }
+        std::ostringstream text;
+        trace::format_record(r, text);
+        std::string line = text.str();
+        size_t start = line.find_first_not_of('\n'); // líneas en blanco separadoras antes del prefijo
+        if (start == std::string::npos) start = line.size();
+        std::cout << line.substr(0, start) << "[" << r.cycle << "] " << line.substr(start);
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/*
+ Cola circular lock-free de un productor y un consumidor (SPSC).
+ - Capacity debe ser potencia de dos (el índice se obtiene con una máscara).
+ - head_ solo lo escribe el consumidor y tail_ solo el productor; cada uno
+   vive en su propia línea de caché para no compartirla entre hilos.
+ - try_push/try_pop nunca bloquean: devuelven false/nullopt si la cola está llena/vacía.
+*/
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing: Capacity debe ser potencia de dos");
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    ~SpscRing() {
+        while (try_pop()) {}
+    }
+
+    // Solo el productor
+    bool try_push(T value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        new (slot(tail)) T(std::move(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Solo el consumidor
+    std::optional<T> try_pop() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return std::nullopt;
+        T* item = slot(head);
+        std::optional<T> value(std::move(*item));
+        item->~T();
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Solo el consumidor: elemento más antiguo sin extraerlo (nullptr si está vacía)
+    T* front() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+        return slot(head);
+    }
+
+    // Aproximado si el otro extremo está activo; exacto desde un solo hilo
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    T* slot(size_t pos) { return std::launder(reinterpret_cast<T*>(&storage_[pos & (Capacity - 1)])); }
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0}; // próximo a consumir
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0}; // próximo libre
+    alignas(CACHE_LINE) std::aligned_storage_t<sizeof(T), alignof(T)> storage_[Capacity];
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,168 @@
+#include "accessTrace.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ACCESS_TRACE_HAS_MMAP 1
+#endif
+
+using namespace access_trace;
+
+/* ---------------- Writer ---------------- */
+
+AccessTraceWriter::AccessTraceWriter(const std::string& path, unsigned cores) : cores_(cores) {
+    if (cores == 0 || cores > MAX_CORES) {
+        throw std::invalid_argument("AccessTraceWriter: cores fuera de rango (1.." + std::to_string(MAX_CORES) + ")");
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) throw std::runtime_error("AccessTraceWriter: no se pudo crear " + path);
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.record_bytes = sizeof(AccessRecord);
+    header.cores = cores;
+    std::fwrite(&header, sizeof(header), 1, file_);
+    pending_.resize(cores);
+    for (auto& chunk : pending_) chunk.reserve(CHUNK_RECORDS);
+}
+
+AccessTraceWriter::~AccessTraceWriter() {
+    close();
+}
+
+void AccessTraceWriter::append(const AccessRecord& record) {
+    if (record.core >= cores_) throw std::out_of_range("AccessTraceWriter: core fuera de rango");
+    std::vector<AccessRecord>& chunk = pending_[record.core];
+    chunk.push_back(record);
+    records_++;
+    if (chunk.size() == CHUNK_RECORDS) flush_chunk(record.core);
+}
+
+void AccessTraceWriter::flush_chunk(unsigned core) {
+    std::vector<AccessRecord>& chunk = pending_[core];
+    if (chunk.empty()) return;
+    const ChunkHeader header{core, static_cast<uint32_t>(chunk.size())};
+    std::fwrite(&header, sizeof(header), 1, file_);
+    std::fwrite(chunk.data(), sizeof(AccessRecord), chunk.size(), file_);
+    chunk.clear();
+}
+
+void AccessTraceWriter::close() {
+    if (!file_) return;
+    for (unsigned core = 0; core < cores_; ++core) flush_chunk(core);
+    // Total de registros en la cabecera
+    std::fseek(file_, static_cast<long>(offsetof(FileHeader, records)), SEEK_SET);
+    std::fwrite(&records_, sizeof(records_), 1, file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+/* ---------------- Reader ---------------- */
+
+AccessTraceReader::AccessTraceReader(const std::string& path, Mode mode) : path_(path), mode_(mode) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("AccessTraceReader: no se pudo abrir " + path);
+    size_ = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    if (size_ < sizeof(header_) || !in.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, FILE_MAGIC, sizeof(header_.magic)) != 0) {
+        throw std::runtime_error(path + " no es una traza de accesos");
+    }
+    if (header_.version != FILE_VERSION || header_.record_bytes != sizeof(AccessRecord)) {
+        throw std::runtime_error("Version de traza de accesos no soportada (" + std::to_string(header_.version) + ")");
+    }
+    if (header_.cores == 0 || header_.cores > MAX_CORES) {
+        throw std::runtime_error(path + ": cantidad de cores invalida");
+    }
+#ifdef ACCESS_TRACE_HAS_MMAP
+    if (mode_ == Mode::MMAP) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        void* data = fd >= 0 ? ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (fd >= 0) ::close(fd); // la proyección sigue válida sin el descriptor
+        if (data != MAP_FAILED) {
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            mapped_ = static_cast<const uint8_t*>(data);
+        } else {
+            mode_ = Mode::STREAM;
+        }
+    }
+#else
+    mode_ = Mode::STREAM;
+#endif
+}
+
+AccessTraceReader::~AccessTraceReader() {
+#ifdef ACCESS_TRACE_HAS_MMAP
+    if (mapped_) ::munmap(const_cast<uint8_t*>(mapped_), size_);
+#endif
+}
+
+AccessTraceReader::Cursor AccessTraceReader::cursor(unsigned core) const {
+    if (core >= header_.cores) throw std::out_of_range("AccessTraceReader: core fuera de rango");
+    return Cursor(*this, core);
+}
+
+AccessTraceReader::Cursor::Cursor(const AccessTraceReader& reader, unsigned core)
+    : reader_(&reader), core_(core), chunk_offset_(sizeof(FileHeader)) {
+    if (reader.mode_ == Mode::STREAM) {
+        stream_ = std::make_unique<std::ifstream>(reader.path_, std::ios::binary);
+        if (!*stream_) throw std::runtime_error("AccessTraceReader: no se pudo abrir " + reader.path_);
+        buffer_.resize(STREAM_BUFFER_RECORDS);
+    }
+}
+
+void AccessTraceReader::Cursor::read_at(uint64_t offset, void* out, size_t bytes) {
+    if (offset + bytes > reader_->size_) throw std::runtime_error("Traza de accesos truncada");
+    if (reader_->mapped_) {
+        std::memcpy(out, reader_->mapped_ + offset, bytes);
+        return;
+    }
+    stream_->seekg(static_cast<std::streamoff>(offset));
+    if (!stream_->read(static_cast<char*>(out), static_cast<std::streamsize>(bytes))) {
+        throw std::runtime_error("Traza de accesos truncada");
+    }
+}
+
+bool AccessTraceReader::Cursor::next_chunk() {
+    // Salta los bloques de otros cores leyendo solo sus cabeceras
+    while (chunk_offset_ < reader_->size_) {
+        ChunkHeader header{};
+        read_at(chunk_offset_, &header, sizeof(header));
+        const uint64_t records_offset = chunk_offset_ + sizeof(header);
+        const uint64_t end = records_offset + static_cast<uint64_t>(header.count) * sizeof(AccessRecord);
+        if (end > reader_->size_) throw std::runtime_error("Traza de accesos truncada");
+        chunk_offset_ = end;
+        if (header.core == core_ && header.count) {
+            record_offset_ = records_offset;
+            chunk_left_ = header.count;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AccessTraceReader::Cursor::next(AccessRecord& out) {
+    if (window_pos_ == window_count_) {
+        if (chunk_left_ == 0 && !next_chunk()) return false;
+        if (reader_->mapped_) {
+            // El bloque completo ya está en memoria: la ventana apunta al archivo proyectado
+            window_ = reinterpret_cast<const AccessRecord*>(reader_->mapped_ + record_offset_);
+            window_count_ = static_cast<size_t>(chunk_left_);
+        } else {
+            window_count_ = static_cast<size_t>(std::min<uint64_t>(chunk_left_, buffer_.size()));
+            read_at(record_offset_, buffer_.data(), window_count_ * sizeof(AccessRecord));
+            window_ = buffer_.data();
+        }
+        record_offset_ += window_count_ * sizeof(AccessRecord);
+        chunk_left_ -= window_count_;
+        window_pos_ = 0;
+    }
+    out = window_[window_pos_++];
+    if (out.core != core_) throw std::runtime_error("Traza de accesos: registro de otro core dentro de un bloque");
+    return true;
+}
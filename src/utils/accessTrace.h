@@ -0,0 +1,140 @@
+#ifndef ACCESS_TRACE_H
+#define ACCESS_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ Trazas de accesos a memoria por core (entrada del modo --replay).
+ Formato: una FileHeader y luego bloques; cada bloque es una ChunkHeader seguida de
+ 'count' AccessRecord de un mismo core. Los bloques de distintos cores se intercalan en
+ el archivo, pero dentro de cada core el orden de los registros es el de sus accesos.
+ El entrelazado entre cores no está en el archivo: lo decide la simulación (gap y
+ latencias). Así cada core lee su propio flujo saltando los bloques ajenos (solo lee
+ sus cabeceras) y la memoria usada no depende del tamaño de la traza.
+ Todos los campos en el orden de bytes del host (little-endian en x86).
+*/
+struct AccessRecord {
+    uint64_t address;
+    uint32_t gap;    // ciclos de cómputo entre el acceso anterior del core y este
+    uint16_t size;   // bytes accedidos (puede cruzar líneas)
+    uint8_t core;
+    uint8_t write;   // 0 = lectura, 1 = escritura
+};
+static_assert(sizeof(AccessRecord) == 16, "AccessRecord debe medir 16 bytes");
+
+namespace access_trace {
+
+constexpr char FILE_MAGIC[8] = {'M', 'E', 'S', 'I', 'A', 'C', 'C', '1'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr unsigned MAX_CORES = 64;            // igual a BusInterconnect::MAX_PES
+constexpr uint32_t CHUNK_RECORDS = 4096;      // registros por bloque al escribir (64 KB)
+constexpr size_t STREAM_BUFFER_RECORDS = 1024; // ventana de lectura por core sin mmap
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_bytes;
+    uint32_t cores;
+    uint32_t reserved;
+    uint64_t records; // total de registros (lo completa el writer al cerrar)
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader debe medir 32 bytes");
+
+struct ChunkHeader {
+    uint32_t core;
+    uint32_t count;
+};
+static_assert(sizeof(ChunkHeader) == 8, "ChunkHeader debe medir 8 bytes");
+
+} // namespace access_trace
+
+// Escribe una traza: acumula hasta CHUNK_RECORDS registros por core y los vuelca como un bloque
+class AccessTraceWriter {
+public:
+    // Lanza std::runtime_error si no puede crear el archivo y std::invalid_argument si cores
+    // es 0 o mayor que MAX_CORES
+    AccessTraceWriter(const std::string& path, unsigned cores);
+    ~AccessTraceWriter();
+    AccessTraceWriter(const AccessTraceWriter&) = delete;
+    AccessTraceWriter& operator=(const AccessTraceWriter&) = delete;
+
+    // Lanza std::out_of_range si record.core >= cores
+    void append(const AccessRecord& record);
+    // Vuelca los bloques pendientes y escribe el total en la cabecera
+    void close();
+
+    uint64_t records() const { return records_; }
+
+private:
+    std::FILE* file_;
+    unsigned cores_;
+    uint64_t records_ = 0;
+    std::vector<std::vector<AccessRecord>> pending_; // un bloque en construcción por core
+
+    void flush_chunk(unsigned core);
+};
+
+/*
+ Lee una traza. Con Mode::MMAP proyecta el archivo en memoria (las páginas se cargan a
+ demanda y el sistema las descarta sin costo); si mmap no está disponible o falla usa
+ Mode::STREAM: cada cursor lee su flujo con una ventana de STREAM_BUFFER_RECORDS.
+ Los cursores de cores distintos son independientes entre sí.
+*/
+class AccessTraceReader {
+public:
+    enum class Mode { MMAP, STREAM };
+
+    // Lanza std::runtime_error si el archivo no existe o no es una traza válida
+    explicit AccessTraceReader(const std::string& path, Mode mode = Mode::MMAP);
+    ~AccessTraceReader();
+    AccessTraceReader(const AccessTraceReader&) = delete;
+    AccessTraceReader& operator=(const AccessTraceReader&) = delete;
+
+    unsigned cores() const { return header_.cores; }
+    uint64_t records() const { return header_.records; }
+    uint64_t file_bytes() const { return size_; }
+    Mode mode() const { return mode_; }
+
+    // Registros de un core en orden
+    class Cursor {
+    public:
+        // false al terminar el flujo; lanza std::runtime_error si la traza está truncada o
+        // un bloque contiene registros de otro core
+        bool next(AccessRecord& out);
+
+    private:
+        friend class AccessTraceReader;
+        Cursor(const AccessTraceReader& reader, unsigned core);
+
+        const AccessTraceReader* reader_;
+        unsigned core_;
+        uint64_t chunk_offset_;        // próxima cabecera de bloque
+        uint64_t record_offset_ = 0;   // próximo registro del bloque actual
+        uint64_t chunk_left_ = 0;      // registros del bloque actual aún sin ventana
+        const AccessRecord* window_ = nullptr;
+        size_t window_count_ = 0;
+        size_t window_pos_ = 0;
+        std::unique_ptr<std::ifstream> stream_;   // solo Mode::STREAM
+        std::vector<AccessRecord> buffer_;        // ventana propia en Mode::STREAM
+
+        bool next_chunk();
+        void read_at(uint64_t offset, void* out, size_t bytes);
+    };
+
+    // Lanza std::out_of_range si core >= cores()
+    Cursor cursor(unsigned core) const;
+
+private:
+    std::string path_;
+    Mode mode_;
+    access_trace::FileHeader header_{};
+    uint64_t size_ = 0;
+    const uint8_t* mapped_ = nullptr; // Mode::MMAP
+};
+
+#endif // ACCESS_TRACE_H
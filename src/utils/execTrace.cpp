@@ -0,0 +1,222 @@
+#include "execTrace.h"
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+using namespace exec_trace;
+
+namespace {
+
+void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Diferencias con signo: los valores chicos en módulo usan pocos bytes
+void put_signed(std::vector<uint8_t>& out, uint64_t current, uint64_t previous) {
+    const int64_t delta = static_cast<int64_t>(current - previous);
+    put_varint(out, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+}
+
+uint64_t get_varint(const uint8_t*& in, const uint8_t* end) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (in == end) throw std::runtime_error("Traza de ejecucion: bloque truncado");
+        const uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("Traza de ejecucion: varint invalido");
+}
+
+uint64_t get_signed(const uint8_t*& in, const uint8_t* end, uint64_t previous) {
+    const uint64_t zigzag = get_varint(in, end);
+    return previous + ((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
+
+void decode_block(const uint8_t* in, const uint8_t* end, unsigned pe, uint32_t count,
+                  std::vector<ExecRecord>& out) {
+    out.resize(count);
+    ExecRecord previous{};
+    for (ExecRecord& record : out) {
+        if (in == end || *in > 1) throw std::runtime_error("Traza de ejecucion: registro invalido");
+        record.write = *in++;
+        record.sequence = previous.sequence + get_varint(in, end);
+        record.cycle = previous.cycle + get_varint(in, end);
+        record.latency = static_cast<uint32_t>(get_varint(in, end));
+        record.address = get_signed(in, end, previous.address);
+        record.pc = static_cast<uint32_t>(get_signed(in, end, previous.pc));
+        record.value = get_signed(in, end, previous.value);
+        record.pe = static_cast<uint8_t>(pe);
+        previous = record;
+    }
+    if (in != end) throw std::runtime_error("Traza de ejecucion: bytes sobrantes en un bloque");
+}
+
+} // namespace
+
+void encode_exec_block(const std::vector<ExecRecord>& records, std::vector<uint8_t>& out) {
+    // Por registro: tipo, deltas de secuencia y ciclo (no decrecen dentro de un PE), latencia,
+    // y deltas con signo de dirección, instrucción y dato
+    ExecRecord previous{};
+    for (const ExecRecord& record : records) {
+        out.push_back(record.write ? 1 : 0);
+        put_varint(out, record.sequence - previous.sequence);
+        put_varint(out, record.cycle - previous.cycle);
+        put_varint(out, record.latency);
+        put_signed(out, record.address, previous.address);
+        put_signed(out, record.pc, previous.pc);
+        put_signed(out, record.value, previous.value);
+        previous = record;
+    }
+}
+
+/* ---------------- Writer ---------------- */
+
+ExecTraceWriter::ExecTraceWriter(const std::string& path, unsigned pes) : pes_(pes) {
+    if (pes == 0 || pes > MAX_PES) {
+        throw std::invalid_argument("ExecTraceWriter: PEs fuera de rango (1.." + std::to_string(MAX_PES) + ")");
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) throw std::runtime_error("ExecTraceWriter: no se pudo crear " + path);
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.pes = pes;
+    std::fwrite(&header, sizeof(header), 1, file_);
+    pending_.resize(pes);
+    for (auto& block : pending_) block.reserve(BLOCK_RECORDS);
+    thread_ = std::thread([this] { run(); });
+}
+
+ExecTraceWriter::~ExecTraceWriter() {
+    close();
+}
+
+void ExecTraceWriter::append(const ExecRecord& record) {
+    if (record.pe >= pes_) throw std::out_of_range("ExecTraceWriter: PE fuera de rango");
+    std::vector<ExecRecord>& block = pending_[record.pe];
+    block.push_back(record);
+    if (block.size() == BLOCK_RECORDS) submit(record.pe);
+}
+
+void ExecTraceWriter::submit(unsigned pe) {
+    std::vector<ExecRecord>& block = pending_[pe];
+    if (block.empty()) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_.wait(lock, [this] { return queue_.size() < MAX_QUEUED_BLOCKS; });
+    queue_.push_back(Block{pe, std::move(block)});
+    if (!spare_.empty()) {
+        block = std::move(spare_.back());
+        spare_.pop_back();
+    } else {
+        block = std::vector<ExecRecord>();
+        block.reserve(BLOCK_RECORDS);
+    }
+    lock.unlock();
+    ready_.notify_one();
+}
+
+void ExecTraceWriter::run() {
+    std::vector<uint8_t> encoded;
+    encoded.reserve(BLOCK_RECORDS * 16);
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ready_.wait(lock, [this] { return !queue_.empty() || closing_; });
+        if (queue_.empty()) return; // cerrando y sin pendientes
+        Block block = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        space_.notify_one();
+
+        // Codificar y escribir sin el lock: la simulación sigue llenando bloques
+        encoded.clear();
+        encode_exec_block(block.records, encoded);
+        const BlockHeader header{block.pe, static_cast<uint32_t>(block.records.size()),
+                                 static_cast<uint32_t>(encoded.size()), 0};
+        std::fwrite(&header, sizeof(header), 1, file_);
+        std::fwrite(encoded.data(), 1, encoded.size(), file_);
+        records_ += block.records.size();
+        encoded_bytes_ += encoded.size();
+        block.records.clear();
+
+        lock.lock();
+        spare_.push_back(std::move(block.records));
+    }
+}
+
+void ExecTraceWriter::close() {
+    if (!file_) return;
+    for (unsigned pe = 0; pe < pes_; ++pe) submit(pe);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    ready_.notify_one();
+    thread_.join();
+    std::fseek(file_, static_cast<long>(offsetof(FileHeader, records)), SEEK_SET);
+    std::fwrite(&records_, sizeof(records_), 1, file_);
+    std::fwrite(&encoded_bytes_, sizeof(encoded_bytes_), 1, file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+/* ---------------- Reader ---------------- */
+
+ExecTraceReader::ExecTraceReader(const std::string& path) : path_(path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("ExecTraceReader: no se pudo abrir " + path);
+    size_ = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    if (size_ < sizeof(header_) || !in.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, FILE_MAGIC, sizeof(header_.magic)) != 0) {
+        throw std::runtime_error(path + " no es una traza de ejecucion");
+    }
+    if (header_.version != FILE_VERSION) {
+        throw std::runtime_error("Version de traza de ejecucion no soportada (" + std::to_string(header_.version) + ")");
+    }
+    if (header_.pes == 0 || header_.pes > MAX_PES) throw std::runtime_error(path + ": cantidad de PEs invalida");
+}
+
+ExecTraceReader::Cursor ExecTraceReader::cursor(unsigned pe) const {
+    if (pe >= header_.pes) throw std::out_of_range("ExecTraceReader: PE fuera de rango");
+    return Cursor(*this, pe);
+}
+
+ExecTraceReader::Cursor::Cursor(const ExecTraceReader& reader, unsigned pe)
+    : reader_(&reader), pe_(pe), block_offset_(sizeof(FileHeader)),
+      stream_(std::make_unique<std::ifstream>(reader.path_, std::ios::binary)) {
+    if (!*stream_) throw std::runtime_error("ExecTraceReader: no se pudo abrir " + reader.path_);
+}
+
+bool ExecTraceReader::Cursor::next_block() {
+    // Salta los bloques de otros PEs leyendo solo sus cabeceras
+    while (block_offset_ < reader_->size_) {
+        BlockHeader header{};
+        stream_->seekg(static_cast<std::streamoff>(block_offset_));
+        if (!stream_->read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            throw std::runtime_error("Traza de ejecucion truncada");
+        }
+        const uint64_t data_offset = block_offset_ + sizeof(header);
+        block_offset_ = data_offset + header.bytes;
+        if (block_offset_ > reader_->size_) throw std::runtime_error("Traza de ejecucion truncada");
+        if (header.pe != pe_ || header.count == 0) continue;
+        encoded_.resize(header.bytes);
+        if (!stream_->read(reinterpret_cast<char*>(encoded_.data()), header.bytes)) {
+            throw std::runtime_error("Traza de ejecucion truncada");
+        }
+        decode_block(encoded_.data(), encoded_.data() + encoded_.size(), pe_, header.count, block_);
+        pos_ = 0;
+        return true;
+    }
+    return false;
+}
+
+bool ExecTraceReader::Cursor::next(ExecRecord& out) {
+    if (pos_ == block_.size() && !next_block()) return false;
+    out = block_[pos_++];
+    return true;
+}
@@ -0,0 +1,163 @@
+#ifndef EXEC_TRACE_H
+#define EXEC_TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ Trazas de ejecución capturadas de los PEs (modo --capture).
+ Cada acceso LOAD/STORE/LOADR/STORER que un PE emite se registra con su dirección efectiva,
+ el dato leído o escrito, el índice de la instrucción, el ciclo de emisión y la latencia.
+ 'sequence' numera los accesos de todos los PEs en el orden en que se emitieron: junto
+ con los ciclos alcanza para reconstruir el entrelazado entre PEs.
+ Formato: una FileHeader y luego bloques de un mismo PE (BlockHeader + bytes). Dentro de un
+ bloque cada campo se guarda como la diferencia con el registro anterior en un varint
+ (zigzag para los que pueden bajar), así que cada bloque se decodifica solo.
+*/
+struct ExecRecord {
+    uint64_t sequence; // orden global de emisión
+    uint64_t cycle;    // ciclo de emisión
+    uint64_t address;
+    uint64_t value;    // dato leído (load) o escrito (store)
+    uint32_t pc;       // índice de la instrucción en el programa del PE
+    uint32_t latency;  // emisión -> entrega (0 = acierto local)
+    uint8_t pe;
+    uint8_t write;     // 0 = load, 1 = store
+};
+
+namespace exec_trace {
+
+constexpr char FILE_MAGIC[8] = {'M', 'E', 'S', 'I', 'E', 'X', 'E', '1'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr unsigned MAX_PES = 64;            // igual a ProcessorSystem::MAX_PE_COUNT
+constexpr uint32_t BLOCK_RECORDS = 4096;    // registros por bloque
+constexpr size_t MAX_QUEUED_BLOCKS = 16;    // bloques esperando al hilo escritor
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pes;
+    uint64_t records;       // total de registros (lo completa el writer al cerrar)
+    uint64_t encoded_bytes; // bytes de bloques comprimidos, sin cabeceras
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader debe medir 32 bytes");
+
+struct BlockHeader {
+    uint32_t pe;
+    uint32_t count;
+    uint32_t bytes; // largo de los registros codificados que siguen
+    uint32_t reserved;
+};
+static_assert(sizeof(BlockHeader) == 16, "BlockHeader debe medir 16 bytes");
+
+} // namespace exec_trace
+
+/*
+ Escribe una traza de ejecución. append solo copia el registro al bloque en construcción
+ de su PE; los bloques llenos pasan a un hilo escritor que los codifica y los escribe, así
+ la simulación no espera al disco. Si hay MAX_QUEUED_BLOCKS esperando, append se bloquea
+ hasta que haya lugar (la memoria usada está acotada).
+ Cada PE debe emitir desde un único hilo; PEs distintos pueden usar hilos distintos.
+*/
+class ExecTraceWriter {
+public:
+    // Lanza std::runtime_error si no puede crear el archivo y std::invalid_argument si pes
+    // es 0 o mayor que MAX_PES
+    ExecTraceWriter(const std::string& path, unsigned pes);
+    ~ExecTraceWriter();
+    ExecTraceWriter(const ExecTraceWriter&) = delete;
+    ExecTraceWriter& operator=(const ExecTraceWriter&) = delete;
+
+    // Número de orden para el próximo acceso emitido (cualquier hilo)
+    uint64_t next_sequence() { return sequence_.fetch_add(1, std::memory_order_relaxed); }
+    // Lanza std::out_of_range si record.pe >= pes
+    void append(const ExecRecord& record);
+    // Vuelca los bloques pendientes, espera al hilo escritor y completa la cabecera
+    void close();
+
+    unsigned pes() const { return pes_; }
+    // Válidos después de close()
+    uint64_t records() const { return records_; }
+    uint64_t encoded_bytes() const { return encoded_bytes_; }
+
+private:
+    struct Block {
+        unsigned pe;
+        std::vector<ExecRecord> records;
+    };
+
+    std::FILE* file_;
+    unsigned pes_;
+    std::atomic<uint64_t> sequence_{0};
+    std::vector<std::vector<ExecRecord>> pending_; // un bloque en construcción por PE
+
+    // Compartido con el hilo escritor
+    std::mutex mutex_;
+    std::condition_variable ready_; // hay bloques en la cola o se está cerrando
+    std::condition_variable space_; // la cola bajó de MAX_QUEUED_BLOCKS
+    std::deque<Block> queue_;
+    std::vector<std::vector<ExecRecord>> spare_; // vectores ya escritos para reutilizar
+    bool closing_ = false;
+    std::thread thread_;
+
+    // Solo el hilo escritor (se leen después de join)
+    uint64_t records_ = 0;
+    uint64_t encoded_bytes_ = 0;
+
+    void submit(unsigned pe);
+    void run();
+};
+
+// Codifica los registros de un bloque (deltas + varint) al final de out
+void encode_exec_block(const std::vector<ExecRecord>& records, std::vector<uint8_t>& out);
+
+// Lee una traza de ejecución; cada cursor recorre los registros de un PE con su propio flujo
+class ExecTraceReader {
+public:
+    // Lanza std::runtime_error si el archivo no existe o no es una traza de ejecución
+    explicit ExecTraceReader(const std::string& path);
+
+    unsigned pes() const { return header_.pes; }
+    uint64_t records() const { return header_.records; }
+    uint64_t encoded_bytes() const { return header_.encoded_bytes; }
+    uint64_t file_bytes() const { return size_; }
+
+    class Cursor {
+    public:
+        // false al terminar el flujo del PE; lanza std::runtime_error si la traza está dañada
+        bool next(ExecRecord& out);
+
+    private:
+        friend class ExecTraceReader;
+        Cursor(const ExecTraceReader& reader, unsigned pe);
+
+        const ExecTraceReader* reader_;
+        unsigned pe_;
+        uint64_t block_offset_; // próxima cabecera de bloque
+        std::unique_ptr<std::ifstream> stream_;
+        std::vector<uint8_t> encoded_;
+        std::vector<ExecRecord> block_;
+        size_t pos_ = 0;
+
+        bool next_block();
+    };
+
+    // Lanza std::out_of_range si pe >= pes()
+    Cursor cursor(unsigned pe) const;
+
+private:
+    std::string path_;
+    exec_trace::FileHeader header_{};
+    uint64_t size_ = 0;
+};
+
+#endif // EXEC_TRACE_H
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/*
+ Histograma de latencias (en ciclos) con cubetas logarítmicas en base 2:
+ la cubeta 0 cuenta el valor 0 y la cubeta k (k >= 1) los valores en [2^(k-1), 2^k).
+ Registrar un valor es un conteo de ceros y un incremento; sin reservas de memoria.
+ Cada componente tiene los suyos (un solo escritor) y ocupan líneas de caché propias,
+ así que no hay false sharing entre contadores de componentes distintos.
+*/
+struct alignas(64) LatencyHistogram {
+    static constexpr unsigned BUCKETS = 65; // 0 y [2^(k-1), 2^k) para k = 1..64
+
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    static unsigned bucket_of(uint64_t value) { return value ? 64 - __builtin_clzll(value) : 0; }
+    // Mayor valor que cae en la cubeta
+    static uint64_t upper_bound(unsigned bucket) {
+        if (bucket == 0) return 0;
+        return bucket >= 64 ? ~0ULL : (1ULL << bucket) - 1;
+    }
+
+    void record(uint64_t value) {
+        buckets[bucket_of(value)]++;
+        count++;
+        sum += value;
+        if (value > max) max = value;
+    }
+
+    double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+
+    // Cota superior del percentil p (0..100): el límite de la cubeta que lo contiene
+    uint64_t percentile(double p) const {
+        if (!count) return 0;
+        const double target = p / 100.0 * static_cast<double>(count);
+        uint64_t seen = 0;
+        for (unsigned b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen > 0 && static_cast<double>(seen) >= target) {
+                return upper_bound(b) < max ? upper_bound(b) : max;
+            }
+        }
+        return max;
+    }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& other) {
+        for (unsigned b = 0; b < BUCKETS; ++b) buckets[b] += other.buckets[b];
+        count += other.count;
+        sum += other.sum;
+        if (other.max > max) max = other.max;
+        return *this;
+    }
+};
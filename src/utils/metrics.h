@@ -1,14 +1,97 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
+#include "../interconnect/BusEnums.h"
 
-struct Metrics {
-    int hits = 0;
-    int misses = 0;
-    int invalidations = 0;
+/*
+ Contadores de una caché L1. Solo los escribe su caché (un escritor por bloque) y el
+ bloque ocupa líneas de caché propias (alignas(64)): los contadores de cachés distintas
+ nunca comparten línea, aunque varias simulaciones corran en hilos a la vez.
+ MetricsRegistry toma una copia al final de la corrida para exportarla.
+*/
+struct alignas(64) Metrics {
+    static constexpr unsigned STATES = 6; // MESI_State: I, E, S, M, O, F
 
-    void print(int cache_id) const {
-        std::cout << "[Cache" << cache_id << "] Hits: " << hits
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // hits/misses separados por tipo de acceso (read_* + write_* = hits/misses)
+    uint64_t read_hits = 0;
+    uint64_t read_misses = 0;
+    uint64_t write_hits = 0;
+    uint64_t write_misses = 0;
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;          // bloques válidos desalojados por la política
+    uint64_t writebacks = 0;         // líneas sucias escritas al desalojarse o en flush
+    // Snooping recibido del Bus
+    uint64_t snoops = 0;             // BusRd/BusRdX recibidos
+    uint64_t snoop_hits = 0;         // ...con la línea válida
+    uint64_t snoop_supplied = 0;     // ...en los que esta caché entregó el bloque
+    const char* policy = "UNKNOWN";  // política de reemplazo que generó estos contadores
+    // Prefetch (solo con prefetcher)
+    uint64_t prefetch_issued = 0;     // enviados al Bus
+    uint64_t prefetch_dropped = 0;    // descartados por el Bus (línea ya presente o en vuelo)
+    uint64_t prefetch_useful = 0;     // línea precargada usada a demanda antes de salir de la caché
+    uint64_t prefetch_late = 0;       // miss a demanda con el prefetch de esa línea aún en vuelo
+    uint64_t prefetch_useless = 0;    // línea precargada desalojada o invalidada sin usarse
+    uint64_t prefetch_pollution = 0;  // miss a demanda de una línea que desalojó un prefetch
+    // Transiciones de estado: transitions[desde][hacia] (un desalojo cuenta como X -> I)
+    uint64_t transitions[STATES][STATES] = {};
+
+    void record_hit(bool write) {
+        hits++;
+        (write ? write_hits : read_hits)++;
+    }
+    void record_miss(bool write) {
+        misses++;
+        (write ? write_misses : read_misses)++;
+    }
+    void record_transition(MESI_State from, MESI_State to) {
+        if (from != to) transitions[static_cast<unsigned>(from)][static_cast<unsigned>(to)]++;
+    }
+
+    double miss_rate() const {
+        uint64_t accesses = hits + misses;
+        return accesses ? static_cast<double>(misses) / accesses : 0.0;
+    }
+
+    Metrics& operator+=(const Metrics& other) {
+        hits += other.hits;
+        misses += other.misses;
+        read_hits += other.read_hits;
+        read_misses += other.read_misses;
+        write_hits += other.write_hits;
+        write_misses += other.write_misses;
+        invalidations += other.invalidations;
+        evictions += other.evictions;
+        writebacks += other.writebacks;
+        snoops += other.snoops;
+        snoop_hits += other.snoop_hits;
+        snoop_supplied += other.snoop_supplied;
+        prefetch_issued += other.prefetch_issued;
+        prefetch_dropped += other.prefetch_dropped;
+        prefetch_useful += other.prefetch_useful;
+        prefetch_late += other.prefetch_late;
+        prefetch_useless += other.prefetch_useless;
+        prefetch_pollution += other.prefetch_pollution;
+        for (unsigned from = 0; from < STATES; ++from) {
+            for (unsigned to = 0; to < STATES; ++to) transitions[from][to] += other.transitions[from][to];
+        }
+        policy = other.policy;
+        return *this;
+    }
+
+    void print(int cache_id, std::ostream& out = std::cout) const {
+        out << "[Cache" << cache_id << " " << policy << "] Hits: " << hits
                   << " Misses: " << misses
-                  << " Invalidaciones: " << invalidations << "\n";
+                  << " Invalidaciones: " << invalidations
+                  << " Desalojos: " << evictions << "\n";
+        if (prefetch_issued) {
+            out << "[Cache" << cache_id << " prefetch] Emitidos: " << prefetch_issued
+                      << " Descartados: " << prefetch_dropped
+                      << " Utiles: " << prefetch_useful
+                      << " Tardios: " << prefetch_late
+                      << " Inutiles: " << prefetch_useless
+                      << " Contaminacion: " << prefetch_pollution << "\n";
+        }
     }
 };
@@ -0,0 +1,230 @@
+#include "metricsRegistry.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+void write_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                        << std::dec << std::setfill(' ');
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+void write_number(std::ostream& out, double value) {
+    if (std::isfinite(value)) out << std::setprecision(10) << value;
+    else out << "null"; // JSON no admite NaN ni infinito
+}
+
+// CSV: los campos con coma o comillas van entre comillas
+void write_field(std::ostream& out, const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        out << text;
+        return;
+    }
+    out << '"';
+    for (char c : text) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+MetricsRegistry::Component& MetricsRegistry::component(const std::string& name) {
+    for (Component& existing : components_) {
+        if (existing.name == name) return existing;
+    }
+    components_.push_back(Component{name, {}, {}, {}, {}});
+    return components_.back();
+}
+
+double MetricsRegistry::value(const std::string& component_name, const std::string& name) const {
+    for (const Component& existing : components_) {
+        if (existing.name != component_name) continue;
+        for (const auto& c : existing.counters) {
+            if (c.first == name) return static_cast<double>(c.second);
+        }
+        for (const auto& g : existing.gauges) {
+            if (g.first == name) return g.second;
+        }
+    }
+    throw std::out_of_range("MetricsRegistry: no hay metrica " + component_name + "." + name);
+}
+
+void MetricsRegistry::counter(const std::string& component_name, const std::string& name, uint64_t value) {
+    component(component_name).counters.emplace_back(name, value);
+}
+
+void MetricsRegistry::gauge(const std::string& component_name, const std::string& name, double value) {
+    component(component_name).gauges.emplace_back(name, value);
+}
+
+void MetricsRegistry::histogram(const std::string& component_name, const std::string& name,
+                                const LatencyHistogram& histogram) {
+    component(component_name).histograms.emplace_back(name, histogram);
+}
+
+void MetricsRegistry::matrix(const std::string& component_name, const std::string& name,
+                             const std::vector<std::string>& states, const std::vector<uint64_t>& cells) {
+    if (cells.size() != states.size() * states.size()) {
+        throw std::invalid_argument("MetricsRegistry::matrix: se esperaban estados x estados celdas");
+    }
+    component(component_name).matrices.push_back(Matrix{name, states, cells});
+}
+
+void MetricsRegistry::write_json(std::ostream& out) const {
+    out << "{\"run\": ";
+    write_string(out, run_);
+    out << ", \"labels\": {";
+    for (size_t i = 0; i < labels_.size(); ++i) {
+        out << (i ? ", " : "");
+        write_string(out, labels_[i].first);
+        out << ": ";
+        write_string(out, labels_[i].second);
+    }
+    out << "},\n  \"components\": {";
+    for (size_t c = 0; c < components_.size(); ++c) {
+        const Component& comp = components_[c];
+        out << (c ? ",\n    " : "\n    ");
+        write_string(out, comp.name);
+        out << ": {\"counters\": {";
+        for (size_t i = 0; i < comp.counters.size(); ++i) {
+            out << (i ? ", " : "");
+            write_string(out, comp.counters[i].first);
+            out << ": " << comp.counters[i].second;
+        }
+        out << "}, \"gauges\": {";
+        for (size_t i = 0; i < comp.gauges.size(); ++i) {
+            out << (i ? ", " : "");
+            write_string(out, comp.gauges[i].first);
+            out << ": ";
+            write_number(out, comp.gauges[i].second);
+        }
+        out << "}, \"histograms\": {";
+        for (size_t i = 0; i < comp.histograms.size(); ++i) {
+            const LatencyHistogram& h = comp.histograms[i].second;
+            out << (i ? ", " : "");
+            write_string(out, comp.histograms[i].first);
+            out << ": {\"count\": " << h.count << ", \"sum\": " << h.sum << ", \"max\": " << h.max
+                << ", \"mean\": ";
+            write_number(out, h.mean());
+            out << ", \"p50\": " << h.percentile(50) << ", \"p90\": " << h.percentile(90)
+                << ", \"p99\": " << h.percentile(99) << ", \"buckets\": [";
+            // Solo las cubetas no vacías; "le" es el mayor valor de la cubeta
+            bool first = true;
+            for (unsigned b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                if (!h.buckets[b]) continue;
+                out << (first ? "" : ", ") << "{\"le\": " << LatencyHistogram::upper_bound(b)
+                    << ", \"count\": " << h.buckets[b] << "}";
+                first = false;
+            }
+            out << "]}";
+        }
+        out << "}, \"matrices\": {";
+        for (size_t i = 0; i < comp.matrices.size(); ++i) {
+            const Matrix& m = comp.matrices[i];
+            out << (i ? ", " : "");
+            write_string(out, m.name);
+            out << ": {\"states\": [";
+            for (size_t s = 0; s < m.states.size(); ++s) {
+                out << (s ? ", " : "");
+                write_string(out, m.states[s]);
+            }
+            out << "], \"counts\": [";
+            const size_t n = m.states.size();
+            for (size_t row = 0; row < n; ++row) {
+                out << (row ? ", [" : "[");
+                for (size_t col = 0; col < n; ++col) out << (col ? ", " : "") << m.cells[row * n + col];
+                out << "]";
+            }
+            out << "]}";
+        }
+        out << "}}";
+    }
+    out << "\n  }}";
+}
+
+void MetricsRegistry::write_csv_rows(std::ostream& out) const {
+    auto row = [&](const std::string& component_name, const std::string& metric) -> std::ostream& {
+        write_field(out, run_);
+        out << ',';
+        write_field(out, component_name);
+        out << ',';
+        write_field(out, metric);
+        return out << ',';
+    };
+    for (const auto& entry : labels_) {
+        row("run", entry.first);
+        write_field(out, entry.second);
+        out << '\n';
+    }
+    for (const Component& comp : components_) {
+        for (const auto& entry : comp.counters) row(comp.name, entry.first) << entry.second << '\n';
+        for (const auto& entry : comp.gauges) {
+            row(comp.name, entry.first);
+            if (std::isfinite(entry.second)) out << std::setprecision(10) << entry.second;
+            out << '\n';
+        }
+        for (const auto& entry : comp.histograms) {
+            const LatencyHistogram& h = entry.second;
+            const std::string& name = entry.first;
+            row(comp.name, name + ".count") << h.count << '\n';
+            row(comp.name, name + ".sum") << h.sum << '\n';
+            row(comp.name, name + ".max") << h.max << '\n';
+            row(comp.name, name + ".p50") << h.percentile(50) << '\n';
+            row(comp.name, name + ".p90") << h.percentile(90) << '\n';
+            row(comp.name, name + ".p99") << h.percentile(99) << '\n';
+            for (unsigned b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                if (!h.buckets[b]) continue;
+                row(comp.name, name + ".le_" + std::to_string(LatencyHistogram::upper_bound(b))) << h.buckets[b] << '\n';
+            }
+        }
+        for (const Matrix& m : comp.matrices) {
+            const size_t n = m.states.size();
+            for (size_t from = 0; from < n; ++from) {
+                for (size_t to = 0; to < n; ++to) {
+                    if (!m.cells[from * n + to]) continue;
+                    row(comp.name, m.name + "." + m.states[from] + "->" + m.states[to]) << m.cells[from * n + to] << '\n';
+                }
+            }
+        }
+    }
+}
+
+void write_metrics_json(std::ostream& out, const std::vector<MetricsRegistry>& runs) {
+    out << "{\"runs\": [";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        out << (i ? ",\n " : "\n ");
+        runs[i].write_json(out);
+    }
+    out << "\n]}\n";
+}
+
+void write_metrics_csv(std::ostream& out, const std::vector<MetricsRegistry>& runs) {
+    out << "run,component,metric,value\n";
+    for (const MetricsRegistry& run : runs) run.write_csv_rows(out);
+}
+
+void save_metrics(const std::string& path, const std::vector<MetricsRegistry>& runs, bool json) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("No se pudo abrir " + path + " para escribir las metricas");
+    if (json) write_metrics_json(out, runs);
+    else write_metrics_csv(out, runs);
+}
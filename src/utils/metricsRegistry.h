@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "histogram.h"
+
+/*
+ Instantánea de las métricas de una corrida, para exportarlas al final en JSON o CSV.
+ Los componentes (cachés, Bus, LLC, DRAM, Memoria, PEs) mantienen sus propios contadores
+ durante la simulación y al terminar los copian aquí con export_metrics(registry), cada
+ uno bajo su nombre ("cache0", "bus", "pe2"...). El registro conserva el orden de
+ inserción de componentes y métricas; no interviene en la simulación.
+*/
+class MetricsRegistry {
+public:
+    explicit MetricsRegistry(std::string run = "run") : run_(std::move(run)) {}
+
+    // Parámetros de la corrida (protocolo, geometría...) que acompañan a las métricas
+    void label(const std::string& key, const std::string& value) { labels_.emplace_back(key, value); }
+
+    void counter(const std::string& component, const std::string& name, uint64_t value);
+    void gauge(const std::string& component, const std::string& name, double value);
+    void histogram(const std::string& component, const std::string& name, const LatencyHistogram& histogram);
+    // Matriz cuadrada (filas = desde, columnas = hacia) con nombres de estados
+    void matrix(const std::string& component, const std::string& name,
+                const std::vector<std::string>& states, const std::vector<uint64_t>& cells);
+
+    const std::string& run() const { return run_; }
+    // Valor de un contador o gauge ya registrado; lanza std::out_of_range si no existe
+    double value(const std::string& component, const std::string& name) const;
+
+    // {"run": ..., "labels": {...}, "components": {"cache0": {"counters": ..., ...}}}
+    void write_json(std::ostream& out) const;
+    // Una fila por valor: run,component,metric,value (histogramas y matrices aplanados)
+    void write_csv_rows(std::ostream& out) const;
+
+private:
+    struct Matrix {
+        std::string name;
+        std::vector<std::string> states;
+        std::vector<uint64_t> cells;
+    };
+    struct Component {
+        std::string name;
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        std::vector<std::pair<std::string, double>> gauges;
+        std::vector<std::pair<std::string, LatencyHistogram>> histograms;
+        std::vector<Matrix> matrices;
+    };
+
+    std::string run_;
+    std::vector<std::pair<std::string, std::string>> labels_;
+    std::vector<Component> components_;
+
+    Component& component(const std::string& name);
+};
+
+// Varias corridas en un solo archivo: {"runs": [...]} y CSV con encabezado
+void write_metrics_json(std::ostream& out, const std::vector<MetricsRegistry>& runs);
+void write_metrics_csv(std::ostream& out, const std::vector<MetricsRegistry>& runs);
+// Escribe el archivo; lanza std::runtime_error si no se puede abrir
+void save_metrics(const std::string& path, const std::vector<MetricsRegistry>& runs, bool json);
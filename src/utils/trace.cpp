@@ -0,0 +1,174 @@
+#include "trace.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include "../interconnect/BusEnums.h"
+
+namespace trace {
+
+std::atomic<uint8_t> g_level{static_cast<uint8_t>(TraceLevel::OFF)};
+
+namespace {
+
+// Buffer de un hilo: solo su dueño escribe; se vuelca completo al llenarse
+struct ThreadBuffer {
+    TraceRecord records[BUFFER_RECORDS];
+    size_t count = 0;
+    uint16_t thread = 0;
+};
+
+std::mutex g_sink_mutex; // solo al registrar un hilo o al volcar un buffer al archivo
+std::FILE* g_file = nullptr;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local const uint64_t* t_clock = nullptr;
+
+// Requiere g_sink_mutex tomado
+void drain(ThreadBuffer& buffer) {
+    if (g_file && buffer.count) std::fwrite(buffer.records, sizeof(TraceRecord), buffer.count, g_file);
+    buffer.count = 0;
+}
+
+ThreadBuffer& local_buffer() {
+    if (!t_buffer) {
+        std::lock_guard<std::mutex> lock(g_sink_mutex);
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = g_buffers.back().get();
+        t_buffer->thread = static_cast<uint16_t>(g_buffers.size() - 1);
+    }
+    return *t_buffer;
+}
+
+} // namespace
+
+void open(const std::string& path, TraceLevel level) {
+    std::lock_guard<std::mutex> lock(g_sink_mutex);
+    if (g_file) std::fclose(g_file);
+    g_file = std::fopen(path.c_str(), "wb");
+    if (!g_file) throw std::runtime_error("trace::open: no se pudo crear " + path);
+    FileHeader header{};
+    for (size_t i = 0; i < sizeof(header.magic); ++i) header.magic[i] = FILE_MAGIC[i];
+    header.version = FILE_VERSION;
+    header.record_bytes = sizeof(TraceRecord);
+    std::fwrite(&header, sizeof(header), 1, g_file);
+    for (auto& buffer : g_buffers) buffer->count = 0;
+    g_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+void close() {
+    g_level.store(static_cast<uint8_t>(TraceLevel::OFF), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(g_sink_mutex);
+    for (auto& buffer : g_buffers) drain(*buffer);
+    if (g_file) {
+        std::fclose(g_file);
+        g_file = nullptr;
+    }
+}
+
+void set_level(TraceLevel level) {
+    g_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+TraceLevel parse_level(const std::string& name) {
+    if (name == "off") return TraceLevel::OFF;
+    if (name == "info") return TraceLevel::INFO;
+    if (name == "debug") return TraceLevel::DEBUG;
+    throw std::invalid_argument("Nivel de traza desconocido: " + name);
+}
+
+void bind_clock(const uint64_t* cycle) { t_clock = cycle; }
+
+void unbind_clock(const uint64_t* cycle) {
+    if (t_clock == cycle) t_clock = nullptr;
+}
+
+void emit(TraceEvent event, int32_t arg, uint64_t address, uint64_t value) {
+    ThreadBuffer& buffer = local_buffer();
+    if (buffer.count == BUFFER_RECORDS) {
+        std::lock_guard<std::mutex> lock(g_sink_mutex);
+        drain(buffer);
+    }
+    TraceRecord& record = buffer.records[buffer.count++];
+    record.cycle = t_clock ? *t_clock : 0;
+    record.address = address;
+    record.value = value;
+    record.event = static_cast<uint16_t>(event);
+    record.thread = buffer.thread;
+    record.arg = arg;
+}
+
+void format_record(const TraceRecord& r, std::ostream& out) {
+    switch (static_cast<TraceEvent>(r.event)) {
+        case TraceEvent::MEM_READ_BLOCK:
+            out << "[MEM] read_block @ 0x" << std::hex << r.address << std::dec << " (" << r.arg << "B)\n";
+            break;
+        case TraceEvent::MEM_WRITE_BLOCK:
+            out << "[MEM] write_block @ 0x" << std::hex << r.address << std::dec << " (" << r.arg << "B)\n";
+            break;
+        case TraceEvent::CACHE_WRITEBACK:
+            out << "[WRITEBACK] Cache" << r.arg << " writing back dirty block @ 0x"
+                << std::hex << r.address << std::dec << " (" << r.value << "B)\n";
+            break;
+        case TraceEvent::FACADE_LOAD:
+            out << "[MemoryFacade PE " << r.arg << "] Load 64b @ 0x" << std::hex << r.address << std::dec
+                << " = " << r.value << "\n";
+            break;
+        case TraceEvent::FACADE_STORE:
+            out << "[MemoryFacade PE " << r.arg << "] Store 64b @ 0x" << std::hex << r.address << std::dec
+                << " = " << r.value << "\n";
+            break;
+        case TraceEvent::BUS_GRANT:
+            out << "\n[BUS ARBITRADO @ ciclo " << r.cycle << "] PE " << r.arg
+                << " ha ganado el acceso (Prioridad iniciada en PE " << r.value << ").\n";
+            out << "\t-> Bus bloqueado. Próxima búsqueda Round-Robin iniciará en PE " << r.address << ".\n";
+            break;
+        case TraceEvent::BUS_BROADCAST:
+            out << "[BUS DIFUSIÓN] Difundiendo " << bus_command_name(static_cast<BusCommand>(r.value))
+                << " @ 0x" << std::hex << r.address << std::dec << " (Solicitado por PE " << r.arg << ").\n";
+            break;
+        case TraceEvent::BUS_SNOOP_MODIFIED:
+            out << "\t<- Snooping: PE " << r.arg << " tenía el dato en estado MODIFIED (M). REQUIERE WRITE-BACK.\n";
+            break;
+        case TraceEvent::BUS_SNOOP_SHARED:
+            out << "\t<- Snooping: PE " << r.arg << " tenía el dato en estado SHARED/EXCLUSIVE (S/E).\n";
+            break;
+        case TraceEvent::BUS_DATA_FROM_CACHE:
+            out << "[RESOLUCIÓN] Datos obtenidos de Caché PE " << r.arg << ".\n";
+            break;
+        case TraceEvent::BUS_WRITEBACK_DONE:
+            out << "[MEM] Write-back completado a Memoria (" << r.arg << "B).\n";
+            break;
+        case TraceEvent::BUS_DATA_FROM_MEMORY:
+            out << "[RESOLUCIÓN] Accediendo a Memoria Principal.\n";
+            break;
+        case TraceEvent::BUS_RESULT:
+            if (static_cast<BusCommand>(r.value) == BusCommand::BUS_READ_X) {
+                out << "\t-> Escritura (BusRdX): Garantizando estado EXCLUSIVE para PE " << r.arg << ".\n";
+            } else if (static_cast<BusCommand>(r.value) == BusCommand::INVALIDATE) {
+                out << "\t-> Upgrade (BusUpgr): PE " << r.arg << " conserva su copia y queda como único dueño (sin datos).\n";
+            } else {
+                const char* state = static_cast<MESI_State>(r.address) == MESI_State::FORWARD ? "FORWARD"
+                                   : static_cast<MESI_State>(r.address) == MESI_State::SHARED ? "SHARED" : "EXCLUSIVE";
+                out << "\t-> Lectura (BusRd): Estado final es " << state << ".\n";
+            }
+            break;
+        case TraceEvent::BUS_END:
+            out << "--------------------------------------------------------\n";
+            break;
+        case TraceEvent::BUS_SNOOP_OWNER:
+            out << "\t<- Snooping: PE " << r.arg << " tenía el dato en estado MODIFIED/OWNED (M/O). Transferencia caché a caché SIN WRITE-BACK.\n";
+            break;
+        case TraceEvent::BUS_SNOOP_FORWARD:
+            out << "\t<- Snooping: PE " << r.arg << " tenía el dato en estado FORWARD/EXCLUSIVE (F/E). Lo suministra sin leer Memoria.\n";
+            break;
+        default:
+            out << "[TRACE] evento desconocido " << r.event << "\n";
+            break;
+    }
+}
+
+} // namespace trace
@@ -0,0 +1,112 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/*
+ Trazas binarias de bajo costo.
+ - Cada evento es un TraceRecord de 32 bytes que se copia al buffer propio del
+   hilo que lo emite (sin locks ni atomics en el camino caliente). Cuando el
+   buffer se llena se vuelca entero al archivo abierto con trace::open.
+ - El nivel se filtra en ejecución (trace::set_level); con el nivel en OFF cada
+   punto de traza cuesta una comparación.
+ - Compilando con -DMESI_TRACE_DISABLED (make TRACE=0) MESI_TRACE no genera código.
+ - trace_decode (src/tools) convierte el archivo al texto que antes iba a std::cout.
+*/
+
+enum class TraceLevel : uint8_t {
+    OFF = 0,
+    INFO = 1,  // transacciones del Bus
+    DEBUG = 2  // además cada acceso a Memoria, write-back de caché y load/store de la MemoryFacade
+};
+
+enum class TraceEvent : uint16_t {
+    MEM_READ_BLOCK,       // arg = bytes, address = base
+    MEM_WRITE_BLOCK,      // arg = bytes, address = base
+    CACHE_WRITEBACK,      // arg = caché, address = bloque, value = bytes
+    FACADE_LOAD,          // arg = PE, address, value = dato
+    FACADE_STORE,         // arg = PE, address, value = dato
+    BUS_GRANT,            // arg = PE ganador, value = PE de inicio de prioridad, address = próximo inicio
+    BUS_BROADCAST,        // arg = PE solicitante, address, value = BusCommand
+    BUS_SNOOP_MODIFIED,   // arg = PE que tenía M
+    BUS_SNOOP_SHARED,     // arg = PE que tenía S/E (sin suministrar el bloque)
+    BUS_DATA_FROM_CACHE,  // arg = PE proveedor
+    BUS_WRITEBACK_DONE,   // arg = bytes
+    BUS_DATA_FROM_MEMORY,
+    BUS_RESULT,           // arg = PE solicitante, value = BusCommand, address = MESI_State de llenado
+    BUS_END,
+    BUS_SNOOP_OWNER,      // arg = PE que tenía M/O y entrega el bloque sin write-back (MOESI)
+    BUS_SNOOP_FORWARD,    // arg = PE que tenía F/E y entrega el bloque limpio (MESIF)
+    COUNT
+};
+
+// Registro binario de tamaño fijo (el formato del archivo es una cabecera + registros)
+struct TraceRecord {
+    uint64_t cycle;   // ciclo del reloj enlazado con trace::bind_clock
+    uint64_t address;
+    uint64_t value;
+    uint16_t event;   // TraceEvent
+    uint16_t thread;  // índice del buffer (hilo) que lo emitió
+    int32_t arg;
+};
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord debe medir 32 bytes");
+
+namespace trace {
+
+constexpr char FILE_MAGIC[8] = {'M', 'E', 'S', 'I', 'T', 'R', 'C', '1'};
+constexpr uint32_t FILE_VERSION = 2; // v2: BUS_RESULT guarda el estado de llenado
+constexpr size_t BUFFER_RECORDS = 4096; // registros por buffer de hilo (128 KB)
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_bytes;
+};
+
+constexpr TraceLevel event_level(TraceEvent event) {
+    return (event == TraceEvent::MEM_READ_BLOCK || event == TraceEvent::MEM_WRITE_BLOCK ||
+            event == TraceEvent::CACHE_WRITEBACK || event == TraceEvent::FACADE_LOAD ||
+            event == TraceEvent::FACADE_STORE) ? TraceLevel::DEBUG : TraceLevel::INFO;
+}
+
+extern std::atomic<uint8_t> g_level;
+
+inline bool enabled(TraceLevel level) {
+    return static_cast<uint8_t>(level) <= g_level.load(std::memory_order_relaxed) &&
+           level != TraceLevel::OFF;
+}
+
+// Abre el archivo de salida y fija el nivel; lanza std::runtime_error si no se puede abrir
+void open(const std::string& path, TraceLevel level);
+// Vuelca los buffers de todos los hilos y cierra el archivo (los emisores deben estar detenidos)
+void close();
+void set_level(TraceLevel level);
+TraceLevel parse_level(const std::string& name); // "off", "info", "debug"
+
+// Reloj del hilo actual (EventScheduler lo enlaza al construirse)
+void bind_clock(const uint64_t* cycle);
+void unbind_clock(const uint64_t* cycle);
+
+void emit(TraceEvent event, int32_t arg, uint64_t address, uint64_t value);
+
+// Texto legible de un registro (el mismo que imprimía el simulador)
+void format_record(const TraceRecord& record, std::ostream& out);
+
+} // namespace trace
+
+#ifdef MESI_TRACE_DISABLED
+// sizeof no evalúa sus operandos: solo evita avisos de variables sin usar
+#define MESI_TRACE(event, arg, address, value) do { (void)sizeof(((void)(event), (void)(arg), (void)(address), (value))); } while (0)
+#else
+#define MESI_TRACE(event, arg, address, value) \
+    do { \
+        if (::trace::enabled(::trace::event_level(event))) { \
+            ::trace::emit(event, static_cast<int32_t>(arg), static_cast<uint64_t>(address), static_cast<uint64_t>(value)); \
+        } \
+    } while (0)
+#endif
+
+#endif // TRACE_H